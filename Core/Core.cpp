@@ -1,4 +1,5 @@
 #include "Core.h"
+#include "Parallel.h"
 
 #if _WIN32
 #include <direct.h>					// for mkdir()
@@ -19,6 +20,15 @@
 
 static FILE *GLogFile = NULL;
 
+static THREAD_LOCAL PrintfHookCallback GPrintfHook = NULL;
+static THREAD_LOCAL void* GPrintfHookContext = NULL;
+
+void appSetPrintfHook(PrintfHookCallback Callback, void* Context)
+{
+	GPrintfHook = Callback;
+	GPrintfHookContext = Context;
+}
+
 void appOpenLogFile(const char *filename)
 {
 	if (GLogFile) fclose(GLogFile);
@@ -38,6 +48,12 @@ void appPrintf(const char *fmt, ...)
 	va_end(argptr);
 	if (len < 0 || len >= ARRAY_COUNT(buf) - 1) appError("appPrintf: buffer overflow");
 
+	if (GPrintfHook)
+	{
+		GPrintfHook(GPrintfHookContext, buf, len);
+		return;
+	}
+
 	fwrite(buf, len, 1, stdout);
 	if (GLogFile) fwrite(buf, len, 1, GLogFile);
 
@@ -87,9 +103,12 @@ void appError(const char *fmt, ...)
 
 
 static char NotifyBuf[512];
+// appNotify() could be called from ParallelFor() tasks, serialize access to NotifyBuf and notify.log
+static CMutex NotifyLock;
 
 void appSetNotifyHeader(const char *fmt, ...)
 {
+	CScopedLock Lock(NotifyLock);
 	if (!fmt)
 	{
 		NotifyBuf[0] = 0;
@@ -111,6 +130,7 @@ void appNotify(const char *fmt, ...)
 	va_end(argptr);
 	if (len < 0 || len >= ARRAY_COUNT(buf) - 1) appError("appNotify: buffer overflow");
 
+	CScopedLock Lock(NotifyLock);
 	fflush(stdout);
 
 	// a bit ugly code: printing the same thing into 3 streams
@@ -141,8 +161,8 @@ void appNotify(const char *fmt, ...)
 }
 
 
-char GErrorHistory[2048];
-static bool WasError = false;
+THREAD_LOCAL char GErrorHistory[2048];
+static THREAD_LOCAL bool WasError = false;
 
 static void LogHistory(const char *part)
 {
@@ -197,8 +217,8 @@ const char *va(const char *format, ...)
 {
 //	guardSlow(va);
 
-	static char buf[VA_BUFSIZE];
-	static int bufPos = 0;
+	static THREAD_LOCAL char buf[VA_BUFSIZE];
+	static THREAD_LOCAL int bufPos = 0;
 	// wrap buffer
 	if (bufPos >= VA_BUFSIZE - VA_GOODSIZE) bufPos = 0;
 
@@ -533,14 +553,22 @@ void appParseResponseFile(const char* filename, int& outArgc, const char**& outA
 			if (*s == '"')
 			{
 				s++; // skip quote
-				// Process quoted strings
+				// Process quoted strings, doubled quote inside is a quote character
 				if (pass) outArgv[argc] = s;
-				while (*s != '"' && *s != 0 && *s != '\n')
+				char* d = s;
+				while (*s != 0 && *s != '\n')
 				{
+					if (*s == '"')
+					{
+						if (s[1] != '"') break;		// closing quote
+						s++;
+					}
+					if (pass) *d = *s;
+					d++;
 					s++;
 				}
-				if (pass) *s = 0;
-				s++; // skip quote
+				if (pass) *d = 0;
+				if (*s) s++; // skip quote
 				argc++;
 			}
 			else
@@ -656,6 +684,21 @@ unsigned appGetFileType(const char *filename)
 	return 0;						// just in case ... (may be, win32 have other file types?)
 }
 
+int64 appGetFileTime(const char *filename)
+{
+	// note: using 64-bit version of stat() because regular one fails on large files
+#if _WIN32
+	struct _stati64 buf;
+	if (_stati64(filename, &buf) == -1)
+		return 0;
+#else
+	struct stat64 buf;
+	if (stat64(filename, &buf) == -1)
+		return 0;
+#endif
+	return buf.st_mtime;
+}
+
 #if !_WIN32
 
 // POSIX version of GetTickCount()
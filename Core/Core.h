@@ -203,6 +203,64 @@ typedef size_t					address_t;
 #endif
 
 
+// Thread-local storage and atomic operations
+
+#if _MSC_VER
+
+#	define THREAD_LOCAL			__declspec(thread)
+
+FORCEINLINE int appInterlockedAdd(volatile int* Addend, int Value)
+{
+	return _InterlockedExchangeAdd((volatile long*)Addend, Value) + Value;
+}
+
+FORCEINLINE size_t appInterlockedAdd(volatile size_t* Addend, size_t Value)
+{
+#ifdef _WIN64
+	return _InterlockedExchangeAdd64((volatile __int64*)Addend, Value) + Value;
+#else
+	return _InterlockedExchangeAdd((volatile long*)Addend, Value) + Value;
+#endif
+}
+
+// Returns previous value of 'Dest'
+FORCEINLINE int appInterlockedCompareExchange(volatile int* Dest, int Exchange, int Comparand)
+{
+	return _InterlockedCompareExchange((volatile long*)Dest, Exchange, Comparand);
+}
+
+#elif __GNUC__
+
+#	define THREAD_LOCAL			__thread
+
+FORCEINLINE int appInterlockedAdd(volatile int* Addend, int Value)
+{
+	return __sync_add_and_fetch(Addend, Value);
+}
+
+FORCEINLINE size_t appInterlockedAdd(volatile size_t* Addend, size_t Value)
+{
+	return __sync_add_and_fetch(Addend, Value);
+}
+
+FORCEINLINE int appInterlockedCompareExchange(volatile int* Dest, int Exchange, int Comparand)
+{
+	return __sync_val_compare_and_swap(Dest, Comparand, Exchange);
+}
+
+#endif // _MSC_VER
+
+FORCEINLINE int appInterlockedIncrement(volatile int* Addend)
+{
+	return appInterlockedAdd(Addend, 1);
+}
+
+FORCEINLINE int appInterlockedDecrement(volatile int* Addend)
+{
+	return appInterlockedAdd(Addend, -1);
+}
+
+
 #define COLOR_ESCAPE	'^'		// could be used for quick location of color-processing code
 
 #define S_BLACK			"^0"
@@ -290,6 +348,11 @@ inline void QSort(const char** array, int count, int (*cmpFunc)(const char**, co
 void appOpenLogFile(const char *filename);
 void appPrintf(const char *fmt, ...);
 
+// Redirect appPrintf() output of the current thread to the callback, NULL restores normal output.
+// Used for keeping console output of parallel tasks in deterministic order. Text is null-terminated.
+typedef void (*PrintfHookCallback)(void* Context, const char* Text, int Len);
+void appSetPrintfHook(PrintfHookCallback Callback, void* Context);
+
 extern bool GIsSwError;
 
 void appError(const char *fmt, ...);
@@ -337,6 +400,8 @@ void appParseResponseFile(const char* filename, int& outArgc, const char**& outA
 // Check file name type. Returns 0 if not exists, FS_FILE if this is a file,
 // and FS_DIR if this is a directory
 unsigned appGetFileType(const char *filename);
+// Returns file modification time, or 0 if file doesn't exist
+int64 appGetFileTime(const char *filename);
 
 
 // Memory management
@@ -506,7 +571,8 @@ long win32ExceptFilter(struct _EXCEPTION_POINTERS *info);
 void appUnwindPrefix(const char *fmt);		// not vararg (will display function name for unguardf only)
 NORETURN void appUnwindThrow(const char *fmt, ...);
 
-extern char GErrorHistory[2048];
+// Each thread has its own error history, see ParallelFor() for passing errors to the main thread
+extern THREAD_LOCAL char GErrorHistory[2048];
 
 #else  // DO_GUARD
 
@@ -56,6 +56,22 @@ struct CStackTrace
 static CStackTrace GAllocationPoints[MAX_ALLOCATION_POINTS];
 static int GNumAllocationPoints = 0;
 
+// Allocation list and allocation points are shared between threads
+static volatile int GDebugMemoryLock = 0;
+
+struct CDebugMemoryLock
+{
+	CDebugMemoryLock()
+	{
+		while (appInterlockedCompareExchange(&GDebugMemoryLock, 1, 0) != 0)
+		{}
+	}
+	~CDebugMemoryLock()
+	{
+		appInterlockedCompareExchange(&GDebugMemoryLock, 0, 1);
+	}
+};
+
 #endif // DEBUG_MEMORY
 
 
@@ -148,6 +164,7 @@ void *appMalloc(int size, int alignment)
 	hdr->blockSize = size;
 
 #if DEBUG_MEMORY
+	CDebugMemoryLock Lock;
 	hdr->Link();
 	// collect a stack trace
 	CStackTrace stack;
@@ -173,10 +190,10 @@ void *appMalloc(int size, int alignment)
 #endif // DEBUG_MEMORY
 
 	// statistics
-	GTotalAllocationSize += size;
-	GTotalAllocationCount++;
+	appInterlockedAdd(&GTotalAllocationSize, size);
+	appInterlockedIncrement(&GTotalAllocationCount);
 #if PROFILE
-	GNumAllocs++;
+	appInterlockedIncrement(&GNumAllocs);
 #endif
 
 	return ptr;
@@ -198,7 +215,10 @@ void* appRealloc(void *ptr, int newSize)
 	assert(hdr->magic == BLOCK_MAGIC);
 	hdr->magic--;		// modify to any value
 #if DEBUG_MEMORY
-	hdr->Unlink();
+	{
+		CDebugMemoryLock Lock;
+		hdr->Unlink();
+	}
 #endif
 
 	int alignment = hdr->align + 1;
@@ -216,11 +236,11 @@ void* appRealloc(void *ptr, int newSize)
 
 	// statistics: we're allocating a new block with appMalloc, which counts statistics
 	// for this allocation, so only eliminate statistics from old memory block here
-	GTotalAllocationSize -= oldSize;
-	GTotalAllocationCount--;
+	appInterlockedAdd(&GTotalAllocationSize, -(size_t)oldSize);
+	appInterlockedDecrement(&GTotalAllocationCount);
 
 #if PROFILE
-	GNumAllocs++;
+	appInterlockedIncrement(&GNumAllocs);
 #endif
 
 	return newData;
@@ -240,13 +260,16 @@ void appFree(void *ptr)
 	assert(hdr->magic == BLOCK_MAGIC);
 	hdr->magic--;		// modify to any value
 #if DEBUG_MEMORY
-	hdr->Unlink();
+	{
+		CDebugMemoryLock Lock;
+		hdr->Unlink();
+	}
 	memset(ptr, FREE_BLOCK, hdr->blockSize);
 #endif
 
 	// statistics
-	GTotalAllocationSize -= hdr->blockSize;
-	GTotalAllocationCount--;
+	appInterlockedAdd(&GTotalAllocationSize, -(size_t)hdr->blockSize);
+	appInterlockedDecrement(&GTotalAllocationCount);
 
 	free(block);
 
@@ -285,7 +308,7 @@ void CMemoryChain::operator delete(void *ptr)
 	{
 		// free memory block
 		next = curr->next;
-		free(curr);				//!! deallocate
+		appFree(curr);
 	}
 	unguard;
 }
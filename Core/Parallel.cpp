@@ -0,0 +1,448 @@
+#include "Core.h"
+#include "Parallel.h"
+
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN			// exclude rarely-used services from windown headers
+#include <windows.h>
+#else
+#include <unistd.h>					// sysconf(), usleep()
+#include <spawn.h>					// posix_spawn()
+#include <sys/wait.h>				// waitpid()
+#include <pthread.h>
+#include <semaphore.h>
+extern char** environ;
+#endif
+
+#define MAX_THREADS			64
+
+
+/*-----------------------------------------------------------------------------
+	Child processes
+-----------------------------------------------------------------------------*/
+
+CChildProcess::CChildProcess()
+:	Handle(0)
+,	ExitCode(-1)
+{}
+
+CChildProcess::~CChildProcess()
+{
+	// Wait for process termination, we shouldn't leave zombie processes
+	while (IsRunning())
+		appSleep(10);
+}
+
+#if _WIN32
+
+bool CChildProcess::Start(int argc, const char* const* argv)
+{
+	guard(CChildProcess::Start);
+
+	assert(!Handle);
+
+	char ExeName[MAX_PATH];
+	if (!GetModuleFileName(NULL, ARRAY_ARG(ExeName)))
+		return false;
+
+	// Build command line, quote every argument
+	int CmdLen = strlen(ExeName) + 3;
+	for (int i = 0; i < argc; i++)
+		CmdLen += strlen(argv[i]) + 3;
+	char* CmdLine = (char*)appMalloc(CmdLen + 1);
+	char* s = CmdLine;
+	s += sprintf(s, "\"%s\"", ExeName);
+	for (int i = 0; i < argc; i++)
+		s += sprintf(s, " \"%s\"", argv[i]);
+
+	STARTUPINFO si;
+	PROCESS_INFORMATION pi;
+	memset(&si, 0, sizeof(si));
+	si.cb = sizeof(si);
+	BOOL result = CreateProcess(NULL, CmdLine, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+	appFree(CmdLine);
+	if (!result)
+		return false;
+
+	CloseHandle(pi.hThread);
+	Handle = (address_t)pi.hProcess;
+	ExitCode = -1;
+	return true;
+
+	unguard;
+}
+
+bool CChildProcess::IsRunning()
+{
+	if (!Handle) return false;
+
+	HANDLE hProcess = (HANDLE)Handle;
+	if (WaitForSingleObject(hProcess, 0) == WAIT_TIMEOUT)
+		return true;
+
+	DWORD Code = (DWORD)-1;
+	GetExitCodeProcess(hProcess, &Code);
+	CloseHandle(hProcess);
+	ExitCode = (int)Code;
+	Handle = 0;
+	return false;
+}
+
+int appGetNumCores()
+{
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return max((int)si.dwNumberOfProcessors, 1);
+}
+
+void appSleep(int msec)
+{
+	Sleep(msec);
+}
+
+#else // _WIN32
+
+bool CChildProcess::Start(int argc, const char* const* argv)
+{
+	guard(CChildProcess::Start);
+
+	assert(!Handle);
+
+	// Use "/proc/self/exe" instead of argv[0], because umodel could be started from PATH
+	static const char ExeName[] = "/proc/self/exe";
+	const char** Args = new const char*[argc + 2];
+	Args[0] = ExeName;
+	for (int i = 0; i < argc; i++)
+		Args[i + 1] = argv[i];
+	Args[argc + 1] = NULL;
+
+	// Flush output streams, so parent's buffered text will not be duplicated by child process
+	fflush(stdout);
+	fflush(stderr);
+
+	pid_t pid;
+	int result = posix_spawn(&pid, ExeName, NULL, NULL, const_cast<char* const*>(Args), environ);
+	delete[] Args;
+	if (result != 0)
+		return false;
+
+	Handle = (address_t)pid;
+	ExitCode = -1;
+	return true;
+
+	unguard;
+}
+
+bool CChildProcess::IsRunning()
+{
+	if (!Handle) return false;
+
+	int status;
+	pid_t result = waitpid((pid_t)Handle, &status, WNOHANG);
+	if (result == 0)
+		return true;
+
+	ExitCode = (result > 0 && WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+	Handle = 0;
+	return false;
+}
+
+int appGetNumCores()
+{
+	return max((int)sysconf(_SC_NPROCESSORS_ONLN), 1);
+}
+
+void appSleep(int msec)
+{
+	usleep(msec * 1000);
+}
+
+#endif // _WIN32
+
+
+/*-----------------------------------------------------------------------------
+	Low-level threading primitives
+-----------------------------------------------------------------------------*/
+
+typedef void (*ThreadFunc_t)();
+
+#if _WIN32
+
+CMutex::CMutex()
+{
+	CRITICAL_SECTION* cs = new CRITICAL_SECTION;
+	InitializeCriticalSection(cs);
+	Handle = cs;
+}
+
+CMutex::~CMutex()
+{
+	CRITICAL_SECTION* cs = (CRITICAL_SECTION*)Handle;
+	DeleteCriticalSection(cs);
+	delete cs;
+}
+
+void CMutex::Lock()
+{
+	EnterCriticalSection((CRITICAL_SECTION*)Handle);
+}
+
+void CMutex::Unlock()
+{
+	LeaveCriticalSection((CRITICAL_SECTION*)Handle);
+}
+
+struct CSemaphore
+{
+	HANDLE			Handle;
+
+	CSemaphore()
+	{
+		Handle = CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL);
+	}
+	void Post(int Count = 1)
+	{
+		ReleaseSemaphore(Handle, Count, NULL);
+	}
+	void Wait()
+	{
+		WaitForSingleObject(Handle, INFINITE);
+	}
+};
+
+static DWORD WINAPI ThreadStub(LPVOID Param)
+{
+	((ThreadFunc_t)Param)();
+	return 0;
+}
+
+static bool StartThread(ThreadFunc_t Func)
+{
+	HANDLE hThread = CreateThread(NULL, 0, ThreadStub, (LPVOID)Func, 0, NULL);
+	if (!hThread) return false;
+	CloseHandle(hThread);
+	return true;
+}
+
+#else // _WIN32
+
+CMutex::CMutex()
+{
+	pthread_mutex_t* m = new pthread_mutex_t;
+	pthread_mutex_init(m, NULL);
+	Handle = m;
+}
+
+CMutex::~CMutex()
+{
+	pthread_mutex_t* m = (pthread_mutex_t*)Handle;
+	pthread_mutex_destroy(m);
+	delete m;
+}
+
+void CMutex::Lock()
+{
+	pthread_mutex_lock((pthread_mutex_t*)Handle);
+}
+
+void CMutex::Unlock()
+{
+	pthread_mutex_unlock((pthread_mutex_t*)Handle);
+}
+
+struct CSemaphore
+{
+	sem_t			Handle;
+
+	CSemaphore()
+	{
+		sem_init(&Handle, 0, 0);
+	}
+	void Post(int Count = 1)
+	{
+		for (int i = 0; i < Count; i++)
+			sem_post(&Handle);
+	}
+	void Wait()
+	{
+		while (sem_wait(&Handle) != 0)
+		{}	// interrupted by signal
+	}
+};
+
+static void* ThreadStub(void* Param)
+{
+	((ThreadFunc_t)Param)();
+	return NULL;
+}
+
+static bool StartThread(ThreadFunc_t Func)
+{
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, ThreadStub, (void*)Func) != 0)
+		return false;
+	pthread_detach(thread);
+	return true;
+}
+
+#endif // _WIN32
+
+
+/*-----------------------------------------------------------------------------
+	Thread pool
+-----------------------------------------------------------------------------*/
+
+struct CParallelJob
+{
+	ParallelForCallback Callback;
+	void*			Context;
+	int				Count;
+	volatile int	NextIndex;
+	volatile int	NumActiveWorkers;	// number of workers which should check in before job could be released
+	volatile int	ErrorFlag;
+	char			ErrorText[2048];
+};
+
+static int GNumThreads = 0;				// 0 = not initialized
+static int GNumPoolThreads = 0;			// number of started worker threads
+static CParallelJob* GCurrentJob = NULL;
+static CSemaphore* GWorkSemaphore = NULL;
+static CSemaphore* GDoneSemaphore = NULL;
+static CMutex* GJobMutex = NULL;
+
+// Non-zero when ParallelFor is executed by this thread, or when this is a worker thread
+static THREAD_LOCAL int GParallelDepth = 0;
+
+void appSetNumThreads(int Count)
+{
+	if (GNumPoolThreads)
+	{
+		appPrintf("WARNING: thread pool is already running, ignoring new thread count %d\n", Count);
+		return;
+	}
+	if (Count <= 0) Count = appGetNumCores();
+	GNumThreads = bound(Count, 1, MAX_THREADS);
+}
+
+int appGetNumThreads()
+{
+	if (!GNumThreads) appSetNumThreads(0);
+	return GNumThreads;
+}
+
+bool appIsWorkerThread()
+{
+	return GParallelDepth > 0;
+}
+
+static void RunJobItems(CParallelJob* Job)
+{
+	while (true)
+	{
+		int Index = appInterlockedIncrement(&Job->NextIndex) - 1;
+		if (Index >= Job->Count) break;
+		if (Job->ErrorFlag) continue;		// skip remaining items after error
+
+#if DO_GUARD
+		TRY
+		{
+#endif
+			Job->Callback(Job->Context, Index);
+#if DO_GUARD
+		}
+		CATCH_CRASH
+		{
+			// Remember the first error only
+			if (appInterlockedIncrement(&Job->ErrorFlag) == 1)
+				appStrncpyz(Job->ErrorText, GErrorHistory, ARRAY_COUNT(Job->ErrorText));
+			GErrorHistory[0] = 0;
+		}
+#endif // DO_GUARD
+	}
+}
+
+static void WorkerThread()
+{
+	GParallelDepth = 1;
+	while (true)
+	{
+		GWorkSemaphore->Wait();
+		CParallelJob* Job = GCurrentJob;
+		RunJobItems(Job);
+		if (appInterlockedDecrement(&Job->NumActiveWorkers) == 0)
+			GDoneSemaphore->Post();
+	}
+}
+
+static void StartThreadPool()
+{
+	GWorkSemaphore = new CSemaphore;
+	GDoneSemaphore = new CSemaphore;
+	GJobMutex = new CMutex;
+	for (int i = 0; i < GNumThreads - 1; i++)
+	{
+		if (!StartThread(WorkerThread)) break;
+		GNumPoolThreads++;
+	}
+	if (!GNumPoolThreads)
+	{
+		// Failed to start any thread, work in single-threaded mode
+		GNumThreads = 1;
+	}
+}
+
+void ParallelFor(int Count, ParallelForCallback Callback, void* Context)
+{
+	guard(ParallelFor);
+
+	if (Count <= 0) return;
+
+	if (Count == 1 || GParallelDepth || appGetNumThreads() == 1)
+	{
+		// Execute serially
+		for (int i = 0; i < Count; i++)
+			Callback(Context, i);
+		return;
+	}
+
+	if (!GNumPoolThreads)
+	{
+		StartThreadPool();
+		if (!GNumPoolThreads)
+		{
+			for (int i = 0; i < Count; i++)
+				Callback(Context, i);
+			return;
+		}
+	}
+
+	CScopedLock Lock(*GJobMutex);		// allow only one parallel job at time
+
+	CParallelJob Job;
+	Job.Callback = Callback;
+	Job.Context = Context;
+	Job.Count = Count;
+	Job.NextIndex = 0;
+	Job.ErrorFlag = 0;
+	Job.ErrorText[0] = 0;
+	// Wake up only as many workers as there are items for them
+	int NumWorkers = min(GNumPoolThreads, Count - 1);
+	Job.NumActiveWorkers = NumWorkers;
+
+	GCurrentJob = &Job;
+	GWorkSemaphore->Post(NumWorkers);
+
+	GParallelDepth++;
+	RunJobItems(&Job);
+	GParallelDepth--;
+
+	// Wait for all woken workers, they're referencing the Job structure
+	GDoneSemaphore->Wait();
+	GCurrentJob = NULL;
+
+	if (Job.ErrorFlag)
+	{
+		appError("%s", Job.ErrorText);
+	}
+
+	unguard;
+}
@@ -0,0 +1,106 @@
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+/*-----------------------------------------------------------------------------
+	Child processes
+-----------------------------------------------------------------------------*/
+
+// Wrapper for another instance of the current executable. Used to distribute
+// work which depends on global state (object system, exporter state etc) between
+// several independent processes.
+class CChildProcess
+{
+public:
+	CChildProcess();
+	~CChildProcess();
+
+	// Launch a copy of the current executable. 'argv' should not include executable
+	// name, it is added automatically.
+	bool Start(int argc, const char* const* argv);
+	// Returns 'true' when process is still running. When process has finished, its
+	// exit code will be available with GetExitCode().
+	bool IsRunning();
+
+	int GetExitCode() const
+	{
+		return ExitCode;
+	}
+
+private:
+	address_t		Handle;
+	int				ExitCode;
+};
+
+// Number of logical CPU cores
+int appGetNumCores();
+
+void appSleep(int msec);
+
+
+/*-----------------------------------------------------------------------------
+	Synchronization
+-----------------------------------------------------------------------------*/
+
+class CMutex
+{
+public:
+	CMutex();
+	~CMutex();
+
+	void Lock();
+	void Unlock();
+
+private:
+	void*			Handle;
+
+	// disable copying
+	CMutex(const CMutex&);
+	CMutex& operator=(const CMutex&);
+};
+
+class CScopedLock
+{
+public:
+	CScopedLock(CMutex& InMutex)
+	:	Mutex(InMutex)
+	{
+		Mutex.Lock();
+	}
+	~CScopedLock()
+	{
+		Mutex.Unlock();
+	}
+
+private:
+	CMutex&			Mutex;
+};
+
+
+/*-----------------------------------------------------------------------------
+	Thread pool
+-----------------------------------------------------------------------------*/
+
+// Set number of threads used by ParallelFor(), including the calling thread. Value 0
+// means "number of CPU cores", value 1 disables multithreading. Should be called before
+// the first use of ParallelFor().
+void appSetNumThreads(int Count);
+int appGetNumThreads();
+
+// Returns 'true' when called from the thread pool's worker
+bool appIsWorkerThread();
+
+typedef void (*ParallelForCallback)(void* Context, int Index);
+
+// Execute Callback for every index in [0, Count) range using the thread pool, the calling
+// thread participates in work too. Returns when all items are processed. An error in worker
+// thread is passed to the calling thread with appError(). Nested calls are executed serially.
+void ParallelFor(int Count, ParallelForCallback Callback, void* Context);
+
+// Wrapper for using ParallelFor() with lambdas
+template<typename F>
+FORCEINLINE void ParallelFor(int Count, const F& Func)
+{
+	ParallelFor(Count, [](void* Context, int Index) { (*(const F*)Context)(Index); }, (void*)&Func);
+}
+
+#endif // __PARALLEL_H__
@@ -85,18 +85,38 @@ struct BufferData
 		FLOAT = 5126
 	};
 
+	// Buffers are combined into a few bufferViews by their purpose, to keep json compact
+	enum EViewType
+	{
+		VIEW_INDEX,
+		VIEW_VERTEX,						// vertex attributes, combined by item size (byteStride)
+		VIEW_MATRIX,
+		VIEW_ANIM_TIME,
+		VIEW_ANIM_TRANSLATION,
+		VIEW_ANIM_ROTATION,
+	};
+
 	byte* Data;
 	int DataSize;
 	int ComponentType;
 	int Count;
+	int ItemSize;
 	const char* Type;
 	bool bNormalized;
+	EViewType ViewType;
+
+	// Placement of data in the output buffer, computed by BuildBufferViews()
+	int ViewIndex;
+	int ViewOffset;
+
+	// Used for finding identical buffers
+	uint32 Hash;
+	int HashNext;
 
 	// Data for filling buffer
 	byte* FillPtr;
 #if MAX_DEBUG
 	int FillCount;
-	int ItemSize;
 #endif
 
 	FString BoundsMin;
@@ -112,9 +132,11 @@ struct BufferData
 		if (Data) appFree(Data);
 	}
 
-	void Setup(int InCount, const char* InType, int InComponentType, int InItemSize, bool InNormalized = false)
+	void Setup(EViewType InViewType, int InCount, const char* InType, int InComponentType, int InItemSize, bool InNormalized = false)
 	{
+		ViewType = InViewType;
 		Count = InCount;
+		ItemSize = InItemSize;
 		Type = InType;
 		bNormalized = InNormalized;
 		ComponentType = InComponentType;
@@ -123,11 +145,12 @@ struct BufferData
 		DataSize = Align(DataSize, 4);
 		// Use aligned alloc for CVec4
 		Data = (byte*) appMalloc(DataSize, 16);
+		// Zero the alignment padding, so buffers could be compared with memcmp
+		memset(Data + InCount * InItemSize, 0, DataSize - InCount * InItemSize);
 
 		FillPtr = Data;
 #if MAX_DEBUG
 		FillCount = 0;
-		ItemSize = InItemSize;
 #endif
 	}
 
@@ -142,11 +165,23 @@ struct BufferData
 		FillPtr += sizeof(T);
 	}
 
+	uint32 ComputeHash() const
+	{
+		// FNV-1a over 32-bit words, DataSize is always aligned by 4
+		uint32 h = 2166136261u ^ Count;
+		const uint32* p = (const uint32*)Data;
+		for (int i = 0; i < DataSize / 4; i++)
+		{
+			h = (h ^ p[i]) * 16777619u;
+		}
+		return h;
+	}
+
 	bool IsSameAs(const BufferData& Other) const
 	{
 		// Compare metadata
 		if (Count != Other.Count || strcmp(Type, Other.Type) != 0 || ComponentType != Other.ComponentType ||
-			bNormalized != Other.bNormalized || DataSize != Other.DataSize)
+			bNormalized != Other.bNormalized || DataSize != Other.DataSize || ViewType != Other.ViewType)
 		{
 			return false;
 		}
@@ -155,13 +190,29 @@ struct BufferData
 	}
 };
 
+struct BufferView
+{
+	int ViewType;
+	int ByteStride;							// 0 for non-vertex data
+	int Offset;
+	int Length;
+};
+
+#define DATA_HASH_SIZE		16384
+
 struct GLTFExportContext
 {
 	const char* MeshName;
 	const CSkeletalMesh* SkelMesh;
 	const CStaticMesh* StatMesh;
+	bool bBinary;							// writing .glb file
 
 	TArray<BufferData> Data;
+	TArray<BufferView> Views;
+	int BufferLength;
+
+	// Hash of data blocks which could be shared, see GetFinalIndexForLastBlock()
+	TArray<int> DataHashHeads;
 
 	GLTFExportContext()
 	{
@@ -173,25 +224,69 @@ struct GLTFExportContext
 		return SkelMesh != NULL;
 	}
 
-	// Compare last item of Data with other itest starting with FirstDataIndex, drop the data
-	// if same data block found and return its index. If no matching data were found, return
+	// Compare last item of Data with other items previously passed to this function, drop the
+	// data if same data block found and return its index. If no matching data were found, return
 	// index of that last data.
-	int GetFinalIndexForLastBlock(int FirstDataIndex)
+	int GetFinalIndexForLastBlock()
 	{
+		if (!DataHashHeads.Num())
+		{
+			DataHashHeads.Init(-1, DATA_HASH_SIZE);
+		}
+
 		int LastIndex = Data.Num()-1;
-		const BufferData& LastData = Data[LastIndex];
-		for (int index = FirstDataIndex; index < LastIndex; index++)
+		BufferData& LastData = Data[LastIndex];
+		uint32 Hash = LastData.ComputeHash();
+		int& Head = DataHashHeads[Hash & (DATA_HASH_SIZE - 1)];
+		for (int index = Head; index >= 0; index = Data[index].HashNext)
 		{
-			if (LastData.IsSameAs(Data[index]))
+			if (Data[index].Hash == Hash && LastData.IsSameAs(Data[index]))
 			{
 				// Found matching data
 				Data.RemoveAt(LastIndex);
 				return index;
 			}
 		}
-		// Not found
+		// Not found, add to hash
+		LastData.Hash = Hash;
+		LastData.HashNext = Head;
+		Head = LastIndex;
 		return LastIndex;
 	}
+
+	// Assign every data block to a bufferView. Blocks are placed into the binary buffer view by view.
+	void BuildBufferViews()
+	{
+		Views.Empty();
+		for (int i = 0; i < Data.Num(); i++)
+		{
+			BufferData& B = Data[i];
+			int Stride = (B.ViewType == BufferData::VIEW_VERTEX) ? B.ItemSize : 0;
+			int ViewIndex;
+			for (ViewIndex = 0; ViewIndex < Views.Num(); ViewIndex++)
+			{
+				if (Views[ViewIndex].ViewType == B.ViewType && Views[ViewIndex].ByteStride == Stride)
+					break;
+			}
+			if (ViewIndex == Views.Num())
+			{
+				BufferView* V = new (Views) BufferView;
+				V->ViewType = B.ViewType;
+				V->ByteStride = Stride;
+				V->Length = 0;
+			}
+			BufferView& V = Views[ViewIndex];
+			B.ViewIndex = ViewIndex;
+			B.ViewOffset = V.Length;
+			V.Length += B.DataSize;
+		}
+		BufferLength = 0;
+		for (int i = 0; i < Views.Num(); i++)
+		{
+			Views[i].Offset = BufferLength;
+			BufferLength += Views[i].Length;
+		}
+	}
 };
 
 #define VERT(n)		*OffsetPointer(Verts, (n) * VertexSize)
@@ -255,27 +350,27 @@ static void ExportSection(GLTFExportContext& Context, const CBaseMeshLod& Lod, c
 	BufferData* BonesBuf = NULL;
 	BufferData* WeightsBuf = NULL;
 
-	PositionBuf.Setup(numLocalVerts, "VEC3", BufferData::FLOAT, sizeof(CVec3));
-	NormalBuf.Setup(numLocalVerts, "VEC3", BufferData::FLOAT, sizeof(CVec3));
-	TangentBuf.Setup(numLocalVerts, "VEC4", BufferData::FLOAT, sizeof(CVec4));
+	PositionBuf.Setup(BufferData::VIEW_VERTEX, numLocalVerts, "VEC3", BufferData::FLOAT, sizeof(CVec3));
+	NormalBuf.Setup(BufferData::VIEW_VERTEX, numLocalVerts, "VEC3", BufferData::FLOAT, sizeof(CVec3));
+	TangentBuf.Setup(BufferData::VIEW_VERTEX, numLocalVerts, "VEC4", BufferData::FLOAT, sizeof(CVec4));
 	for (int i = 0; i < Lod.NumTexCoords; i++)
 	{
 		UVBuf[i] = &Context.Data[UVBufIndex[i]];
-		UVBuf[i]->Setup(numLocalVerts, "VEC2", BufferData::FLOAT, sizeof(CMeshUVFloat));
+		UVBuf[i]->Setup(BufferData::VIEW_VERTEX, numLocalVerts, "VEC2", BufferData::FLOAT, sizeof(CMeshUVFloat));
 	}
 
 	if (Lod.VertexColors)
 	{
 		ColorBuf = &Context.Data[ColorBufIndex];
-		ColorBuf->Setup(numLocalVerts, "VEC4", BufferData::UNSIGNED_BYTE, 4, /*InNormalized=*/ true);
+		ColorBuf->Setup(BufferData::VIEW_VERTEX, numLocalVerts, "VEC4", BufferData::UNSIGNED_BYTE, 4, /*InNormalized=*/ true);
 	}
 
 	if (Context.IsSkeletal())
 	{
 		BonesBuf = &Context.Data[BonesBufIndex];
 		WeightsBuf = &Context.Data[WeightsBufIndex];
-		BonesBuf->Setup(numLocalVerts, "VEC4", BufferData::UNSIGNED_SHORT, sizeof(uint16)*4);
-		WeightsBuf->Setup(numLocalVerts, "VEC4", BufferData::UNSIGNED_BYTE, sizeof(uint32), /*InNormalized=*/ true);
+		BonesBuf->Setup(BufferData::VIEW_VERTEX, numLocalVerts, "VEC4", BufferData::UNSIGNED_SHORT, sizeof(uint16)*4);
+		WeightsBuf->Setup(BufferData::VIEW_VERTEX, numLocalVerts, "VEC4", BufferData::UNSIGNED_BYTE, sizeof(uint32), /*InNormalized=*/ true);
 	}
 
 	// Prepare and build indices
@@ -289,7 +384,7 @@ static void ExportSection(GLTFExportContext& Context, const CBaseMeshLod& Lod, c
 
 	if (numLocalVerts <= 65536)
 	{
-		IndexBuf.Setup(numLocalIndices, "SCALAR", BufferData::UNSIGNED_SHORT, sizeof(uint16));
+		IndexBuf.Setup(BufferData::VIEW_INDEX, numLocalIndices, "SCALAR", BufferData::UNSIGNED_SHORT, sizeof(uint16));
 		for (int idx = 0; idx < numLocalIndices; idx++)
 		{
 			IndexBuf.Put<uint16>(indexRemap[localIndices[idx]]);
@@ -297,7 +392,7 @@ static void ExportSection(GLTFExportContext& Context, const CBaseMeshLod& Lod, c
 	}
 	else
 	{
-		IndexBuf.Setup(numLocalIndices, "SCALAR", BufferData::UNSIGNED_INT, sizeof(uint32));
+		IndexBuf.Setup(BufferData::VIEW_INDEX, numLocalIndices, "SCALAR", BufferData::UNSIGNED_INT, sizeof(uint32));
 		for (int idx = 0; idx < numLocalIndices; idx++)
 		{
 			IndexBuf.Put<uint32>(indexRemap[localIndices[idx]]);
@@ -487,7 +582,7 @@ static void ExportSkinData(GLTFExportContext& Context, const CSkelMeshLod& Lod,
 
 	int MatrixBufIndex = Context.Data.AddZeroed();
 	BufferData& MatrixBuf = Context.Data[MatrixBufIndex];
-	MatrixBuf.Setup(numBones, "MAT4", BufferData::FLOAT, sizeof(CMat4));
+	MatrixBuf.Setup(BufferData::VIEW_MATRIX, numBones, "MAT4", BufferData::FLOAT, sizeof(CMat4));
 
 	Ar.Printf(
 		"  \"nodes\" : [\n"
@@ -631,46 +726,32 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 		}
 	}
 
-	Ar.Printf(
-		"  \"animations\" : [\n"
-	);
+	struct AnimSampler
+	{
+		enum ChannelType
+		{
+			TRANSLATION,
+			ROTATION
+		};
+
+		int BoneNodeIndex;
+		ChannelType Type;
+		const CAnimTrack* Track;
+	};
 
-	int FirstDataIndex = Context.Data.Num();
+	TArray<AnimSampler> Samplers;
+	Samplers.Empty(AnimBones.Num() * 2);
+
+	int NumExportedAnims = 0;
 
 	// Iterate over all animations
+	CScopedAnimSetTracks Tracks(Anim);
 	for (int SeqIndex = 0; SeqIndex < Anim->Sequences.Num(); SeqIndex++)
 	{
-		const CAnimSequence &Seq = *Anim->Sequences[SeqIndex];
-
-		Ar.Printf(
-			"    {\n"
-			"      \"name\" : \"%s\",\n",
-			*Seq.Name
-		);
-
-		struct AnimSampler
-		{
-			enum ChannelType
-			{
-				TRANSLATION,
-				ROTATION
-			};
+		const CAnimSequence &Seq = Tracks.Get(SeqIndex);
 
-			int BoneNodeIndex;
-			ChannelType Type;
-			const CAnimTrack* Track;
-		};
-
-		TArray<AnimSampler> Samplers;
+		// Prepare samplers. Tracks without keys (e.g. for AnimRotationOnly) are dropped.
 		Samplers.Empty(AnimBones.Num() * 2);
-
-		//!! Optimization:
-		//!! 1. there will be missing tracks (AnimRotationOnly etc) - drop such samplers
-		//!! 2. store all time tracks in a single BufferView, all rotation tracks in another, and all position track in 3rd one - this
-		//!!    will reduce amount of BufferViews in json text (combine them by data type)
-
-		// Prepare channels array
-		Ar.Printf("      \"channels\" : [\n");
 		for (int BoneIndex = 0; BoneIndex < AnimBones.Num(); BoneIndex++)
 		{
 			int MeshBoneIndex = AnimBones[BoneIndex];
@@ -678,31 +759,47 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 
 			const CAnimTrack* Track = Seq.Tracks[AnimBoneIndex];
 
-			int TranslationSamplerIndex = Samplers.Num();
-			AnimSampler* Sampler = new (Samplers) AnimSampler;
-			Sampler->Type = AnimSampler::TRANSLATION;
-			Sampler->BoneNodeIndex = MeshBoneIndex + FIRST_BONE_NODE;
-			Sampler->Track = Track;
+			if (Track->KeyPos.Num())
+			{
+				AnimSampler* Sampler = new (Samplers) AnimSampler;
+				Sampler->Type = AnimSampler::TRANSLATION;
+				Sampler->BoneNodeIndex = MeshBoneIndex + FIRST_BONE_NODE;
+				Sampler->Track = Track;
+			}
+			if (Track->KeyQuat.Num())
+			{
+				AnimSampler* Sampler = new (Samplers) AnimSampler;
+				Sampler->Type = AnimSampler::ROTATION;
+				Sampler->BoneNodeIndex = MeshBoneIndex + FIRST_BONE_NODE;
+				Sampler->Track = Track;
+			}
+		}
+		// glTF requires at least one channel in animation
+		if (!Samplers.Num()) continue;
 
-			int RotationSamplerIndex = Samplers.Num();
-			Sampler = new (Samplers) AnimSampler;
-			Sampler->Type = AnimSampler::ROTATION;
-			Sampler->BoneNodeIndex = MeshBoneIndex + FIRST_BONE_NODE;
-			Sampler->Track = Track;
+		Ar.Printf(
+			"%s"
+			"    {\n"
+			"      \"name\" : \"%s\",\n",
+			NumExportedAnims ? ",\n" : "  \"animations\" : [\n",
+			*Seq.Name
+		);
+		NumExportedAnims++;
 
-			// Print glTF information. Not using usual formatting here to make output a little bit more compact.
-			Ar.Printf(
-				"        { \"sampler\" : %d, \"target\" : { \"node\" : %d, \"path\" : \"%s\" } },\n",
-				TranslationSamplerIndex, MeshBoneIndex + FIRST_BONE_NODE, "translation"
-			);
+		// Write channels. Not using usual formatting here to make output a little bit more compact.
+		Ar.Printf("      \"channels\" : [\n");
+		for (int SamplerIndex = 0; SamplerIndex < Samplers.Num(); SamplerIndex++)
+		{
+			const AnimSampler& Sampler = Samplers[SamplerIndex];
 			Ar.Printf(
 				"        { \"sampler\" : %d, \"target\" : { \"node\" : %d, \"path\" : \"%s\" } }%s\n",
-				RotationSamplerIndex, MeshBoneIndex + FIRST_BONE_NODE, "rotation", BoneIndex == AnimBones.Num()-1 ? "" : ","
+				SamplerIndex, Sampler.BoneNodeIndex, Sampler.Type == AnimSampler::TRANSLATION ? "translation" : "rotation",
+				SamplerIndex == Samplers.Num()-1 ? "" : ","
 			);
 		}
 		Ar.Printf("      ],\n");
 
-		// Prepare samplers
+		// Write samplers
 		Ar.Printf("      \"samplers\" : [\n");
 		for (int SamplerIndex = 0; SamplerIndex < Samplers.Num(); SamplerIndex++)
 		{
@@ -715,11 +812,11 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 				// For this situation, use track's time array
 				TimeArray = &Sampler.Track->KeyTime;
 			}
-			int NumKeys = Sampler.Type == (AnimSampler::TRANSLATION) ? Sampler.Track->KeyPos.Num() : Sampler.Track->KeyQuat.Num();
+			int NumKeys = (Sampler.Type == AnimSampler::TRANSLATION) ? Sampler.Track->KeyPos.Num() : Sampler.Track->KeyQuat.Num();
 
 			int TimeBufIndex = Context.Data.AddZeroed();
 			BufferData& TimeBuf = Context.Data[TimeBufIndex];
-			TimeBuf.Setup(NumKeys, "SCALAR", BufferData::FLOAT, sizeof(float));
+			TimeBuf.Setup(BufferData::VIEW_ANIM_TIME, NumKeys, "SCALAR", BufferData::FLOAT, sizeof(float));
 
 			float RateScale = 1.0f / Seq.Rate;
 			float LastFrameTime = 0;
@@ -747,7 +844,7 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 			TimeBuf.BoundsMax = buf;
 
 			// Try to reuse TimeBuf from previous tracks
-			TimeBufIndex = Context.GetFinalIndexForLastBlock(FirstDataIndex);
+			TimeBufIndex = Context.GetFinalIndexForLastBlock();
 
 			// Prepare data
 			int DataBufIndex = Context.Data.AddZeroed();
@@ -755,7 +852,7 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 			if (Sampler.Type == AnimSampler::TRANSLATION)
 			{
 				// Translation track
-				DataBuf.Setup(NumKeys, "VEC3", BufferData::FLOAT, sizeof(CVec3));
+				DataBuf.Setup(BufferData::VIEW_ANIM_TRANSLATION, NumKeys, "VEC3", BufferData::FLOAT, sizeof(CVec3));
 				for (int i = 0; i < NumKeys; i++)
 				{
 					CVec3 Pos = Sampler.Track->KeyPos[i];
@@ -766,7 +863,7 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 			else
 			{
 				// Rotation track
-				DataBuf.Setup(NumKeys, "VEC4", BufferData::FLOAT, sizeof(CQuat));
+				DataBuf.Setup(BufferData::VIEW_ANIM_ROTATION, NumKeys, "VEC4", BufferData::FLOAT, sizeof(CQuat));
 				for (int i = 0; i < NumKeys; i++)
 				{
 					CQuat Rot = Sampler.Track->KeyQuat[i];
@@ -780,7 +877,7 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 			}
 
 			// Try to reuse data block as well
-			DataBufIndex = Context.GetFinalIndexForLastBlock(FirstDataIndex);
+			DataBufIndex = Context.GetFinalIndexForLastBlock();
 
 			// Write glTF info
 			Ar.Printf(
@@ -790,15 +887,18 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 		}
 		Ar.Printf("      ]\n");
 
-		Ar.Printf("    }%s\n", SeqIndex == Anim->Sequences.Num()-1 ? "" : ",");
+		Ar.Printf("    }");
 	}
 
-	Ar.Printf("  ],\n");
+	if (NumExportedAnims)
+	{
+		Ar.Printf("\n  ],\n");
+	}
 
 	unguard;
 }
 
-static void ExportMeshLod(GLTFExportContext& Context, const CBaseMeshLod& Lod, const CMeshVertex* Verts, FArchive& Ar, FArchive& Ar2)
+static void ExportMeshLod(GLTFExportContext& Context, const CBaseMeshLod& Lod, const CMeshVertex* Verts, FArchive& Ar)
 {
 	guard(ExportMeshLod);
 
@@ -874,47 +974,70 @@ static void ExportMeshLod(GLTFExportContext& Context, const CBaseMeshLod& Lod, c
 	}
 
 	// Write buffers
-	int bufferLength = 0;
-	for (int i = 0; i < Context.Data.Num(); i++)
+	Context.BuildBufferViews();
+
+	if (Context.bBinary)
 	{
-		bufferLength += Context.Data[i].DataSize;
+		// glb: the buffer is stored in BIN chunk of the same file
+		Ar.Printf(
+			"  \"buffers\" : [\n"
+			"    {\n"
+			"      \"byteLength\" : %d\n"
+			"    }\n"
+			"  ],\n",
+			Context.BufferLength
+		);
+	}
+	else
+	{
+		Ar.Printf(
+			"  \"buffers\" : [\n"
+			"    {\n"
+			"      \"uri\" : \"%s.bin\",\n"
+			"      \"byteLength\" : %d\n"
+			"    }\n"
+			"  ],\n",
+			Context.MeshName, Context.BufferLength
+		);
 	}
-
-	Ar.Printf(
-		"  \"buffers\" : [\n"
-		"    {\n"
-		"      \"uri\" : \"%s.bin\",\n"
-		"      \"byteLength\" : %d\n"
-		"    }\n"
-		"  ],\n",
-		Context.MeshName, bufferLength
-	);
 
 	// Write bufferViews
 	Ar.Printf(
 		"  \"bufferViews\" : [\n"
 	);
-	int bufferOffset = 0;
-	for (int i = 0; i < Context.Data.Num(); i++)
+	for (int i = 0; i < Context.Views.Num(); i++)
 	{
-		const BufferData& B = Context.Data[i];
+		const BufferView& V = Context.Views[i];
 		Ar.Printf(
 			"    {\n"
 			"      \"buffer\" : 0,\n"
-			"      \"byteOffset\" : %d,\n"
+			"      \"byteOffset\" : %d,\n",
+			V.Offset
+		);
+		if (V.ByteStride)
+		{
+			Ar.Printf(
+				"      \"byteStride\" : %d,\n"
+				"      \"target\" : 34962,\n",		// ARRAY_BUFFER
+				V.ByteStride
+			);
+		}
+		else if (V.ViewType == BufferData::VIEW_INDEX)
+		{
+			Ar.Printf("      \"target\" : 34963,\n");	// ELEMENT_ARRAY_BUFFER
+		}
+		Ar.Printf(
 			"      \"byteLength\" : %d\n"
 			"    }%s\n",
-			bufferOffset,
-			B.DataSize,
-			i == (Context.Data.Num()-1) ? "" : ","
+			V.Length,
+			i == (Context.Views.Num()-1) ? "" : ","
 		);
-		bufferOffset += B.DataSize;
 	}
 	Ar.Printf(
 		"  ],\n"
 	);
 
-	// Write accessors
+	// Write accessors. Use one line per accessor, there could be lots of them when animations are exported.
 	Ar.Printf(
 		"  \"accessors\" : [\n"
 	);
@@ -922,27 +1045,22 @@ static void ExportMeshLod(GLTFExportContext& Context, const CBaseMeshLod& Lod, c
 	{
 		const BufferData& B = Context.Data[i];
 		Ar.Printf(
-			"    {\n"
-			"      \"bufferView\" : %d,\n",
-			i
+			"    { \"bufferView\" : %d, \"byteOffset\" : %d, ",
+			B.ViewIndex, B.ViewOffset
 		);
 		if (B.bNormalized)
 		{
-			Ar.Printf("      \"normalized\" : true,\n");
+			Ar.Printf("\"normalized\" : true, ");
 		}
 		if (B.BoundsMin.Len())
 		{
 			Ar.Printf(
-				"      \"min\" : %s,\n"
-				"      \"max\" : %s,\n",
+				"\"min\" : %s, \"max\" : %s, ",
 				*B.BoundsMin, *B.BoundsMax
 			);
 		}
 		Ar.Printf(
-			"      \"componentType\" : %d,\n"
-			"      \"count\" : %d,\n"
-			"      \"type\" : \"%s\"\n"
-			"    }%s\n",
+			"\"componentType\" : %d, \"count\" : %d, \"type\" : \"%s\" }%s\n",
 			B.ComponentType,
 			B.Count,
 			B.Type,
@@ -953,25 +1071,98 @@ static void ExportMeshLod(GLTFExportContext& Context, const CBaseMeshLod& Lod, c
 		"  ]\n"
 	);
 
-	// Write binary data
-	guard(WriteBIN);
-	for (int i = 0; i < Context.Data.Num(); i++)
+	// Closing brace
+	Ar.Printf("}\n");
+
+	unguard;
+}
+
+static void WriteBinaryData(const GLTFExportContext& Context, FArchive& Ar)
+{
+	guard(WriteBinaryData);
+
+	for (int ViewIndex = 0; ViewIndex < Context.Views.Num(); ViewIndex++)
 	{
-		const BufferData& B = Context.Data[i];
+		for (int i = 0; i < Context.Data.Num(); i++)
+		{
+			const BufferData& B = Context.Data[i];
+			if (B.ViewIndex != ViewIndex) continue;
 #if MAX_DEBUG
-		assert(B.FillCount == B.Count);
+			assert(B.FillCount == B.Count);
 #endif
-		Ar2.Serialize(B.Data, B.DataSize);
+			Ar.Serialize(B.Data, B.DataSize);
+		}
 	}
+
 	unguard;
+}
 
-	// Closing brace
-	Ar.Printf("}\n");
+// Write glb container: 12 byte header, JSON chunk and BIN chunk. Json is written directly to the
+// file, and chunk sizes are patched when everything has been written.
+static void ExportMeshLodGLB(GLTFExportContext& Context, const CBaseMeshLod& Lod, const CMeshVertex* Verts, FArchive& Ar)
+{
+	guard(ExportMeshLodGLB);
+
+	uint32 Magic = 0x46546C67;				// "glTF"
+	uint32 Version = 2;
+	uint32 TotalLength = 0;
+	uint32 JsonLength = 0;
+	uint32 JsonType = 0x4E4F534A;			// "JSON"
+	Ar << Magic << Version << TotalLength << JsonLength << JsonType;
+
+	int JsonStart = Ar.Tell();
+	ExportMeshLod(Context, Lod, Verts, Ar);
+	// JSON chunk should be padded with spaces
+	while (Ar.Tell() & 3)
+	{
+		Ar.Printf(" ");
+	}
+	JsonLength = Ar.Tell() - JsonStart;
+
+	uint32 BinLength = Context.BufferLength;	// already aligned by 4
+	uint32 BinType = 0x004E4942;			// "BIN\0"
+	Ar << BinLength << BinType;
+	WriteBinaryData(Context, Ar);
+
+	TotalLength = Ar.Tell();
+	Ar.Seek(0);
+	Ar << Magic << Version << TotalLength << JsonLength;
+	Ar.Seek(TotalLength);
 
 	unguard;
 }
 
-void ExportSkeletalMeshGLTF(const CSkeletalMesh* Mesh)
+static void ExportMeshLodFiles(GLTFExportContext& Context, const UObject* OriginalMesh, const CBaseMeshLod& Lod, const CMeshVertex* Verts)
+{
+	guard(ExportMeshLodFiles);
+
+	if (Context.bBinary)
+	{
+		FArchive* Ar = CreateExportArchive(OriginalMesh, 0, "%s.glb", Context.MeshName);
+		if (Ar)
+		{
+			ExportMeshLodGLB(Context, Lod, Verts, *Ar);
+			delete Ar;
+		}
+		return;
+	}
+
+	FArchive* Ar = CreateExportArchive(OriginalMesh, FAO_TextFile, "%s.gltf", Context.MeshName);
+	if (Ar)
+	{
+		ExportMeshLod(Context, Lod, Verts, *Ar);
+		delete Ar;
+
+		FArchive* Ar2 = CreateExportArchive(OriginalMesh, 0, "%s.bin", Context.MeshName);
+		assert(Ar2);
+		WriteBinaryData(Context, *Ar2);
+		delete Ar2;
+	}
+
+	unguard;
+}
+
+void ExportSkeletalMeshGLTF(const CSkeletalMesh* Mesh, bool bBinary)
 {
 	guard(ExportSkeletalMeshGLTF);
 
@@ -994,25 +1185,18 @@ void ExportSkeletalMeshGLTF(const CSkeletalMesh* Mesh)
 		char meshName[256];
 		appSprintf(ARRAY_ARG(meshName), "%s%s", OriginalMesh->Name, suffix);
 
-		FArchive* Ar = CreateExportArchive(OriginalMesh, FAO_TextFile, "%s.gltf", meshName);
-		if (Ar)
-		{
-			GLTFExportContext Context;
-			Context.MeshName = meshName;
-			Context.SkelMesh = Mesh;
+		GLTFExportContext Context;
+		Context.MeshName = meshName;
+		Context.SkelMesh = Mesh;
+		Context.bBinary = bBinary;
 
-			FArchive* Ar2 = CreateExportArchive(OriginalMesh, 0, "%s.bin", meshName);
-			assert(Ar2);
-			ExportMeshLod(Context, Mesh->Lods[Lod], Mesh->Lods[Lod].Verts, *Ar, *Ar2);
-			delete Ar;
-			delete Ar2;
-		}
+		ExportMeshLodFiles(Context, OriginalMesh, Mesh->Lods[Lod], Mesh->Lods[Lod].Verts);
 	}
 
 	unguard;
 }
 
-void ExportStaticMeshGLTF(const CStaticMesh* Mesh)
+void ExportStaticMeshGLTF(const CStaticMesh* Mesh, bool bBinary)
 {
 	guard(ExportStaticMeshGLTF);
 
@@ -1025,7 +1209,6 @@ void ExportStaticMeshGLTF(const CStaticMesh* Mesh)
 
 	int MaxLod = (GExportLods) ? Mesh->Lods.Num() : 1;
 	for (int Lod = 0; Lod < MaxLod; Lod++)
-	for (int Lod = 0; Lod < MaxLod; Lod++)
 	{
 		char suffix[32];
 		suffix[0] = 0;
@@ -1036,19 +1219,12 @@ void ExportStaticMeshGLTF(const CStaticMesh* Mesh)
 		char meshName[256];
 		appSprintf(ARRAY_ARG(meshName), "%s%s", OriginalMesh->Name, suffix);
 
-		FArchive* Ar = CreateExportArchive(OriginalMesh, FAO_TextFile, "%s.gltf", meshName);
-		if (Ar)
-		{
-			GLTFExportContext Context;
-			Context.MeshName = meshName;
-			Context.StatMesh = Mesh;
+		GLTFExportContext Context;
+		Context.MeshName = meshName;
+		Context.StatMesh = Mesh;
+		Context.bBinary = bBinary;
 
-			FArchive* Ar2 = CreateExportArchive(OriginalMesh, 0, "%s.bin", meshName);
-			assert(Ar2);
-			ExportMeshLod(Context, Mesh->Lods[Lod], Mesh->Lods[Lod].Verts, *Ar, *Ar2);
-			delete Ar;
-			delete Ar2;
-		}
+		ExportMeshLodFiles(Context, OriginalMesh, Mesh->Lods[Lod], Mesh->Lods[Lod].Verts);
 	}
 
 	unguard;
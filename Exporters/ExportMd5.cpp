@@ -304,10 +304,11 @@ void ExportMd5Anim(const CAnimSet *Anim)
 	int numBones = Anim->TrackBoneNames.Num();
 	UObject *OriginalAnim = Anim->OriginalAnim;
 
+	CScopedAnimSetTracks Tracks(Anim);
 	for (int AnimIndex = 0; AnimIndex < Anim->Sequences.Num(); AnimIndex++)
 	{
 		int i;
-		const CAnimSequence &S = *Anim->Sequences[AnimIndex];
+		const CAnimSequence &S = Tracks.Get(AnimIndex);
 
 		FArchive *Ar = CreateExportArchive(OriginalAnim, FAO_TextFile, "%s/%s.md5anim", OriginalAnim->Name, *S.Name);
 		if (!Ar)
@@ -456,6 +456,17 @@ const UObject* GetPrimaryAnimObject(const CAnimSet* Anim)
 	return Anim->OriginalAnim;
 }
 
+#define FLAG_NO_TRANSLATION		1
+#define FLAG_NO_ROTATION		2
+
+// Track which has no translation and/or rotation keys, written to [RemoveTracks] section of psa config file
+struct CRemovedTrack
+{
+	int		Sequence;
+	int		Bone;
+	int		Flags;
+};
+
 void ExportPsa(const CAnimSet *Anim)
 {
 	// using 'static' here to avoid zero-filling unused fields
@@ -521,10 +532,27 @@ void ExportPsa(const CAnimSet *Anim)
 	KeyHdr.DataCount = keysCount;
 	KeyHdr.DataSize  = sizeof(VQuatAnimKey);
 	SAVE_CHUNK(KeyHdr, "ANIMKEYS");
-	bool requireConfig = false;
+	TArray<CRemovedTrack> RemovedTracks;
+	CScopedAnimSetTracks Tracks(Anim);
 	for (i = 0; i < numAnims; i++)
 	{
-		const CAnimSequence &S = *Anim->Sequences[i];
+		const CAnimSequence &S = Tracks.Get(i);
+		// check for user error, remember tracks here to not decode sequences again when writing config file
+		for (int b = 0; b < numBones; b++)
+		{
+			int flag = 0;
+			if (S.Tracks[b]->KeyPos.Num() == 0)
+				flag |= FLAG_NO_TRANSLATION;
+			if (S.Tracks[b]->KeyQuat.Num() == 0)
+				flag |= FLAG_NO_ROTATION;
+			if (flag)
+			{
+				CRemovedTrack *R = new (RemovedTracks) CRemovedTrack;
+				R->Sequence = i;
+				R->Bone     = b;
+				R->Flags    = flag;
+			}
+		}
 		for (int t = 0; t < S.NumFrames; t++)
 		{
 			for (int b = 0; b < numBones; b++)
@@ -548,10 +576,6 @@ void ExportPsa(const CAnimSet *Anim)
 
 				Ar << K;
 				keysCount--;
-
-				// check for user error
-				if ((S.Tracks[b]->KeyPos.Num() == 0) || (S.Tracks[b]->KeyQuat.Num() == 0))
-					requireConfig = true;
 			}
 		}
 	}
@@ -560,6 +584,8 @@ void ExportPsa(const CAnimSet *Anim)
 	// psa file is done
 	delete Ar0;
 
+	bool requireConfig = RemovedTracks.Num() > 0;
+
 	// generate configuration file with extended attributes
 	if (!Anim->AnimRotationOnly && !Anim->UseAnimTranslation.Num() && !Anim->ForceMeshTranslation.Num() && !requireConfig)
 	{
@@ -590,22 +616,11 @@ void ExportPsa(const CAnimSet *Anim)
 		// has removed tracks inside the sequence
 		// currently used for Unreal Championship 2 only
 		Ar1->Printf("\n[RemoveTracks]\n");
-		for (i = 0; i < numAnims; i++)
+		static const char *FlagInfo[] = { "", "trans", "rot", "all" };
+		for (i = 0; i < RemovedTracks.Num(); i++)
 		{
-			const CAnimSequence &S = *Anim->Sequences[i];
-			for (int b = 0; b < numBones; b++)
-			{
-#define FLAG_NO_TRANSLATION		1
-#define FLAG_NO_ROTATION		2
-				static const char *FlagInfo[] = { "", "trans", "rot", "all" };
-				int flag = 0;
-				if (S.Tracks[b]->KeyPos.Num() == 0)
-					flag |= FLAG_NO_TRANSLATION;
-				if (S.Tracks[b]->KeyQuat.Num() == 0)
-					flag |= FLAG_NO_ROTATION;
-				if (flag)
-					Ar1->Printf("%s.%d=%s\n", *S.Name, b, FlagInfo[flag]);
-			}
+			const CRemovedTrack &R = RemovedTracks[i];
+			Ar1->Printf("%s.%d=%s\n", *Anim->Sequences[R.Sequence]->Name, R.Bone, FlagInfo[R.Flags]);
 		}
 	}
 
@@ -12,6 +12,8 @@
 
 #define TGA_SAVE_BOTTOMLEFT	1
 
+#define MAX_KEPT_IMAGE_BUFFER	(64 << 20)		// larger image buffer is released after texture export
+
 
 #define TGA_ORIGIN_MASK		0x30
 #define TGA_BOTLEFT			0x00
@@ -40,6 +42,7 @@ struct GCC_PACK tgaHdr_t
 
 bool GNoTgaCompress = false;
 bool GExportPNG = false;
+int  GPngCompressionLevel = 1;
 bool GExportDDS = false;
 
 //?? place this function outside (cannot place to Core - using FArchive)
@@ -282,6 +285,19 @@ void ExportTexture(const UUnrealMaterial *Tex)
 	if (IsObjectExported(Tex))
 		return;
 
+	// Buffers are reused between exported textures, so large textures will not cause
+	// allocation and release of huge memory blocks for every texture. Buffer of a very
+	// large texture is released, so it won't hold memory for the rest of the export.
+	static TArray<byte> ImageBuffer;
+	struct CImageBufferTrimmer
+	{
+		~CImageBufferTrimmer()
+		{
+			if (ImageBuffer.Max() > MAX_KEPT_IMAGE_BUFFER)
+				ImageBuffer.Empty();
+		}
+	} ImageBufferTrimmer;
+
 	byte *pic = NULL;
 	int width, height;
 
@@ -291,21 +307,32 @@ void ExportTexture(const UUnrealMaterial *Tex)
 		if (GExportDDS && TexData.IsDXT())
 		{
 			WriteDDS(TexData, Tex);
+			TexData.ReleaseCompressedData();
+			Tex->ReleaseTextureData();
 			return;
 		}
 
 		width = TexData.Mips[0].USize;
 		height = TexData.Mips[0].VSize;
-		pic = TexData.Decompress();
+		int ImageSize = TexData.GetDecompressedSize();
+		ImageBuffer.Reset(ImageSize);
+		ImageBuffer.AddUninitialized(ImageSize);
+		pic = TexData.Decompress(0, ImageBuffer.GetData());
 	}
 
+	// Compressed data is not needed anymore, release it before encoding the image
+	TexData.ReleaseCompressedData();
+	Tex->ReleaseTextureData();
+
 	if (!pic)
 	{
 		appPrintf("WARNING: texture %s has no valid mipmaps\n", Tex->Name);
 		// produce 1x1-pixel tga
 		// should erase file?
 		width = height = 1;
-		pic = new byte[4];
+		ImageBuffer.Reset(4);
+		ImageBuffer.AddZeroed(4);
+		pic = ImageBuffer.GetData();
 	}
 
 	// For HDR textures use Radiance format
@@ -317,8 +344,6 @@ void ExportTexture(const UUnrealMaterial *Tex)
 			WriteHDR(*Ar, width, height, pic);
 			delete Ar;
 		}
-
-		delete pic;
 		return;
 	}
 
@@ -327,9 +352,7 @@ void ExportTexture(const UUnrealMaterial *Tex)
 		FArchive *Ar = CreateExportArchive(Tex, 0, "%s.png", Tex->Name);
 		if (Ar)
 		{
-			TArray<byte> Data;
-			CompressPNG(pic, width, height, Data);
-			Ar->Serialize(Data.GetData(), Data.Num());
+			CompressPNG(pic, width, height, *Ar, GPngCompressionLevel);
 			delete Ar;
 		}
 	}
@@ -355,9 +378,5 @@ void ExportTexture(const UUnrealMaterial *Tex)
 		}
 	}
 
-	delete pic;
-
-	Tex->ReleaseTextureData();
-
 	unguard;
 }
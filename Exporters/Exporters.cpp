@@ -11,6 +11,7 @@
 bool GExportScripts      = false;
 bool GExportLods         = false;
 bool GDontOverwriteFiles = false;
+bool GAtomicExportFiles  = false;
 
 
 /*-----------------------------------------------------------------------------
@@ -179,18 +180,43 @@ struct UniqueNameList
 	UniqueNameList()
 	{
 		Items.Empty(1024);
+		Rehash(1024);
 	}
 
 	struct Item
 	{
 		FString Name;
 		int Count;
+		int HashNext;
 	};
 	TArray<Item> Items;
+	TArray<int> Hash;			// index of the first item for each hash value; size is power of 2
 
-	int RegisterName(const char *Name)
+	static unsigned GetHash(const char *Name)
+	{
+		unsigned hash = 0;
+		while (char c = *Name++)
+			hash = ROL32(hash, 5) - hash + c;
+		return hash;
+	}
+
+	void Rehash(int NewSize)
 	{
+		Hash.Reset(NewSize);
+		Hash.AddUninitialized(NewSize);
+		memset(Hash.GetData(), -1, NewSize * sizeof(int));
 		for (int i = 0; i < Items.Num(); i++)
+		{
+			int h = GetHash(*Items[i].Name) & (NewSize - 1);
+			Items[i].HashNext = Hash[h];
+			Hash[h] = i;
+		}
+	}
+
+	int RegisterName(const char *Name)
+	{
+		int h = GetHash(Name) & (Hash.Num() - 1);
+		for (int i = Hash[h]; i >= 0; i = Items[i].HashNext)
 		{
 			Item &V = Items[i];
 			if (V.Name == Name)
@@ -198,13 +224,33 @@ struct UniqueNameList
 				return ++V.Count;
 			}
 		}
+		int Index = Items.Num();
+		if (Index == Items.Max())
+			Items.Reserve(Index * 2);		// TArray grows linearly, avoid quadratic reallocation cost
 		Item *N = new (Items) Item;
 		N->Name = Name;
 		N->Count = 1;
+		N->HashNext = Hash[h];
+		Hash[h] = Index;
+		// keep hash chains short
+		if (Items.Num() > Hash.Num())
+			Rehash(Hash.Num() * 2);
 		return 1;
 	}
 };
 
+int RegisterUniqueNames(const TArray<const char*>& Names)
+{
+	UniqueNameList List;
+	int NumDuplicates = 0;
+	for (const char* Name : Names)
+	{
+		if (List.RegisterName(Name) >= 2)
+			NumDuplicates++;
+	}
+	return NumDuplicates;
+}
+
 bool ExportObject(const UObject *Obj)
 {
 	guard(ExportObject);
@@ -445,6 +491,7 @@ FArchive* CreateExportArchive(const UObject* Obj, unsigned FileOptions, const ch
 	}
 
 	appMakeDirectoryForFile(filename);
+	if (GAtomicExportFiles) FileOptions |= FAO_AtomicWrite;
 	FFileWriter *Ar = new FFileWriter(filename, FAO_NoOpenError | FileOptions);
 	if (!Ar->IsOpen())
 	{
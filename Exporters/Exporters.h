@@ -24,6 +24,10 @@ bool IsObjectExported(const UObject* Obj);
 
 bool ExportObject(const UObject *Obj);
 
+// Register names in an empty unique name list (the one used for -uncook export), return number of
+// duplicate names. Used for benchmarking.
+int RegisterUniqueNames(const TArray<const char*>& Names);
+
 // path
 void appSetBaseExportDirectory(const char *Dir);
 const char* GetExportPath(const UObject *Obj);
@@ -41,10 +45,12 @@ extern bool GExportScripts;
 extern bool GExportLods;
 extern bool GNoTgaCompress;
 extern bool GExportPNG;
+extern int  GPngCompressionLevel;		// zlib compression level used for PNG export
 extern bool GExportDDS;
 extern bool GUncook;
 extern bool GUseGroups;
 extern bool GDontOverwriteFiles;
+extern bool GAtomicExportFiles;			// several processes could export the same object, replace files atomically
 
 // forwards
 class UObject;
@@ -68,9 +74,9 @@ void ExportStaticMesh(const CStaticMesh *Mesh);
 // MD5Mesh
 void ExportMd5Mesh(const CSkeletalMesh *Mesh);
 void ExportMd5Anim(const CAnimSet *Anim);
-// glTF
-void ExportSkeletalMeshGLTF(const CSkeletalMesh* Mesh);
-void ExportStaticMeshGLTF(const CStaticMesh* Mesh);
+// glTF, bBinary selects single-file glb output
+void ExportSkeletalMeshGLTF(const CSkeletalMesh* Mesh, bool bBinary = false);
+void ExportStaticMeshGLTF(const CStaticMesh* Mesh, bool bBinary = false);
 // 3D
 void Export3D(const UVertMesh *Mesh);
 // TGA, DDS
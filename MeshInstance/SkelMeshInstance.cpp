@@ -446,6 +446,9 @@ void CSkelMeshInstance::UpdateSkeleton()
 				// compute time for secondary channel; always in sync with primary channel
 				Time2 = Chn->Time / AnimSeq1->NumFrames * AnimSeq2->NumFrames;
 			}
+			// make sure tracks are available; decoded sequences are kept in cache
+			AnimSeq1->DecodeTracks();
+			if (AnimSeq2) AnimSeq2->DecodeTracks();
 		}
 
 		// compute bone range, affected by specified animation bone
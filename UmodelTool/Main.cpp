@@ -33,6 +33,7 @@
 #include "UmodelCommands.h"
 #include "Version.h"
 #include "MiscStrings.h"
+#include "Parallel.h"
 
 #define APP_CAPTION					"UE Viewer"
 
@@ -226,6 +227,9 @@ static void CallExportSkeletalMesh(const CSkeletalMesh* Mesh)
 	case EExportMeshFormat::gltf:
 		ExportSkeletalMeshGLTF(Mesh);
 		break;
+	case EExportMeshFormat::glb:
+		ExportSkeletalMeshGLTF(Mesh, /*bBinary=*/ true);
+		break;
 	case EExportMeshFormat::md5:
 		ExportMd5Mesh(Mesh);
 		break;
@@ -244,6 +248,9 @@ static void CallExportStaticMesh(const CStaticMesh* Mesh)
 	case EExportMeshFormat::gltf:
 		ExportStaticMeshGLTF(Mesh);
 		break;
+	case EExportMeshFormat::glb:
+		ExportStaticMeshGLTF(Mesh, /*bBinary=*/ true);
+		break;
 	}
 }
 
@@ -257,6 +264,7 @@ static void CallExportAnimation(const CAnimSet* Anim)
 		ExportPsa(Anim);
 		break;
 	case EExportMeshFormat::gltf:
+	case EExportMeshFormat::glb:
 		appPrintf("ERROR: glTF animation could be exported from mesh viewer only.\n");
 		break;
 	case EExportMeshFormat::md5:
@@ -354,6 +362,10 @@ static void PrintUsage()
 			"    -log=file       write log to the specified file\n"
 			"    -dump           dump object information to console\n"
 			"    -pkginfo        load package and display its information\n"
+			"    -texbench       decode all textures and display decoding speed\n"
+			"    -texverify      compare DXT decoder with nvtt on reference blocks and all textures\n"
+			"    -namebench      benchmark name table parsing and string pool\n"
+			"    -exportbench    benchmark export object selection with 200k synthetic objects\n"
 #if SHOW_HIDDEN_SWITCHES
 			"    -check          check some assumptions, no other actions performed\n"
 #	if VSTUDIO_INTEGRATION
@@ -373,6 +385,16 @@ static void PrintUsage()
 #endif
 			"    -aes=key        provide AES decryption key for encrypted pak files,\n"
 			"                    key is ASCII or hex string (hex format is 0xAABBCCDD)\n"
+#if UNREAL4
+			"    -indexcache=DIR cache decoded pak file directories in DIR for faster startup\n"
+#endif
+#if !_WIN32
+			"    -mmap           use memory-mapped reading for all files (by default only\n"
+			"                    large files are mapped)\n"
+#endif
+			"    -decodethreads=N\n"
+			"                    use N threads for parallel loading and decoding; 1 disables\n"
+			"                    multithreading, default is number of CPU cores\n"
 			"\n"
 			"Compatibility options:\n"
 			"    -nomesh         disable loading of SkeletalMesh classes in a case of\n"
@@ -409,12 +431,15 @@ static void PrintUsage()
 			"    -psk            use ActorX format for meshes (default)\n"
 			"    -md5            use md5mesh/md5anim format for skeletal mesh\n"
 			"    -gltf           use glTF 2.0 format for mesh\n"
+			"    -glb            use binary glTF 2.0 format for mesh (single .glb file)\n"
 			"    -lods           export all available mesh LOD levels\n"
 			"    -dds            export textures in DDS format whenever possible\n"
 			"    -png            export textures in PNG format instead of TGA\n"
+			"    -pnglevel=N     PNG compression level: 0 (none), 1 (fast, default) - 9 (best)\n"
 			"    -notgacomp      disable TGA compression\n"
 			"    -nooverwrite    prevent existing files from being overwritten (better\n"
 			"                    performance)\n"
+			"    -threads=N      export whole packages using N worker processes\n"
 			"\n"
 			"Supported resources for export:\n"
 			"    SkeletalMesh    exported as ActorX psk file, MD5Mesh or glTF\n"
@@ -712,6 +737,9 @@ int main(int argc, const char **argv)
 		CMD_View,
 		CMD_Dump,
 		CMD_Check,
+		CMD_TexBench,
+		CMD_TexVerify,
+		CMD_NameBench,
 		CMD_PkgInfo,
 		CMD_List,
 		CMD_Export,
@@ -720,6 +748,7 @@ int main(int argc, const char **argv)
 
 	static byte mainCmd = CMD_View;
 	static bool bAll = false, hasRootDir = false, forceUI = false;
+	int numExportWorkers = 0;
 	TArray<const char*> packagesToLoad, objectsToLoad;
 	TArray<const char*> params;
 	const char *attachAnimName = NULL;
@@ -739,6 +768,9 @@ int main(int argc, const char **argv)
 			OPT_VALUE("view",    mainCmd, CMD_View)
 			OPT_VALUE("dump",    mainCmd, CMD_Dump)
 			OPT_VALUE("check",   mainCmd, CMD_Check)
+			OPT_VALUE("texbench", mainCmd, CMD_TexBench)
+			OPT_VALUE("texverify", mainCmd, CMD_TexVerify)
+			OPT_VALUE("namebench", mainCmd, CMD_NameBench)
 			OPT_VALUE("export",  mainCmd, CMD_Export)
 			OPT_VALUE("save",    mainCmd, CMD_Save)
 			OPT_VALUE("pkginfo", mainCmd, CMD_PkgInfo)
@@ -765,6 +797,10 @@ int main(int argc, const char **argv)
 			OPT_BOOL ("dds",     GSettings.Export.ExportDdsTexture)
 			OPT_BOOL ("notgacomp", GNoTgaCompress)
 			OPT_BOOL ("nooverwrite", GDontOverwriteFiles)
+			OPT_BOOL ("exportworker", GAtomicExportFiles)	// internal, passed to -threads worker processes
+#if !_WIN32
+			OPT_BOOL ("mmap",    GUseMmap)
+#endif
 #if HAS_UI
 			OPT_BOOL ("gui",     forceUI)
 #endif
@@ -798,6 +834,10 @@ int main(int argc, const char **argv)
 		{
 			GSettings.Export.SkeletalMeshFormat = GSettings.Export.StaticMeshFormat = EExportMeshFormat::gltf;
 		}
+		else if (!stricmp(opt, "glb"))
+		{
+			GSettings.Export.SkeletalMeshFormat = GSettings.Export.StaticMeshFormat = EExportMeshFormat::glb;
+		}
 		else if (!stricmp(opt, "all") && mainCmd == CMD_Dump)
 		{
 			// -all should be used only with -dump
@@ -847,6 +887,19 @@ int main(int argc, const char **argv)
 			const char *obj = opt+4;
 			objectsToLoad.Add(obj);
 		}
+		else if (!strnicmp(opt, "pnglevel=", 9))
+		{
+			GSettings.Export.PngCompressionLevel = atoi(opt+9);
+		}
+		else if (!strnicmp(opt, "threads=", 8))
+		{
+			numExportWorkers = atoi(opt+8);
+			if (numExportWorkers < 1) numExportWorkers = appGetNumCores();
+		}
+		else if (!strnicmp(opt, "decodethreads=", 14))
+		{
+			appSetNumThreads(atoi(opt+14));
+		}
 		else if (!strnicmp(opt, "anim=", 5))
 		{
 			const char *obj = opt+5;
@@ -857,6 +910,12 @@ int main(int argc, const char **argv)
 		{
 			GSettings.Startup.UseScaleForm = GSettings.Startup.UseFaceFx = true;
 		}
+#if UNREAL4
+		else if (!strnicmp(opt, "indexcache=", 11))
+		{
+			GPakIndexCacheDir = opt+11;
+		}
+#endif
 		else if (!strnicmp(opt, "aes=", 4))
 		{
 			GAesKey = opt+4;
@@ -885,6 +944,11 @@ int main(int argc, const char **argv)
 			PrintVersionInfo();
 			return 0;
 		}
+		else if (!stricmp(opt, "exportbench"))
+		{
+			BenchmarkExportLookups(200000);
+			return 0;
+		}
 		else if (!stricmp(opt, "debug"))
 		{
 			// Do nothing if this option is not supported
@@ -982,11 +1046,17 @@ int main(int argc, const char **argv)
 		appSetRootDirectory(".");			// scan for packages
 	}
 
-	bool bShouldLoadPackages = (mainCmd != CMD_Save);
+	// Whole packages could be exported by several worker processes, don't load them here
+	bool bExportWithWorkers = (mainCmd == CMD_Export) && (numExportWorkers > 1) && (objectsToLoad.Num() == 0) && !GApplication.GuiShown;
+
+	// Package listing commands are streaming packages themselves
+	bool bStreamPackages = (mainCmd == CMD_List) || (mainCmd == CMD_PkgInfo);
+
+	bool bShouldLoadPackages = (mainCmd != CMD_Save) && !bExportWithWorkers && !bStreamPackages;
 	TArray<const CGameFileInfo*> GameFiles;
 
-	// Try to load all packages first.
-	// Note: in this code, packages will be loaded without creating any exported objects.
+	// Find all requested files, keeping the command line order
+	TArray<const CGameFileInfo*> FoundFiles;
 	for (int i = 0; i < packagesToLoad.Num(); i++)
 	{
 		TStaticArray<const CGameFileInfo*, 32> Files;
@@ -996,29 +1066,42 @@ int main(int argc, const char **argv)
 		{
 			appPrintf("WARNING: unable to find package %s\n", packagesToLoad[i]);
 		}
-		else
+		for (int j = 0; j < Files.Num(); j++)
 		{
-			for (int j = 0; j < Files.Num(); j++)
+			// a single mask gives unique files, but the same file could be matched by several masks
+			if (i == 0)
+				FoundFiles.Add(Files[j]);
+			else
+				FoundFiles.AddUnique(Files[j]);
+		}
+	}
+
+	// Try to load all packages first.
+	// Note: in this code, packages will be loaded without creating any exported objects.
+	for (const CGameFileInfo* File : FoundFiles)
+	{
+		bool failed = false;
+		if (bShouldLoadPackages)
+		{
+			UnPackage* Package = UnPackage::LoadPackage(*File->GetRelativeName());
+			if (Package)
 			{
-				bool failed = false;
-				if (bShouldLoadPackages)
-				{
-					UnPackage* Package = UnPackage::LoadPackage(*Files[j]->GetRelativeName());
-					if (Package)
-					{
-						Packages.Add(Package);
-					}
-					else
-					{
-						failed = true;
-					}
-				}
-				if (!failed)
-				{
-					GameFiles.Add(Files[j]);
-				}
+				Packages.Add(Package);
+			}
+			else
+			{
+				failed = true;
 			}
 		}
+		else if (bStreamPackages && !File->IsPackage)
+		{
+			// streamed packages are loaded later, filter out files which couldn't be loaded at all
+			failed = true;
+		}
+		if (!failed)
+		{
+			GameFiles.Add(File);
+		}
 	}
 
 #if !HAS_UI
@@ -1045,22 +1128,15 @@ int main(int argc, const char **argv)
 
 	if (mainCmd == CMD_List)
 	{
-		guard(List);
-		for (int packageIndex = 0; packageIndex < Packages.Num(); packageIndex++)
-		{
-			UnPackage* Package = Packages[packageIndex];
-			if (Packages.Num() > 1)
-			{
-				appPrintf("\n%s\n", Package->Filename);
-			}
-			// dump package exports table
-			for (int i = 0; i < Package->Summary.ExportCount; i++)
-			{
-				const FObjectExport &Exp = Package->ExportTable[i];
-				appPrintf("%4d %8X %8X %s %s\n", i, Exp.SerialOffset, Exp.SerialSize, Package->GetObjectName(Exp.ClassIndex), *Exp.ObjectName);
-			}
-		}
-		unguard;
+		if (!ListPackages(GameFiles))
+			CommandLineError("failed to load provided packages");
+		return 0;
+	}
+
+	if (mainCmd == CMD_PkgInfo)
+	{
+		if (!DisplayPackageStats(GameFiles))
+			CommandLineError("failed to load provided packages");
 		return 0;
 	}
 
@@ -1070,15 +1146,52 @@ int main(int argc, const char **argv)
 		return 0;
 	}
 
-	// register exporters and classes
-	InitClassAndExportSystems(Packages[0]->Game);
+	if (mainCmd == CMD_NameBench)
+	{
+		BenchmarkNameTables(Packages);
+		return 0;
+	}
 
-	if (mainCmd == CMD_PkgInfo)
+	if (bExportWithWorkers && GameFiles.Num() > 1)
 	{
-		DisplayPackageStats(Packages);
-		return 0;					// already displayed when loaded package; extend it?
+		// Pass all options to workers except package names, root and export directories. The root
+		// directory is passed explicitly because it could be detected from package name.
+		TArray<const char*> WorkerArgs;
+		for (int arg = 1; arg < argc; arg++)
+		{
+			const char* opt = argv[arg];
+			if (opt[0] != '-') continue;
+			opt++;
+			if (!strnicmp(opt, "threads=", 8) || !strnicmp(opt, "decodethreads=", 14) || !strnicmp(opt, "pkg=", 4) ||
+				!strnicmp(opt, "path=", 5) || !strnicmp(opt, "out=", 4))
+				continue;
+			WorkerArgs.Add(argv[arg]);
+		}
+		FString RootArg, OutArg;
+		RootArg = va("-path=%s", GRootDirectory);
+		OutArg = va("-out=%s", *GSettings.Export.ExportPath);
+		WorkerArgs.Add(*RootArg);
+		WorkerArgs.Add(*OutArg);
+		// Objects imported by packages of different batches are exported by several workers
+		WorkerArgs.Add("-exportworker");
+		// Workers are already running in parallel, don't let each of them start a thread per core
+		WorkerArgs.Add("-decodethreads=1");
+		return ExportPackagesParallel(GameFiles, numExportWorkers, WorkerArgs) ? 0 : 1;
+	}
+	else if (bExportWithWorkers)
+	{
+		// Only one package, export it in this process
+		UnPackage* Package = UnPackage::LoadPackage(*GameFiles[0]->GetRelativeName());
+		if (!Package)
+		{
+			CommandLineError("failed to load provided packages");
+		}
+		Packages.Add(Package);
 	}
 
+	// register exporters and classes
+	InitClassAndExportSystems(Packages[0]->Game);
+
 	bool bShouldLoadObjects = (mainCmd != CMD_Export) || (objectsToLoad.Num() > 0);
 
 	// load requested objects if any, or fully load everything
@@ -1150,6 +1263,17 @@ int main(int argc, const char **argv)
 	appPrintProfiler();
 #endif
 
+	if (mainCmd == CMD_TexBench)
+	{
+		BenchmarkTextures();
+		return 0;
+	}
+
+	if (mainCmd == CMD_TexVerify)
+	{
+		return VerifyTextureDecoders() ? 0 : 1;
+	}
+
 	if (mainCmd == CMD_Export)
 	{
 		// If we have list of objects, the process only those ones. Otherwise, process full packages.
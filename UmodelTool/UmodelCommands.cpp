@@ -3,11 +3,55 @@
 
 #include "UnObject.h"
 #include "UnPackage.h"
+#include "UnPackageUE3Reader.h"
+#include "UnMaterial.h"
 
 #include "PackageUtils.h"
 #include "Exporters/Exporters.h"
 #include "UmodelApp.h"
+#include "UmodelCommands.h"
 
+#include "Parallel.h"
+
+
+// Simple open-addressing hash set of object pointers, used for fast checking whether an
+// object is in the list
+class CObjectSet
+{
+public:
+	CObjectSet(const TArray<UObject*>& Objects)
+	{
+		int HashSize = 16;
+		while (HashSize < Objects.Num() * 2)
+			HashSize <<= 1;
+		Mask = HashSize - 1;
+		Items.AddZeroed(HashSize);
+		for (UObject* Obj : Objects)
+		{
+			int Index = FindSlot(Obj);
+			Items[Index] = Obj;
+		}
+	}
+
+	bool Contains(const UObject* Obj) const
+	{
+		return Items[FindSlot(Obj)] != NULL;
+	}
+
+private:
+	TArray<const UObject*> Items;
+	int Mask;
+
+	// Returns index of the slot containing Obj, or index of the empty slot where Obj should be placed
+	int FindSlot(const UObject* Obj) const
+	{
+		size_t Hash = ((size_t)Obj >> 4) * 0x9E3779B1;	// Fibonacci hashing
+		int Index = (Hash ^ (Hash >> 16)) & Mask;
+		while (Items[Index] && Items[Index] != Obj)
+			Index = (Index + 1) & Mask;
+		return Index;
+	}
+};
 
 bool ExportObjects(const TArray<UObject*> *Objects, IProgressCallback* progress)
 {
@@ -22,11 +66,17 @@ bool ExportObjects(const TArray<UObject*> *Objects, IProgressCallback* progress)
 	UnPackage* notifyPackage = NULL;
 	bool hasObjectList = (Objects != NULL) && Objects->Num();
 
-	//?? when 'Objects' passed, probably iterate over that list instead of GObjObjects
+	// Iterate over GObjObjects to keep export order, use a hash set for object lookup
+	CObjectSet* selectedObjects = hasObjectList ? new CObjectSet(*Objects) : NULL;
+
 	for (UObject* ExpObj : UObject::GObjObjects)
 	{
-		if (progress && !progress->Tick()) return false;
-		bool objectSelected = !hasObjectList || (Objects->FindItem(ExpObj) >= 0);
+		if (progress && !progress->Tick())
+		{
+			delete selectedObjects;
+			return false;
+		}
+		bool objectSelected = !hasObjectList || selectedObjects->Contains(ExpObj);
 
 		if (!objectSelected) continue;
 
@@ -45,12 +95,135 @@ bool ExportObjects(const TArray<UObject*> *Objects, IProgressCallback* progress)
 		}
 	}
 
+	delete selectedObjects;
 	return true;
 
 	unguard;
 }
 
 
+void BenchmarkExportLookups(int NumObjects)
+{
+	guard(BenchmarkExportLookups);
+
+	// Linear search is quadratic, use a smaller count for it
+	int NumLinear = min(NumObjects, 20000);
+
+	// Synthetic objects: only their addresses are used, so these are never constructed. Every 2nd
+	// object is selected for export.
+	enum { OBJECT_STRIDE = 64 };
+	byte* ObjectMemory = (byte*)appMalloc(NumObjects * OBJECT_STRIDE);
+	TArray<UObject*> AllObjects;
+	TArray<UObject*> Selected;
+	AllObjects.Empty(NumObjects);
+	for (int i = 0; i < NumObjects; i++)
+	{
+		UObject* Obj = (UObject*)(ObjectMemory + i * OBJECT_STRIDE);
+		AllObjects.Add(Obj);
+		if (i & 1) Selected.Add(Obj);
+	}
+
+	// Export names: every name is registered twice, like objects duplicated in several packages
+	TArray<FString> NameStrings;
+	TArray<const char*> Names;
+	NameStrings.Empty(NumObjects);
+	Names.Empty(NumObjects);
+	for (int i = 0; i < NumObjects; i++)
+	{
+		char Buffer[256];
+		appSprintf(ARRAY_ARG(Buffer), "Package%d/Group%d/Object%d.AnimSet", i / 200, i % 7, i / 2);
+		NameStrings.Add(Buffer);
+	}
+	for (const FString& Name : NameStrings)
+		Names.Add(*Name);
+
+	appPrintf("%-16s %8s %12s %12s\n", "Test", "Objects", "Linear ms", "Hashed ms");
+
+	for (int Pass = 0; Pass < 2; Pass++)
+	{
+		int Count = (Pass == 0) ? NumLinear : NumObjects;
+
+		// Object selection
+		int NumFound[2] = { 0, 0 };
+		unsigned LinearTime = 0;
+		unsigned StartTime;
+		if (Pass == 0)
+		{
+			TArray<UObject*> List;
+			for (int i = 0; i < Count / 2; i++)
+				List.Add(Selected[i]);
+			StartTime = appMilliseconds();
+			for (int i = 0; i < Count; i++)
+			{
+				if (List.FindItem(AllObjects[i]) >= 0)
+					NumFound[0]++;
+			}
+			LinearTime = appMilliseconds() - StartTime;
+		}
+		{
+			TArray<UObject*> List;
+			for (int i = 0; i < Count / 2; i++)
+				List.Add(Selected[i]);
+			StartTime = appMilliseconds();
+			CObjectSet Set(List);
+			for (int i = 0; i < Count; i++)
+			{
+				if (Set.Contains(AllObjects[i]))
+					NumFound[1]++;
+			}
+		}
+		unsigned HashedTime = appMilliseconds() - StartTime;
+		if (Pass == 0 && NumFound[0] != NumFound[1])
+			appError("Object selection mismatch: %d != %d", NumFound[0], NumFound[1]);
+		if (Pass == 0)
+			appPrintf("%-16s %8d %12u %12u\n", "object select", Count, LinearTime, HashedTime);
+		else
+			appPrintf("%-16s %8d %12s %12u\n", "object select", Count, "-", HashedTime);
+
+		// Unique names
+		TArray<const char*> NameList;
+		for (int i = 0; i < Count; i++)
+			NameList.Add(Names[i]);
+		int NumDuplicates[2] = { 0, 0 };
+		if (Pass == 0)
+		{
+			TArray<FString> Registered;
+			StartTime = appMilliseconds();
+			for (const char* Name : NameList)
+			{
+				bool bFound = false;
+				for (const FString& S : Registered)
+				{
+					if (S == Name)
+					{
+						bFound = true;
+						break;
+					}
+				}
+				if (bFound)
+					NumDuplicates[0]++;
+				else
+					Registered.Add(Name);
+			}
+			LinearTime = appMilliseconds() - StartTime;
+		}
+		StartTime = appMilliseconds();
+		NumDuplicates[1] = RegisterUniqueNames(NameList);
+		HashedTime = appMilliseconds() - StartTime;
+		if (Pass == 0 && NumDuplicates[0] != NumDuplicates[1])
+			appError("Unique name mismatch: %d != %d", NumDuplicates[0], NumDuplicates[1]);
+		if (Pass == 0)
+			appPrintf("%-16s %8d %12u %12u\n", "unique names", Count, LinearTime, HashedTime);
+		else
+			appPrintf("%-16s %8d %12s %12u\n", "unique names", Count, "-", HashedTime);
+	}
+
+	appFree(ObjectMemory);
+
+	unguard;
+}
+
+
 bool ExportPackages(const TArray<UnPackage*>& Packages, IProgressCallback* Progress)
 {
 	guard(ExportPackages);
@@ -118,6 +291,167 @@ bool ExportPackages(const TArray<UnPackage*>& Packages, IProgressCallback* Progr
 }
 
 
+// Write a quoted argument to the response file. Quote characters are doubled, appParseResponseFile()
+// converts them back.
+static void WriteResponseFileArg(FILE* f, const char* Prefix, const char* Arg)
+{
+	fprintf(f, "\"%s", Prefix);
+	for (const char* s = Arg; *s; s++)
+	{
+		if (*s == '"') fputc('"', f);
+		fputc(*s, f);
+	}
+	fprintf(f, "\"\n");
+}
+
+// Write a response file for the worker process, see appParseResponseFile() for format details
+static bool WriteWorkerResponseFile(const char* Filename, const TArray<const char*>& WorkerArgs,
+	const TArray<const CGameFileInfo*>& Files, int First, int Count)
+{
+	guard(WriteWorkerResponseFile);
+
+	FILE* f = fopen(Filename, "w");
+	if (!f) return false;
+
+	for (int i = 0; i < WorkerArgs.Num(); i++)
+	{
+		WriteResponseFileArg(f, "", WorkerArgs[i]);
+	}
+	for (int i = 0; i < Count; i++)
+	{
+		FStaticString<MAX_PACKAGE_PATH> RelativeName;
+		Files[First + i]->GetRelativeName(RelativeName);
+		// first package is passed as <package> parameter, others are passed with -pkg
+		WriteResponseFileArg(f, (i == 0) ? "" : "-pkg=", *RelativeName);
+	}
+
+	fclose(f);
+	return true;
+
+	unguardf("%s", Filename);
+}
+
+bool ExportPackagesParallel(const TArray<const CGameFileInfo*>& Files, int NumWorkers, const TArray<const char*>& WorkerArgs)
+{
+	guard(ExportPackagesParallel);
+
+	int NumFiles = Files.Num();
+	if (NumWorkers > NumFiles) NumWorkers = NumFiles;
+	if (NumWorkers < 1) return true;
+
+	// Split work into several batches per worker, so workers which got small packages
+	// will pick up more work instead of being idle. Don't make batches too small: every
+	// worker process has to scan the game directory at startup.
+	int BatchSize = max((NumFiles + NumWorkers * 4 - 1) / (NumWorkers * 4), 1);
+
+	const char* TempDir = getenv("TEMP");
+	if (!TempDir) TempDir = getenv("TMPDIR");
+#if _WIN32
+	if (!TempDir) TempDir = ".";
+#else
+	if (!TempDir) TempDir = "/tmp";
+#endif
+
+	appPrintf("Exporting %d packages with %d worker processes\n", NumFiles, NumWorkers);
+	unsigned long startTime = appMilliseconds();
+
+	struct WorkerInfo
+	{
+		CChildProcess	Process;
+		int				First;
+		int				Count;
+		char			ResponseFile[512];
+	};
+	WorkerInfo* Workers = new WorkerInfo[NumWorkers];
+	for (int i = 0; i < NumWorkers; i++)
+		Workers[i].Count = 0;
+
+	int NextFile = 0;
+	int NumFailed = 0;
+	int BatchIndex = 0;
+	// Packages of failed batches, exported again one package per worker
+	TArray<int> RetryFiles;
+	int NextRetry = 0;
+	while (true)
+	{
+		bool bHasWork = false;
+		for (int i = 0; i < NumWorkers; i++)
+		{
+			WorkerInfo& W = Workers[i];
+			if (W.Process.IsRunning())
+			{
+				bHasWork = true;
+				continue;
+			}
+			if (W.Count)
+			{
+				// This worker has just finished its batch
+				int ExitCode = W.Process.GetExitCode();
+				if (ExitCode != 0 && W.Count > 1)
+				{
+					// Don't know which package has failed, retry them separately
+					appPrintf("WARNING: worker failed with code %d while exporting packages %d..%d, retrying them one by one\n",
+						ExitCode, W.First, W.First + W.Count - 1);
+					for (int j = 0; j < W.Count; j++)
+						RetryFiles.Add(W.First + j);
+				}
+				else if (ExitCode != 0)
+				{
+					NumFailed++;
+					FStaticString<MAX_PACKAGE_PATH> RelativeName;
+					Files[W.First]->GetRelativeName(RelativeName);
+					appPrintf("ERROR: worker failed with code %d while exporting package %s\n", ExitCode, *RelativeName);
+				}
+				remove(W.ResponseFile);
+				W.Count = 0;
+			}
+			if (NextRetry < RetryFiles.Num())
+			{
+				// Start a single package retry
+				W.First = RetryFiles[NextRetry++];
+				W.Count = 1;
+			}
+			else if (NextFile < NumFiles)
+			{
+				// Start a new batch
+				W.First = NextFile;
+				W.Count = min(BatchSize, NumFiles - NextFile);
+				NextFile += W.Count;
+			}
+			else
+			{
+				continue;
+			}
+			appSprintf(ARRAY_ARG(W.ResponseFile), "%s/umodel-%08X-%d.txt", TempDir, (unsigned)startTime, BatchIndex++);
+			const char* Args[1] = { va("@%s", W.ResponseFile) };
+			if (!WriteWorkerResponseFile(W.ResponseFile, WorkerArgs, Files, W.First, W.Count) || !W.Process.Start(1, Args))
+			{
+				appPrintf("ERROR: unable to start worker process\n");
+				NumFailed += W.Count;
+				remove(W.ResponseFile);
+				W.Count = 0;
+				continue;
+			}
+			bHasWork = true;
+		}
+		if (!bHasWork) break;
+		appSleep(20);
+	}
+
+	delete[] Workers;
+
+	unsigned long elapsedTime = appMilliseconds() - startTime;
+	appPrintf("Exported %d packages in %.1f sec", NumFiles - NumFailed, elapsedTime / 1000.0f);
+	if (NumFailed)
+		appPrintf(", %d packages failed", NumFailed);
+	appPrintf("\n");
+
+	return NumFailed == 0;
+
+	unguard;
+}
+
+
 void DisplayPackageStats(const TArray<UnPackage*> &Packages)
 {
 	if (Packages.Num() == 0)
@@ -131,6 +465,375 @@ void DisplayPackageStats(const TArray<UnPackage*> &Packages)
 	appPrintf("Class statistics:\n");
 	for (int i = 0; i < stats.Num(); i++)
 		appPrintf("%5d %s\n", stats[i].Count, stats[i].Name);
+
+#if UNREAL3
+	CBlockCache::PrintStats();
+#endif
+}
+
+
+static bool PkgInfoCallback(UnPackage* Package, TArray<ClassStats>& Stats)
+{
+	Package->PrintSummary();
+	AppendPackageStats(Package, Stats);
+	return true;
+}
+
+bool DisplayPackageStats(const TArray<const CGameFileInfo*>& Files)
+{
+	guard(DisplayPackageStats);
+
+	TArray<ClassStats> stats;
+	stats.Empty(256);
+	StreamPackages(Files, PkgInfoCallback, stats);
+
+	if (stats.Num() == 0)
+	{
+		appPrintf("Nothing has been loaded\n");
+		return false;
+	}
+	SortPackageStats(stats);
+
+	appPrintf("Class statistics:\n");
+	for (int i = 0; i < stats.Num(); i++)
+		appPrintf("%5d %s\n", stats[i].Count, stats[i].Name);
+
+#if UNREAL3
+	CBlockCache::PrintStats();
+#endif
+	return true;
+
+	unguard;
+}
+
+
+struct ListPackagesParams
+{
+	bool	bShowFilename;
+	int		NumListed;
+};
+
+static bool ListPackageCallback(UnPackage* Package, ListPackagesParams& Params)
+{
+	Params.NumListed++;
+	Package->PrintSummary();
+	if (Params.bShowFilename)
+	{
+		appPrintf("\n%s\n", Package->Filename);
+	}
+	// dump package exports table
+	for (int i = 0; i < Package->Summary.ExportCount; i++)
+	{
+		const FObjectExport &Exp = Package->ExportTable[i];
+		appPrintf("%4d %8X %8X %s %s\n", i, Exp.SerialOffset, Exp.SerialSize, Package->GetObjectName(Exp.ClassIndex), *Exp.ObjectName);
+	}
+	return true;
+}
+
+bool ListPackages(const TArray<const CGameFileInfo*>& Files)
+{
+	guard(ListPackages);
+	ListPackagesParams Params;
+	Params.bShowFilename = Files.Num() > 1;
+	Params.NumListed = 0;
+	StreamPackages(Files, ListPackageCallback, Params);
+	return Params.NumListed > 0;
+	unguard;
+}
+
+
+void BenchmarkTextures()
+{
+	guard(BenchmarkTextures);
+
+	struct FormatStats
+	{
+		int		NumTextures;
+		double	NumPixels;
+		unsigned Time;
+	};
+	FormatStats Stats[TPF_MAX];
+	memset(Stats, 0, sizeof(Stats));
+
+	appPrintf("Decoding textures using %d threads ...\n", appGetNumThreads());
+
+	TArray<byte> Buffer;
+	for (UObject* Obj : UObject::GObjObjects)
+	{
+		if (!Obj->IsA("UnrealMaterial")) continue;
+		const UUnrealMaterial* Tex = static_cast<UUnrealMaterial*>(Obj);
+		CTextureData TexData;
+		if (Tex->GetTextureData(TexData) && TexData.Mips.Num())
+		{
+			int Size = TexData.GetDecompressedSize();
+			Buffer.Reset(Size);
+			Buffer.AddUninitialized(Size);
+			// Repeat decoding of small textures to get reliable timings
+			int NumPixels = TexData.Mips[0].USize * TexData.Mips[0].VSize;
+			unsigned StartTime = appMilliseconds(), Elapsed;
+			int NumIterations = 0;
+			do
+			{
+				TexData.Decompress(0, Buffer.GetData());
+				NumIterations++;
+				Elapsed = appMilliseconds() - StartTime;
+			} while (Elapsed < 50);
+			FormatStats& S = Stats[TexData.Format];
+			S.NumTextures++;
+			S.NumPixels += (double)NumPixels * NumIterations;
+			S.Time += Elapsed;
+		}
+		TexData.ReleaseCompressedData();
+		Tex->ReleaseTextureData();
+	}
+
+	appPrintf("%-12s %8s %10s %10s\n", "Format", "Textures", "MPixels", "MPixel/s");
+	for (int i = 0; i < TPF_MAX; i++)
+	{
+		const FormatStats& S = Stats[i];
+		if (!S.NumTextures) continue;
+		double MPixels = S.NumPixels / 1e6;
+		appPrintf("%-12s %8d %10.1f %10.1f\n", PixelFormatInfo[i].Name, S.NumTextures, MPixels, MPixels / (max(S.Time, 1u) / 1000.0));
+	}
+
+	unguard;
+}
+
+
+bool VerifyTextureDecoders()
+{
+	guard(VerifyTextureDecoders);
+
+	static const ETexturePixelFormat Formats[] = { TPF_DXT1, TPF_DXT3, TPF_DXT5, TPF_DXT5N, TPF_BC4, TPF_BC5 };
+
+	struct FormatStats
+	{
+		int		NumImages;
+		int		NumFailed;
+	};
+	FormatStats Stats[TPF_MAX];
+	memset(Stats, 0, sizeof(Stats));
+
+	// Reference blocks: 64x64 pixels of pseudo-random data, 16 bytes per block at most. Random endpoints
+	// select both BC1 color modes (color0 <= color1 or not) and both BC4 alpha modes; every 4th 8-byte
+	// half-block gets equal endpoints, which is a special case for the interpolation.
+	const int RefSize = 64;
+	byte RefData[RefSize * RefSize];
+	unsigned Seed = 0x12345678;
+	for (int i = 0; i < RefSize * RefSize; i++)
+	{
+		Seed = Seed * 1664525 + 1013904223;
+		RefData[i] = Seed >> 24;
+	}
+	for (int i = 0; i < RefSize * RefSize; i += 32)
+	{
+		byte* b = RefData + i;
+		b[1] = b[2] = b[3] = b[0];
+	}
+
+	for (ETexturePixelFormat Format : Formats)
+	{
+		int NumMismatches = CompareDXTDecoders(Format, RefData, RefSize, RefSize);
+		Stats[Format].NumImages++;
+		if (NumMismatches)
+		{
+			appPrintf("%s: %d pixels of reference image differ\n", PixelFormatInfo[Format].Name, NumMismatches);
+			Stats[Format].NumFailed++;
+		}
+	}
+
+	// Loaded textures
+	for (UObject* Obj : UObject::GObjObjects)
+	{
+		if (!Obj->IsA("UnrealMaterial")) continue;
+		const UUnrealMaterial* Tex = static_cast<UUnrealMaterial*>(Obj);
+		CTextureData TexData;
+		if (Tex->GetTextureData(TexData) && TexData.Mips.Num())
+		{
+			const CMipMap& Mip = TexData.Mips[0];
+			int NumMismatches = CompareDXTDecoders(TexData.Format, Mip.CompressedData, Mip.USize, Mip.VSize);
+			if (NumMismatches >= 0)
+			{
+				FormatStats& S = Stats[TexData.Format];
+				S.NumImages++;
+				if (NumMismatches)
+				{
+					appPrintf("%s (%s %dx%d): %d pixels differ\n", Tex->Name, PixelFormatInfo[TexData.Format].Name,
+						Mip.USize, Mip.VSize, NumMismatches);
+					S.NumFailed++;
+				}
+			}
+		}
+		TexData.ReleaseCompressedData();
+		Tex->ReleaseTextureData();
+	}
+
+	int TotalFailed = 0;
+	appPrintf("%-12s %8s %8s\n", "Format", "Images", "Failed");
+	for (ETexturePixelFormat Format : Formats)
+	{
+		const FormatStats& S = Stats[Format];
+		appPrintf("%-12s %8d %8d\n", PixelFormatInfo[Format].Name, S.NumImages, S.NumFailed);
+		TotalFailed += S.NumFailed;
+	}
+	return TotalFailed == 0;
+
+	unguard;
+}
+
+
+void BenchmarkNameTables(const TArray<UnPackage*>& Packages)
+{
+	guard(BenchmarkNameTables);
+
+	appPrintf("%-48s %8s %12s %12s\n", "Package", "Names", "Generic ms", "Bulk ms");
+
+	int TotalNames = 0;
+	double TotalTime[2] = { 0, 0 };
+	TArray<const char*> Names;
+	for (UnPackage* Package : Packages)
+	{
+		int NameCount = Package->Summary.NameCount;
+		if (!NameCount) continue;
+		// Remember the current table for verification
+		Names.Reset(NameCount);
+		Names.AddUninitialized(NameCount);
+		memcpy(Names.GetData(), Package->NameTable, NameCount * sizeof(const char*));
+
+		double Time[2];
+		for (int Bulk = 0; Bulk < 2; Bulk++)
+		{
+			// Repeat loading of small tables to get reliable timings
+			unsigned StartTime = appMilliseconds(), Elapsed;
+			int NumIterations = 0;
+			do
+			{
+				Package->ReloadNameTable(Bulk != 0);
+				NumIterations++;
+				Elapsed = appMilliseconds() - StartTime;
+			} while (Elapsed < 50);
+			Time[Bulk] = (double)Elapsed / NumIterations;
+			TotalTime[Bulk] += Time[Bulk];
+			// Names are pooled, so both parsers should produce the same pointers
+			for (int i = 0; i < NameCount; i++)
+			{
+				if (Package->NameTable[i] != Names[i])
+					appError("%s: name %d mismatch (%s != %s)", Package->Filename, i, Package->NameTable[i], Names[i]);
+			}
+		}
+		TotalNames += NameCount;
+		appPrintf("%-48s %8d %12.2f %12.2f\n", Package->Filename, NameCount, Time[0], Time[1]);
+	}
+
+	if (TotalNames)
+	{
+		appPrintf("Total %d names: generic %.1f Mnames/s, bulk %.1f Mnames/s\n", TotalNames,
+			TotalNames / 1000.0 / max(TotalTime[0], 0.001), TotalNames / 1000.0 / max(TotalTime[1], 0.001));
+	}
+
+	BenchmarkStringPool(Packages);
+
+	unguard;
+}
+
+
+// Previous implementation of the string pool: fixed size table of chained entries with a simple
+// hash function. Used as a baseline in BenchmarkStringPool().
+class CChainedStringPool
+{
+public:
+	CChainedStringPool()
+	{
+		HashTable = new Entry*[HASH_SIZE];
+		memset(HashTable, 0, HASH_SIZE * sizeof(Entry*));
+		Chain = new CMemoryChain();
+	}
+	~CChainedStringPool()
+	{
+		delete[] HashTable;
+		delete Chain;
+	}
+
+	const char* Add(const char* str)
+	{
+		int len = strlen(str);
+		unsigned hash = 0;
+		for (int i = 0; i < len; i++)
+			hash = ROL32(hash, 1) + str[i];
+		hash &= HASH_SIZE - 1;
+		for (const Entry* s = HashTable[hash]; s; s = s->HashNext)
+		{
+			if (s->Length == len && !memcmp(str, s->Str, len))
+				return s->Str;
+		}
+		Entry* n = (Entry*)Chain->Alloc(sizeof(Entry) + len);
+		n->HashNext = HashTable[hash];
+		HashTable[hash] = n;
+		n->Length = len;
+		memcpy(n->Str, str, len+1);
+		return n->Str;
+	}
+
+private:
+	enum { HASH_SIZE = 65536*4 };
+	struct Entry
+	{
+		Entry*		HashNext;
+		uint16		Length;
+		char		Str[1];
+	};
+	Entry**			HashTable;
+	CMemoryChain*	Chain;
+};
+
+void BenchmarkStringPool(const TArray<UnPackage*>& Packages)
+{
+	guard(BenchmarkStringPool);
+
+	// Use names of all packages, names shared between packages are looked up several times
+	// just like when packages are loaded
+	TArray<const char*> Names;
+	for (const UnPackage* Package : Packages)
+	{
+		for (int i = 0; i < Package->Summary.NameCount; i++)
+			Names.Add(Package->NameTable[i]);
+	}
+	if (!Names.Num()) return;
+
+	unsigned Time[2];
+	CStringPool::Stats Stats;
+	for (int Impl = 0; Impl < 2; Impl++)
+	{
+		// Fill an empty pool, then look up all names again
+		unsigned StartTime = appMilliseconds();
+		if (Impl == 0)
+		{
+			CChainedStringPool Pool;
+			for (int Pass = 0; Pass < 2; Pass++)
+				for (const char* Name : Names)
+					Pool.Add(Name);
+		}
+		else
+		{
+			CStringPool Pool;
+			for (int Pass = 0; Pass < 2; Pass++)
+				for (const char* Name : Names)
+				{
+					int Len = strlen(Name);
+					Pool.Add(Name, Len, CStringPool::Hash(Name, Len));
+				}
+			Pool.GetStats(Stats);
+		}
+		unsigned Elapsed = appMilliseconds() - StartTime;
+		Time[Impl] = max(Elapsed, 1u);
+	}
+
+	appPrintf("String pool, %d names: chained %d ms, open addressing %d ms\n", Names.Num(), Time[0], Time[1]);
+	appPrintf("Pool with %d strings: %d slots, load %.2f, probes avg %.2f max %d\n", Stats.NumStrings,
+		Stats.NumSlots, Stats.LoadFactor, Stats.AvgProbeLength, Stats.MaxProbeLength);
+	appPrintStringPoolStats();
+
+	unguard;
 }
 
 
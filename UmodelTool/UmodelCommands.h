@@ -3,6 +3,7 @@
 
 class UnPackage;
 class IProgressCallback;
+struct CGameFileInfo;
 
 // Export all loaded objects.
 bool ExportObjects(const TArray<UObject*> *Objects, IProgressCallback* progress = NULL);
@@ -10,7 +11,34 @@ bool ExportObjects(const TArray<UObject*> *Objects, IProgressCallback* progress
 // Export everything from provided package list.
 bool ExportPackages(const TArray<UnPackage*>& Packages, IProgressCallback* Progress = NULL);
 
+// Export packages using several worker processes, each one is a copy of umodel executable which
+// receives 'WorkerArgs' and a part of the package list. Every worker has its own object system
+// and export context, so objects shared between packages could be exported more than once.
+bool ExportPackagesParallel(const TArray<const CGameFileInfo*>& Files, int NumWorkers, const TArray<const char*>& WorkerArgs);
+
+// Time the object selection and unique name lookups used by ExportObjects() with NumObjects synthetic
+// objects, and compare them with linear search.
+void BenchmarkExportLookups(int NumObjects);
+
 void DisplayPackageStats(const TArray<UnPackage*> &Packages);
+// Same as above, but packages are loaded one batch at a time and released after processing.
+// Returns false if no package was loaded.
+bool DisplayPackageStats(const TArray<const CGameFileInfo*>& Files);
+
+// Print export tables of provided packages. Packages are streamed, so listing doesn't keep whole
+// game in memory. Returns false if no package was loaded.
+bool ListPackages(const TArray<const CGameFileInfo*>& Files);
+
+// Decompress all loaded textures and display decoding speed for every pixel format.
+void BenchmarkTextures();
+// Compare umodel's BC1-BC5 decoder with nvtt's one on generated reference blocks and on all loaded
+// textures. Returns false if any difference was found.
+bool VerifyTextureDecoders();
+
+// Read name tables of provided packages with the generic and the bulk parsers, and display timings.
+void BenchmarkNameTables(const TArray<UnPackage*>& Packages);
+// Add names of provided packages to the string pool and to its previous implementation, display timings.
+void BenchmarkStringPool(const TArray<UnPackage*>& Packages);
 
 void SavePackages(const TArray<const CGameFileInfo*>& Packages, IProgressCallback* Progress = NULL);
 
@@ -126,6 +126,7 @@ void CExportSettings::Reset()
 	SkeletalMeshFormat = EExportMeshFormat::psk;
 	StaticMeshFormat = EExportMeshFormat::psk;
 	TextureFormat = ETextureExportFormat::tga;
+	PngCompressionLevel = 1;
 	ExportMeshLods = false;
 	SaveUncooked = false;
 	SaveGroups = false;
@@ -142,6 +143,7 @@ void CExportSettings::Apply()
 
 	GNoTgaCompress = (TextureFormat == ETextureExportFormat::tga_uncomp);
 	GExportPNG = (TextureFormat == ETextureExportFormat::png);
+	GPngCompressionLevel = bound(PngCompressionLevel, 0, 9);
 	GExportDDS = ExportDdsTexture;
 
 	GExportLods = ExportMeshLods;
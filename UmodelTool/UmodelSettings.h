@@ -56,6 +56,7 @@ enum class EExportMeshFormat : int
 	psk,
 	md5,
 	gltf,
+	glb,
 };
 
 enum class ETextureExportFormat : int
@@ -74,6 +75,7 @@ struct CExportSettings
 	EExportMeshFormat SkeletalMeshFormat;
 	EExportMeshFormat StaticMeshFormat;
 	ETextureExportFormat TextureFormat;
+	int				PngCompressionLevel;
 	bool			ExportMeshLods;
 	bool			SaveUncooked;
 	bool			SaveGroups;
@@ -85,6 +87,7 @@ struct CExportSettings
 		PROP_INT(SkeletalMeshFormat)
 		PROP_INT(StaticMeshFormat)
 		PROP_INT(TextureFormat)
+		PROP_INT(PngCompressionLevel)
 		PROP_BOOL(ExportMeshLods)
 		PROP_BOOL(SaveUncooked)
 		PROP_BOOL(SaveGroups)
@@ -2,6 +2,8 @@
 #include "UnCore.h"
 #include "GameFileSystem.h"
 
+#include "Parallel.h"
+
 #include "UnArchiveObb.h"
 #include "UnArchivePak.h"
 
@@ -215,79 +217,150 @@ static void PrintHashDistribution()
 
 //!! add define USE_VFS = SUPPORT_ANDROID || UNREAL4, perhaps || SUPPORT_IOS
 
-//?? TODO: always returns 'true' now, can change the function prototype. 'false' was used when number of files was too large.
-void appRegisterGameFile(const char *FullName, FVirtualFileSystem* parentVfs)
+// Result of opening a file as virtual file system
+struct CMountedVFS
 {
-	guard(appRegisterGameFile);
+	FVirtualFileSystem*	Vfs;
+	FString				Error;
+	FString				Log;					// appPrintf output captured while mounting in parallel
 
-//	printf("..file %s\n", FullName);
+	CMountedVFS()
+	:	Vfs(NULL)
+	{}
+};
 
-	if (!parentVfs)		// no nested VFSs
-	{
-		const char* ext = strrchr(FullName, '.');
-		if (ext)
-		{
-			guard(MountVFS);
+// Returns true when the file should be mounted as virtual file system
+static bool IsVFSFile(const char* FullName)
+{
+	const char* ext = strrchr(FullName, '.');
+	if (!ext) return false;
+	ext++;
+#if SUPPORT_ANDROID
+	if (!stricmp(ext, "obb")) return true;
+#endif
+#if UNREAL4
+	if (!stricmp(ext, "pak")) return true;
+#endif
+	//!! process other VFS types here
+	return false;
+}
 
-			ext++;
-			FVirtualFileSystem* vfs = NULL;
-			FArchive* reader = NULL;
+// Open VFS and read its directory. Doesn't touch global file lists, so it could be called
+// from ParallelFor() for several files at once.
+static void MountVFS(const char* FullName, CMountedVFS& Mounted)
+{
+	guard(MountVFS);
+
+	const char* ext = strrchr(FullName, '.') + 1;
+	FVirtualFileSystem* vfs = NULL;
+	FArchive* reader = NULL;
 
 #if SUPPORT_ANDROID
-			if (!stricmp(ext, "obb"))
-			{
-				GForcePlatform = PLATFORM_ANDROID;
-				reader = new FFileReader(FullName);
-				if (!reader) return;
-				reader->Game = GAME_UE3;
-				vfs = new FObbVFS(FullName);
-			}
+	if (!stricmp(ext, "obb"))
+	{
+		reader = new FFileReader(FullName);
+		if (!reader) return;
+		reader->Game = GAME_UE3;
+		vfs = new FObbVFS(FullName);
+	}
 #endif // SUPPORT_ANDROID
 #if UNREAL4
-			if (!stricmp(ext, "pak"))
-			{
-				reader = new FFileReader(FullName);
-				if (!reader) return;
-				reader->Game = GAME_UE4_BASE;
-				vfs = new FPakVFS(FullName);
-			}
+	if (!stricmp(ext, "pak"))
+	{
+		reader = new FFileReader(FullName);
+		if (!reader) return;
+		reader->Game = GAME_UE4_BASE;
+		vfs = new FPakVFS(FullName);
+	}
 #endif // UNREAL4
-			//!! process other VFS types here
-			//!! note: VFS pointer is not stored in any global list, and not released upon program exit
-			if (vfs)
-			{
-				assert(reader);
-				// read VF directory
-				FString error;
-				if (!vfs->AttachReader(reader, error))
-				{
-					// something goes wrong
-					if (error.Len())
-					{
-						appPrintf("%s\n", *error);
-					}
-					else
-					{
-						appPrintf("File %s has an unknown format\n", FullName);
-					}
-					delete vfs;
-					delete reader;
-					return;
-				}
-				// pre-size GameFiles
-				int NumVFSFiles = vfs->NumFiles();
-				if (GameFiles.Num() + NumVFSFiles > GameFiles.Max())
-				{
-					GameFiles.Reserve(GameFiles.Num() + NumVFSFiles);
-				}
-				// add game files
-				for (int i = 0; i < NumVFSFiles; i++)
-				{
-					appRegisterGameFile(vfs->FileName(i), vfs);
-				}
-			}
+	//!! note: VFS pointer is not stored in any global list, and not released upon program exit
+	if (!vfs) return;
+
+	assert(reader);
+	// read VF directory
+	Mounted.Error.Empty();
+	if (!vfs->AttachReader(reader, Mounted.Error))
+	{
+		// something goes wrong
+		if (!Mounted.Error.Len())
+		{
+			char buf[1024];
+			appSprintf(ARRAY_ARG(buf), "File %s has an unknown format", FullName);
+			Mounted.Error = buf;
+		}
+		delete vfs;
+		delete reader;
+		return;
+	}
+	Mounted.Vfs = vfs;
+
+	unguardf("%s", FullName);
+}
+
+static void PrintCapturedLog(const FString& Log)
+{
+	// appPrintf has a limited buffer, print long text by parts
+	const char* s = *Log;
+	for (int Len = Log.Len(); Len > 0; )
+	{
+		int Part = min(Len, 1024);
+		appPrintf("%.*s", Part, s);
+		s += Part;
+		Len -= Part;
+	}
+}
+
+void RegisterGameFile(const char *FullName, FVirtualFileSystem* parentVfs, CMountedVFS* Mounted, int64 FileSize);
+
+//?? TODO: always returns 'true' now, can change the function prototype. 'false' was used when number of files was too large.
+void appRegisterGameFile(const char *FullName, FVirtualFileSystem* parentVfs)
+{
+	RegisterGameFile(FullName, parentVfs, NULL, -1);
+}
+
+// When 'Mounted' is not NULL, it holds already mounted VFS for this file. FileSize is the size
+// of a regular file when known, or -1.
+void RegisterGameFile(const char *FullName, FVirtualFileSystem* parentVfs, CMountedVFS* Mounted, int64 FileSize)
+{
+	guard(appRegisterGameFile);
+
+//	printf("..file %s\n", FullName);
 
-			unguard;
+	if (!parentVfs && IsVFSFile(FullName))		// no nested VFSs
+	{
+#if SUPPORT_ANDROID
+		if (!stricmp(strrchr(FullName, '.'), ".obb"))
+			GForcePlatform = PLATFORM_ANDROID;
+#endif
+
+		CMountedVFS LocalMount;
+		if (!Mounted)
+		{
+			Mounted = &LocalMount;
+			MountVFS(FullName, LocalMount);
+		}
+		else
+		{
+			PrintCapturedLog(Mounted->Log);
+		}
+
+		FVirtualFileSystem* vfs = Mounted->Vfs;
+		if (!vfs)
+		{
+			if (Mounted->Error.Len())
+				appPrintf("%s\n", *Mounted->Error);
+			return;
+		}
+		// pre-size GameFiles
+		int NumVFSFiles = vfs->NumFiles();
+		if (GameFiles.Num() + NumVFSFiles > GameFiles.Max())
+		{
+			GameFiles.Reserve(GameFiles.Num() + NumVFSFiles);
+		}
+		// add game files
+		for (int i = 0; i < NumVFSFiles; i++)
+		{
+			appRegisterGameFile(vfs->FileName(i), vfs);
 		}
 	}
 
@@ -325,8 +398,12 @@ void appRegisterGameFile(const char *FullName, FVirtualFileSystem* parentVfs)
 	if (!parentVfs)
 	{
 		// regular file
-		FILE* f = fopen(FullName, "rb");
-		if (f)
+		if (FileSize >= 0)
+		{
+			// size is known from directory scanning
+			info->Size = FileSize;
+		}
+		else if (FILE* f = fopen(FullName, "rb"))
 		{
 			fseek(f, 0, SEEK_END);
 			info->Size = ftell(f);
@@ -421,78 +498,252 @@ void appRegisterGameFile(const char *FullName, FVirtualFileSystem* parentVfs)
 	unguardf("%s", FullName);
 }
 
-static bool ScanGameDirectory(const char *dir, bool recurse)
+static void CapturePrintf(void* Context, const char* Text, int Len)
 {
-	guard(ScanGameDirectory);
+	*(FString*)Context += Text;
+}
+
+static void MountVFSParallel(const TArray<FStaticString<MAX_PACKAGE_PATH>>& Names, TArray<CMountedVFS>& Mounted)
+{
+	guard(MountVFSParallel);
+
+	struct CPrintfCapture
+	{
+		CPrintfCapture(FString& Log)
+		{
+			appSetPrintfHook(CapturePrintf, &Log);
+		}
+		~CPrintfCapture()
+		{
+			appSetPrintfHook(NULL, NULL);
+		}
+	};
+
+#if UNREAL4
+	GPakDeferAesKeyRequest = true;
+	GPakAesKeyRequested = false;
+#endif
+
+	ParallelFor(Names.Num(), [&Names, &Mounted](int Index)
+		{
+			CMountedVFS& M = Mounted[Index];
+			CPrintfCapture Capture(M.Log);
+			MountVFS(*Names[Index], M);
+		});
+
+#if UNREAL4
+	GPakDeferAesKeyRequest = false;
+	if (GPakAesKeyRequested)
+	{
+		// Some pak files requires AES key, mount failed files again from the main thread,
+		// this time the key could be requested from user
+		for (int i = 0; i < Mounted.Num(); i++)
+		{
+			CMountedVFS& M = Mounted[i];
+			if (M.Vfs) continue;
+			M.Log.Empty();
+			CPrintfCapture Capture(M.Log);
+			MountVFS(*Names[i], M);
+		}
+	}
+#endif
+
+	unguard;
+}
+
+// Directory contents collected by ScanGameDirectory
+struct CScanDirectory
+{
+	struct CFile
+	{
+		int			NameOffset;		// offset in 'Names'
+		int64		Size;
+	};
+
+	FString			Path;
+	TArray<CScanDirectory*> Subdirs;	// in the order returned by OS
+	TArray<CFile>	Files;
+	TArray<char>	Names;
+
+	~CScanDirectory()
+	{
+		for (CScanDirectory* Dir : Subdirs)
+			delete Dir;
+	}
+
+	void AddFile(const char* Name, int64 Size)
+	{
+		int Len = strlen(Name) + 1;
+		CFile& File = Files[Files.AddUninitialized()];
+		File.NameOffset = Names.Num();
+		File.Size = Size;
+		if (Names.Num() + Len > Names.Max())
+			Names.Reserve((Names.Num() + Len) * 2);
+		memcpy(&Names[Names.AddUninitialized(Len)], Name, Len);
+	}
 
-	char Path[MAX_PACKAGE_PATH];
-	bool res = true;
-//	printf("Scan %s\n", dir);
+	void AddSubdir(const char* Name)
+	{
+		CScanDirectory* Dir = new CScanDirectory;
+		char Buffer[MAX_PACKAGE_PATH];
+		appSprintf(ARRAY_ARG(Buffer), "%s/%s", *Path, Name);
+		Dir->Path = Buffer;
+		Subdirs.Add(Dir);
+	}
 
-	TArray<FStaticString<256>> Filenames;
-	Filenames.Empty(256);
+	// Read directory entries, called from ParallelFor() for several directories at once
+	void Read(bool recurse);
+	// Register files of the directory and all subdirectories
+	void Register();
+};
+
+void CScanDirectory::Read(bool recurse)
+{
+	guard(CScanDirectory::Read);
 
 #if _WIN32
-	appSprintf(ARRAY_ARG(Path), "%s/*.*", dir);
+	char Mask[MAX_PACKAGE_PATH];
+	appSprintf(ARRAY_ARG(Mask), "%s/*.*", *Path);
 	_finddatai64_t found;
-	intptr_t hFind = _findfirsti64(Path, &found);
-	if (hFind == -1) return true;
+	intptr_t hFind = _findfirsti64(Mask, &found);
+	if (hFind == -1) return;
 	do
 	{
 		if (found.name[0] == '.') continue;			// "." or ".."
-		// directory -> recurse
 		if (found.attrib & _A_SUBDIR)
 		{
-			if (recurse)
-			{
-				appSprintf(ARRAY_ARG(Path), "%s/%s", dir, found.name);
-				res = ScanGameDirectory(Path, recurse);
-			}
+			if (recurse) AddSubdir(found.name);
 		}
 		else
 		{
-			Filenames.Add(found.name);
+			AddFile(found.name, found.size);
 		}
-	} while (res && _findnexti64(hFind, &found) != -1);
+	} while (_findnexti64(hFind, &found) != -1);
 	_findclose(hFind);
 #else
-	DIR *find = opendir(dir);
-	if (!find) return true;
+	DIR *find = opendir(*Path);
+	if (!find) return;
+	int fd = dirfd(find);
 	struct dirent *ent;
-	while (/*res &&*/ (ent = readdir(find)))
+	while ((ent = readdir(find)))
 	{
 		if (ent->d_name[0] == '.') continue;			// "." or ".."
-		appSprintf(ARRAY_ARG(Path), "%s/%s", dir, ent->d_name);
-		// directory -> recurse
+		if (ent->d_type == DT_DIR)
+		{
+			// File system reported a directory, no need to call stat()
+			if (recurse) AddSubdir(ent->d_name);
+			continue;
+		}
+		// Regular file, symbolic link or file system without d_type support: file size is
+		// required anyway, so call fstatat() - it is cheaper than stat() with a full path.
 		// note: using 'stat64' here because 'stat' ignores large files
 		struct stat64 buf;
-		if (stat64(Path, &buf) < 0) continue;			// or break?
+		if (fstatat64(fd, ent->d_name, &buf, 0) < 0) continue;
 		if (S_ISDIR(buf.st_mode))
 		{
-			if (recurse)
-				res = ScanGameDirectory(Path, recurse);
+			if (recurse) AddSubdir(ent->d_name);
 		}
 		else
 		{
-			Filenames.Add(ent->d_name);
+			AddFile(ent->d_name, buf.st_size);
 		}
 	}
 	closedir(find);
 #endif
 
+	unguardf("%s", *Path);
+}
+
+void CScanDirectory::Register()
+{
+	guard(CScanDirectory::Register);
+
+	// Subdirectories are registered before files, like it was done with recursive scanning
+	for (CScanDirectory* Dir : Subdirs)
+		Dir->Register();
+
 	// Register files in sorted order - should be done for pak files, so patches will work.
-	Filenames.Sort([](const FStaticString<256>& p1, const FStaticString<256>& p2) -> int
+	struct CSortedFile
+	{
+		const char*	Name;
+		int64		Size;
+	};
+	TArray<CSortedFile> SortedFiles;
+	SortedFiles.AddUninitialized(Files.Num());
+	for (int i = 0; i < Files.Num(); i++)
+	{
+		SortedFiles[i].Name = &Names[Files[i].NameOffset];
+		SortedFiles[i].Size = Files[i].Size;
+	}
+	SortedFiles.Sort([](const CSortedFile& p1, const CSortedFile& p2) -> int
 		{
-			return stricmp(*p1, *p2) > 0;
+			return stricmp(p1.Name, p2.Name) > 0;
 		});
 
-	for (int i = 0; i < Filenames.Num(); i++)
+	char FullName[MAX_PACKAGE_PATH];
+
+	// Read directories of all VFS files (pak, obb) in parallel. Files are registered later
+	// in the same sorted order, so patch files will override previous ones in the same way.
+	TArray<FStaticString<MAX_PACKAGE_PATH>> VfsNames;
+	TArray<int> VfsIndices;			// index in VfsNames for every file, -1 for regular files
+	VfsIndices.AddUninitialized(SortedFiles.Num());
+	for (int i = 0; i < SortedFiles.Num(); i++)
+	{
+		VfsIndices[i] = -1;
+		appSprintf(ARRAY_ARG(FullName), "%s/%s", *Path, SortedFiles[i].Name);
+		if (IsVFSFile(FullName))
+		{
+			VfsIndices[i] = VfsNames.Num();
+			VfsNames.Add(FullName);
+		}
+	}
+
+	TArray<CMountedVFS> Mounted;
+	if (VfsNames.Num() >= 2)
+	{
+		Mounted.AddDefaulted(VfsNames.Num());
+		MountVFSParallel(VfsNames, Mounted);
+	}
+
+	for (int i = 0; i < SortedFiles.Num(); i++)
+	{
+		appSprintf(ARRAY_ARG(FullName), "%s/%s", *Path, SortedFiles[i].Name);
+		int VfsIndex = VfsIndices[i];
+		RegisterGameFile(FullName, NULL, (VfsIndex >= 0 && Mounted.Num()) ? &Mounted[VfsIndex] : NULL, SortedFiles[i].Size);
+	}
+
+	unguardf("%s", *Path);
+}
+
+static bool ScanGameDirectory(const char *dir, bool recurse)
+{
+	guard(ScanGameDirectory);
+
+	// Read the directory tree level by level, all directories of the same level are
+	// read in parallel. Nothing is registered at this point.
+	CScanDirectory Root;
+	Root.Path = dir;
+	TArray<CScanDirectory*> Level;
+	Level.Add(&Root);
+	while (Level.Num())
 	{
-		appSprintf(ARRAY_ARG(Path), "%s/%s", dir, *Filenames[i]);
-		appRegisterGameFile(Path);
+		ParallelFor(Level.Num(), [&Level, recurse](int Index)
+			{
+				Level[Index]->Read(recurse);
+			});
+		TArray<CScanDirectory*> NextLevel;
+		for (const CScanDirectory* Dir : Level)
+		{
+			for (CScanDirectory* Subdir : Dir->Subdirs)
+				NextLevel.Add(Subdir);
+		}
+		Exchange(Level, NextLevel);
 	}
 
-	return res;
+	// Register files in the same order as recursive scanning did
+	Root.Register();
+
+	return true;
 
 	unguard;
 }
@@ -510,7 +761,13 @@ void appSetRootDirectory(const char *dir, bool recurse)
 
 	if (dir[0] == 0) dir = ".";	// using dir="" will cause scanning of "/dir1", "/dir2" etc (i.e. drive root)
 	appStrncpyz(GRootDirectory, dir, ARRAY_COUNT(GRootDirectory));
+#if UNREAL4
+	LoadPakIndexCache(GRootDirectory);
+#endif
 	ScanGameDirectory(GRootDirectory, recurse);
+#if UNREAL4
+	SavePakIndexCache();
+#endif
 
 #if GEARS4
 	if (GForceGame == GAME_Gears4)
@@ -12,6 +12,11 @@ public:
 	virtual bool AttachReader(FArchive* reader, FString& error) = 0;
 	// Open a file from VFS.
 	virtual FArchive* CreateReader(const char* name) = 0;
+	// Name of the file holding VFS data, NULL when it is not a regular file.
+	virtual const char* GetFilename() const
+	{
+		return NULL;
+	}
 
 	// Functions for iteration over all stored files
 
@@ -5,11 +5,123 @@
 #include "UnMathTools.h"		// CVertexShare
 #include "UnMaterial.h"
 
-#define STRIP_BINORMAL		1
-
 // WARNING for BuildNnnCommon functions: do not access Verts[i] directly, use VERT macro only!
 #define VERT(n)		OffsetPointer(Verts, (n) * VertexSize)
 
+// Number of faces or vertices processed by a single ParallelFor() task
+#define FACES_PER_TASK		4096
+#define VERTS_PER_TASK		4096
+
+// Vertex index of the face corner, works with both 16 and 32-bit index buffers
+#define INDEX(n)	(Idx32 ? Idx32[n] : Idx16[n])
+
+// 4 vectors in SoA form, one per SSE lane
+struct CVec3x4
+{
+	__m128		x, y, z;
+};
+
+static FORCEINLINE void Sub4(const CVec3x4 &a, const CVec3x4 &b, CVec3x4 &d)
+{
+	d.x = _mm_sub_ps(a.x, b.x);
+	d.y = _mm_sub_ps(a.y, b.y);
+	d.z = _mm_sub_ps(a.z, b.z);
+}
+
+// Same operation order as dot(CVec3, CVec3)
+static FORCEINLINE __m128 Dot4(const CVec3x4 &a, const CVec3x4 &b)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
+
+// Same operation order as cross(CVec3, CVec3, CVec3)
+static FORCEINLINE void Cross4(const CVec3x4 &a, const CVec3x4 &b, CVec3x4 &d)
+{
+	CVec3x4 r;
+	r.x = _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y));
+	r.y = _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z));
+	r.z = _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x));
+	d = r;
+}
+
+// Analog of CVec3::Normalize(): zero-length vectors are left unchanged
+static FORCEINLINE void Normalize4(CVec3x4 &v)
+{
+	__m128 len  = _mm_sqrt_ps(Dot4(v, v));
+	__m128 inv  = _mm_div_ps(_mm_set1_ps(1.0f), len);
+	__m128 mask = _mm_cmpneq_ps(len, _mm_setzero_ps());
+	v.x = _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(v.x, inv)), _mm_andnot_ps(mask, v.x));
+	v.y = _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(v.y, inv)), _mm_andnot_ps(mask, v.y));
+	v.z = _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(v.z, inv)), _mm_andnot_ps(mask, v.z));
+}
+
+// Flips sign of all lanes with _mm_xor_ps()
+static const __m128 SignMask = _mm_set1_ps(-0.0f);
+
+// Load positions of 4 vertices into SoA form. SSE intrinsics are used regardless of USE_SSE, which
+// only selects vertex position type.
+static FORCEINLINE void LoadPositions4(const CMeshVertex *V0, const CMeshVertex *V1, const CMeshVertex *V2, const CMeshVertex *V3, CVec3x4 &d)
+{
+#if USE_SSE
+	__m128 r0 = V0->Position.mm, r1 = V1->Position.mm, r2 = V2->Position.mm, r3 = V3->Position.mm;
+#else
+	__m128 r0 = _mm_setr_ps(V0->Position[0], V0->Position[1], V0->Position[2], 0);
+	__m128 r1 = _mm_setr_ps(V1->Position[0], V1->Position[1], V1->Position[2], 0);
+	__m128 r2 = _mm_setr_ps(V2->Position[0], V2->Position[1], V2->Position[2], 0);
+	__m128 r3 = _mm_setr_ps(V3->Position[0], V3->Position[1], V3->Position[2], 0);
+#endif
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	d.x = r0; d.y = r1; d.z = r2;
+}
+
+// Vertex indices for 4 faces starting from FirstFace, the last face is repeated when there's not
+// enough faces in the buffer
+static FORCEINLINE void GetFaceIndices4(const uint16 *Idx16, const uint32 *Idx32, int FirstFace, int NumFaces, int Idx[3][4])
+{
+	for (int lane = 0; lane < 4; lane++)
+	{
+		int Face = min(FirstFace + lane, NumFaces - 1);
+		for (int j = 0; j < 3; j++)
+			Idx[j][lane] = INDEX(Face * 3 + j);
+	}
+}
+
+// Stream of SoA vectors
+struct CVecStream
+{
+	float		*x, *y, *z;
+
+	// Buffer could be empty when Count is 0, so don't use operator[] here
+	void Setup(TArray<float> &Buffer, int Count, int Offset)
+	{
+		x = Buffer.GetData() + Offset;
+		y = x + Count;
+		z = y + Count;
+	}
+	FORCEINLINE void Store4(int Index, const CVec3x4 &v, int NumValid)
+	{
+		float tmp[3][4];
+		_mm_storeu_ps(tmp[0], v.x);
+		_mm_storeu_ps(tmp[1], v.y);
+		_mm_storeu_ps(tmp[2], v.z);
+		for (int lane = 0; lane < NumValid; lane++)
+		{
+			x[Index + lane] = tmp[0][lane];
+			y[Index + lane] = tmp[1][lane];
+			z[Index + lane] = tmp[2][lane];
+		}
+	}
+	FORCEINLINE void Get(int Index, CVecT &v) const
+	{
+		v[0] = x[Index];
+		v[1] = y[Index];
+		v[2] = z[Index];
+#if USE_SSE
+		v[3] = 0;
+#endif
+	}
+};
+
 void BuildNormalsCommon(CMeshVertex *Verts, int VertexSize, int NumVerts, const CIndexBuffer &Indices)
 {
 	guard(BuildNormalsCommon);
@@ -30,36 +142,71 @@ void BuildNormalsCommon(CMeshVertex *Verts, int VertexSize, int NumVerts, const
 		Share.AddVertex(VERT(i)->Position, NullVec);
 	}
 
-	CIndexBuffer::IndexAccessor_t Index = Indices.GetAccessor();
-	for (i = 0; i < Indices.Num() / 3; i++)
+	const uint16 *Idx16 = Indices.Is32Bit() ? NULL : Indices.Indices16.GetData();
+	const uint32 *Idx32 = Indices.Is32Bit() ? Indices.Indices32.GetData() : NULL;
+	int NumFaces = Indices.Num() / 3;
+
+	// Compute weighted normals for every face corner. Faces are processed by 4 at once, and face
+	// ranges are distributed between threads.
+	TArray<float> CornerBuffer;
+	CornerBuffer.AddUninitialized(NumFaces * 3 * 3);
+	CVecStream CornerNorm[3];
+	for (j = 0; j < 3; j++)
+		CornerNorm[j].Setup(CornerBuffer, NumFaces, NumFaces * 3 * j);
+
+	ParallelFor((NumFaces + FACES_PER_TASK - 1) / FACES_PER_TASK, [&](int Task)
+		{
+			int LastFace = min(Task * FACES_PER_TASK + FACES_PER_TASK, NumFaces);
+			for (int Face = Task * FACES_PER_TASK; Face < LastFace; Face += 4)
+			{
+				int Idx[3][4];
+				GetFaceIndices4(Idx16, Idx32, Face, NumFaces, Idx);
+				CVec3x4 P[3];
+				for (int k = 0; k < 3; k++)
+					LoadPositions4(VERT(Idx[k][0]), VERT(Idx[k][1]), VERT(Idx[k][2]), VERT(Idx[k][3]), P[k]);
+
+				// compute edges
+				CVec3x4 D[3];			// 0->1, 1->2, 2->0
+				Sub4(P[1], P[0], D[0]);
+				Sub4(P[2], P[1], D[1]);
+				Sub4(P[0], P[2], D[2]);
+				// compute face normal
+				CVec3x4 norm;
+				Cross4(D[1], D[0], norm);
+				Normalize4(norm);
+				// compute angles
+				for (int k = 0; k < 3; k++) Normalize4(D[k]);
+				float cosAngle[3][4];
+				_mm_storeu_ps(cosAngle[0], _mm_xor_ps(Dot4(D[0], D[2]), SignMask));
+				_mm_storeu_ps(cosAngle[1], _mm_xor_ps(Dot4(D[0], D[1]), SignMask));
+				_mm_storeu_ps(cosAngle[2], _mm_xor_ps(Dot4(D[1], D[2]), SignMask));
+				// weight face normal with angles
+				for (int k = 0; k < 3; k++)
+				{
+					float angle[4];
+					for (int lane = 0; lane < 4; lane++)
+						angle[lane] = acos(cosAngle[k][lane]);
+					__m128 a = _mm_loadu_ps(angle);
+					CVec3x4 weighted;
+					weighted.x = _mm_mul_ps(a, norm.x);
+					weighted.y = _mm_mul_ps(a, norm.y);
+					weighted.z = _mm_mul_ps(a, norm.z);
+					CornerNorm[k].Store4(Face, weighted, min(4, LastFace - Face));
+				}
+			}
+		});
+
+	// Accumulate normals of shared vertices. This is done in face order, so the result doesn't
+	// depend on number of threads.
+	for (i = 0; i < NumFaces; i++)
 	{
-		CMeshVertex *V[3];
-		CVec3 *N[3];
 		for (j = 0; j < 3; j++)
 		{
-			int idx = Index(i * 3 + j);				// index in Verts[]
-			V[j] = VERT(idx);
-			N[j] = &tmpNorm[Share.WedgeToVert[idx]]; // remap to shared verts
+			CVec3 &N = tmpNorm[Share.WedgeToVert[INDEX(i * 3 + j)]]; // remap to shared verts
+			N[0] += CornerNorm[j].x[i];
+			N[1] += CornerNorm[j].y[i];
+			N[2] += CornerNorm[j].z[i];
 		}
-
-		// compute edges
-		CVec3 D[3];				// 0->1, 1->2, 2->0
-		VectorSubtract(V[1]->Position, V[0]->Position, D[0]);
-		VectorSubtract(V[2]->Position, V[1]->Position, D[1]);
-		VectorSubtract(V[0]->Position, V[2]->Position, D[2]);
-		// compute face normal
-		CVec3 norm;
-		cross(D[1], D[0], norm);
-		norm.Normalize();
-		// compute angles
-		for (j = 0; j < 3; j++) D[j].Normalize();
-		float angle[3];
-		angle[0] = acos(-dot(D[0], D[2]));
-		angle[1] = acos(-dot(D[0], D[1]));
-		angle[2] = acos(-dot(D[1], D[2]));
-		// add normals for triangle verts
-		for (j = 0; j < 3; j++)
-			VectorMA(*N[j], angle[j], norm);
 	}
 
 	// TODO: add "hard angle threshold" - do not share vertex between faces when angle between them
@@ -70,102 +217,173 @@ void BuildNormalsCommon(CMeshVertex *Verts, int VertexSize, int NumVerts, const
 		tmpNorm[i].Normalize();
 
 	// ... then place ("unshare") normals to Verts
-	for (i = 0; i < NumVerts; i++)
-		Pack(VERT(i)->Normal, tmpNorm[Share.WedgeToVert[i]]);
+	ParallelFor((NumVerts + VERTS_PER_TASK - 1) / VERTS_PER_TASK, [&](int Task)
+		{
+			int LastVert = min(Task * VERTS_PER_TASK + VERTS_PER_TASK, NumVerts);
+			for (int Vert = Task * VERTS_PER_TASK; Vert < LastVert; Vert++)
+				Pack(VERT(Vert)->Normal, tmpNorm[Share.WedgeToVert[Vert]]);
+		});
 
 	unguard;
 }
 
 
-void BuildTangentsCommon(CMeshVertex *Verts, int VertexSize, const CIndexBuffer &Indices)
+void BuildTangentsCommon(CMeshVertex *Verts, int VertexSize, int NumVerts, const CIndexBuffer &Indices)
 {
 	guard(BuildTangentsCommon);
 
 	int i, j;
 
-	// TODO: this is not a 100% correct algorithm. Here we're iterating over all indices, processing the
-	// same wedge as many times as many triangles using it, with overwriting previous results. We should
-	// accumulate tangent value between triangles, counting number of triangles using them in a first
-	// loop. Then (in 2nd loop), offset the tangent vector to make it perpendicular to normal. And after
-	// this, in 3rd loop, compute a correct binormal.
-	// Should review the algorithm described above, to check for case when the same vertex should not
-	// share tangent space due to mirored texture (i.e. vertex use different tangent vector direction
-	// for different triangles).
-	CIndexBuffer::IndexAccessor_t Index = Indices.GetAccessor();
-	for (i = 0; i < Indices.Num() / 3; i++)
-	{
-		CMeshVertex *V[3];
-		for (j = 0; j < 3; j++)
-		{
-			int idx = Index(i * 3 + j);
-			V[j] = VERT(idx);
-		}
+	const uint16 *Idx16 = Indices.Is32Bit() ? NULL : Indices.Indices16.GetData();
+	const uint32 *Idx32 = Indices.Is32Bit() ? Indices.Indices32.GetData() : NULL;
+	int NumFaces = Indices.Num() / 3;
 
-		// compute tangent
-		CVecT tang;
-		float U0 = V[0]->UV.U;
-		float V0 = V[0]->UV.V;
-		float U1 = V[1]->UV.U;
-		float V1 = V[1]->UV.V;
-		float U2 = V[2]->UV.U;
-		float V2 = V[2]->UV.V;
+	// Compute tangent (direction of growing U) and binormal (direction of growing V) for every face.
+	// Vectors are not normalized, so faces with larger UV area will have larger weight. Faces with
+	// mirrored UV mapping are marked with negative UV sign, faces with degenerate UVs has zero sign.
+	TArray<float> FaceBuffer;
+	FaceBuffer.AddUninitialized(NumFaces * 7);
+	CVecStream FaceTangent, FaceBinormal;
+	FaceTangent.Setup(FaceBuffer, NumFaces, 0);
+	FaceBinormal.Setup(FaceBuffer, NumFaces, NumFaces * 3);
+	float *FaceSign = FaceBuffer.GetData() + NumFaces * 6;
 
-		if (V0 == V2)
+	ParallelFor((NumFaces + FACES_PER_TASK - 1) / FACES_PER_TASK, [&](int Task)
 		{
-			// W[0] -> W[2] -- axis for tangent
-			VectorSubtract(V[2]->Position, V[0]->Position, tang);
-			// we should make 'tang' to look in direction of growing 'U'
-			if (U2 < U0) tang.Negate();
-		}
-		else
+			int LastFace = min(Task * FACES_PER_TASK + FACES_PER_TASK, NumFaces);
+			for (int Face = Task * FACES_PER_TASK; Face < LastFace; Face += 4)
+			{
+				int Idx[3][4];
+				GetFaceIndices4(Idx16, Idx32, Face, NumFaces, Idx);
+				CVec3x4 P[3];
+				__m128 U[3], V[3];
+				for (int k = 0; k < 3; k++)
+				{
+					const CMeshVertex *V0 = VERT(Idx[k][0]);
+					const CMeshVertex *V1 = VERT(Idx[k][1]);
+					const CMeshVertex *V2 = VERT(Idx[k][2]);
+					const CMeshVertex *V3 = VERT(Idx[k][3]);
+					LoadPositions4(V0, V1, V2, V3, P[k]);
+					U[k] = _mm_setr_ps(V0->UV.U, V1->UV.U, V2->UV.U, V3->UV.U);
+					V[k] = _mm_setr_ps(V0->UV.V, V1->UV.V, V2->UV.V, V3->UV.V);
+				}
+
+				// edges in 3D and UV space
+				CVec3x4 E1, E2;
+				Sub4(P[1], P[0], E1);
+				Sub4(P[2], P[0], E2);
+				__m128 dU1 = _mm_sub_ps(U[1], U[0]);
+				__m128 dV1 = _mm_sub_ps(V[1], V[0]);
+				__m128 dU2 = _mm_sub_ps(U[2], U[0]);
+				__m128 dV2 = _mm_sub_ps(V[2], V[0]);
+				// sign of UV area: +1, -1 or 0
+				__m128 det  = _mm_sub_ps(_mm_mul_ps(dU1, dV2), _mm_mul_ps(dU2, dV1));
+				__m128 one  = _mm_set1_ps(1.0f);
+				__m128 sign = _mm_sub_ps(
+					_mm_and_ps(_mm_cmpgt_ps(det, _mm_setzero_ps()), one),
+					_mm_and_ps(_mm_cmplt_ps(det, _mm_setzero_ps()), one));
+				// tangent = (E1 * dV2 - E2 * dV1) * sign
+				CVec3x4 T;
+				T.x = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(E1.x, dV2), _mm_mul_ps(E2.x, dV1)), sign);
+				T.y = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(E1.y, dV2), _mm_mul_ps(E2.y, dV1)), sign);
+				T.z = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(E1.z, dV2), _mm_mul_ps(E2.z, dV1)), sign);
+				// binormal = (E2 * dU1 - E1 * dU2) * sign
+				CVec3x4 B;
+				B.x = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(E2.x, dU1), _mm_mul_ps(E1.x, dU2)), sign);
+				B.y = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(E2.y, dU1), _mm_mul_ps(E1.y, dU2)), sign);
+				B.z = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(E2.z, dU1), _mm_mul_ps(E1.z, dU2)), sign);
+
+				int NumValid = min(4, LastFace - Face);
+				FaceTangent.Store4(Face, T, NumValid);
+				FaceBinormal.Store4(Face, B, NumValid);
+				float tmp[4];
+				_mm_storeu_ps(tmp, sign);
+				for (int lane = 0; lane < NumValid; lane++)
+					FaceSign[Face + lane] = tmp[lane];
+			}
+		});
+
+	// Accumulate face vectors for every vertex. A vertex could be shared between faces with normal
+	// and mirrored UV mapping (at the mirror seam), so these faces are accumulated separately: adding
+	// them together would cancel the tangent. Accumulation is done in face order, so the result
+	// doesn't depend on number of threads.
+	TArray<float> AccumBuffer;
+	AccumBuffer.AddZeroed(NumVerts * 12);
+	CVecStream AccumTangent[2], AccumBinormal[2];	// [0] = normal UV mapping, [1] = mirrored
+	for (j = 0; j < 2; j++)
+	{
+		AccumTangent[j].Setup(AccumBuffer, NumVerts, NumVerts * 6 * j);
+		AccumBinormal[j].Setup(AccumBuffer, NumVerts, NumVerts * (6 * j + 3));
+	}
+	for (i = 0; i < NumFaces; i++)
+	{
+		if (FaceSign[i] == 0) continue;				// degenerate UVs
+		int Set = (FaceSign[i] > 0) ? 0 : 1;
+		CVecStream &T = AccumTangent[Set];
+		CVecStream &B = AccumBinormal[Set];
+		for (j = 0; j < 3; j++)
 		{
-			float pos = (V1 - V0) / (V2 - V0);			// fraction, where W[1] is placed betwen W[0] and W[2] (may be < 0 or > 1)
-			CVecT tmp;
-			Lerp(V[0]->Position, V[2]->Position, pos, tmp);
-			VectorSubtract(tmp, V[1]->Position, tang);
-			// tang.V == W[1].V; but tang.U may be greater or smaller than W[1].U
-			// we should make tang to look in side of growing U
-			float tU = Lerp(U0, U2, pos);
-			if (tU < U1) tang.Negate();
+			int Vert = INDEX(i * 3 + j);
+			T.x[Vert] += FaceTangent.x[i];
+			T.y[Vert] += FaceTangent.y[i];
+			T.z[Vert] += FaceTangent.z[i];
+			B.x[Vert] += FaceBinormal.x[i];
+			B.y[Vert] += FaceBinormal.y[i];
+			B.z[Vert] += FaceBinormal.z[i];
 		}
-		// now, tang is on triangle plane
-		// now we should place tangent orthogonal to normal, then normalize vector
-		float binormalScale = 1.0f;
-		for (j = 0; j < 3; j++)
+	}
+
+	// Make tangents orthogonal to normals and compute binormal sign
+	ParallelFor((NumVerts + VERTS_PER_TASK - 1) / VERTS_PER_TASK, [&](int Task)
 		{
-			CMeshVertex &DW = *V[j];
-			CVecT normal;
-			Unpack(normal, DW.Normal);
-			float pos = dot(normal, tang);
-
-			CVecT tangent;
-			VectorMA(tang, -pos, normal, tangent);
-			tangent.Normalize();
-			Pack(DW.Tangent, tangent);		// store
-
-			CVecT binormal;
-			cross(normal, tangent, binormal);
-			binormal.Normalize();
-			if (j == 0)		// do this only once per triangle
+			int LastVert = min(Task * VERTS_PER_TASK + VERTS_PER_TASK, NumVerts);
+			for (int Vert = Task * VERTS_PER_TASK; Vert < LastVert; Vert++)
 			{
-				// check binormal sign
-				// find two points with different V
-				int W1 = 0;
-				int W2 = (V1 != V0) ? 1 : 2;
-				// check projections of these points to binormal
-				float p1 = dot(V[W1]->Position, binormal);
-				float p2 = dot(V[W2]->Position, binormal);
-				if ((p1 - p2) * (V[W1]->UV.V - V[W2]->UV.V) < 0)
-					binormalScale = -1.0f;
-			}
-#if !STRIP_BINORMAL
-			binormal.Scale(binormalScale);
-			Pack(DW.Binormal, binormal);	// store
-#else
-			DW.Normal.SetW(binormalScale);
+				CMeshVertex &DW = *VERT(Vert);
+				CVecT normal;
+				Unpack(normal, DW.Normal);
+#if USE_SSE
+				normal[3] = 0;
 #endif
-		}
-	}
+
+				// use the UV mapping which has larger weight for this vertex
+				CVecT tang[2], binormal;
+				AccumTangent[0].Get(Vert, tang[0]);
+				AccumTangent[1].Get(Vert, tang[1]);
+				int Set = (dot(tang[1], tang[1]) > dot(tang[0], tang[0])) ? 1 : 0;
+				AccumBinormal[Set].Get(Vert, binormal);
+
+				// place tangent orthogonal to normal, then normalize vector
+				CVecT tangent;
+				VectorMA(tang[Set], -dot(normal, tang[Set]), normal, tangent);
+				float binormalScale = 1.0f;
+				float length = ((CVec3&)tangent).Normalize();
+				if (length > 1e-6f * ((CVec3&)tang[Set]).GetLength())
+				{
+					// binormal should look in direction of growing V
+					CVecT crossNT;
+					cross(normal, tangent, crossNT);
+					if (dot(crossNT, binormal) < 0)
+						binormalScale = -1.0f;
+				}
+				else
+				{
+					// vertex is not used by faces with valid UVs, or tangent is parallel to normal: use
+					// any vector which is orthogonal to normal
+					CVec3 axis3;
+					if (fabs(normal[0]) < 0.9f)
+						axis3.Set(1, 0, 0);
+					else
+						axis3.Set(0, 1, 0);
+					CVecT axis;
+					axis = axis3;
+					VectorMA(axis, -dot(normal, axis), normal, tangent);
+					tangent.Normalize();
+				}
+				Pack(DW.Tangent, tangent);		// store
+				DW.Normal.SetW(binormalScale);
+			}
+		});
 
 	unguard;
 }
@@ -8,6 +8,7 @@ class UUnrealMaterial;
 #define USE_SSE						1
 
 #include "MathSSE.h"
+#include "Parallel.h"
 
 #if USE_SSE
 typedef CVec4 CVecT;
@@ -206,7 +207,35 @@ struct CBaseMeshLod
 };
 
 void BuildNormalsCommon(CMeshVertex *Verts, int VertexSize, int NumVerts, const CIndexBuffer &Indices);
-void BuildTangentsCommon(CMeshVertex *Verts, int VertexSize, const CIndexBuffer &Indices);
+void BuildTangentsCommon(CMeshVertex *Verts, int VertexSize, int NumVerts, const CIndexBuffer &Indices);
+
+// Number of vertices processed by a single task of ParallelForMeshVerts()
+#define MESH_VERTS_PER_TASK			16384
+
+// Process vertices of all LODs using the thread pool. Every LOD is split into ranges of MESH_VERTS_PER_TASK
+// vertices, and Func(LodIndex, FirstVert, NumVerts) is called for every range. LODs should be allocated
+// before the call. Func should write only vertices of its range, so the result will be the same as for
+// serial conversion.
+template<typename LodType, typename F>
+void ParallelForMeshVerts(TArray<LodType>& Lods, const F& Func)
+{
+	// Compute number of tasks for each LOD
+	TStaticArray<int, 16> FirstTask;
+	int NumTasks = 0;
+	for (int i = 0; i < Lods.Num(); i++)
+	{
+		FirstTask.Add(NumTasks);
+		NumTasks += (Lods[i].NumVerts + MESH_VERTS_PER_TASK - 1) / MESH_VERTS_PER_TASK;
+	}
+	ParallelFor(NumTasks, [&Lods, &Func, &FirstTask](int Task)
+		{
+			int LodIndex = Lods.Num() - 1;
+			while (FirstTask[LodIndex] > Task)
+				LodIndex--;
+			int FirstVert = (Task - FirstTask[LodIndex]) * MESH_VERTS_PER_TASK;
+			Func(LodIndex, FirstVert, min(MESH_VERTS_PER_TASK, Lods[LodIndex].NumVerts - FirstVert));
+		});
+}
 
 
 #endif // __MESH_COMMON_H__
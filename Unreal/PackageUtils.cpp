@@ -3,9 +3,18 @@
 
 #include "UnObject.h"
 #include "UnPackage.h"
+#include "GameFileSystem.h"
+#include "Parallel.h"
+#include "UnArchivePak.h"		// for GPakDeferAesKeyRequest
 
 #include "PackageUtils.h"
 
+#if _WIN32
+#	include <process.h>			// for getpid()
+#else
+#	include <unistd.h>
+#endif
+
 /*-----------------------------------------------------------------------------
 	Package loader/unloader
 -----------------------------------------------------------------------------*/
@@ -76,37 +85,268 @@ void ReleaseAllObjects()
 
 
 /*-----------------------------------------------------------------------------
-	Package version scanner
+	Package scan cache
 -----------------------------------------------------------------------------*/
 
-struct ScanPackageData
+#if UNREAL4
+
+// Results of ScanPackageVersions() and ScanContent() are stored in GPakIndexCacheDir, so the next
+// scan of the same game will process only new or changed files. Files are identified by name, size
+// and modification time; for files located inside pak or obb containers, time of the container is
+// used. The cache directory is set with -indexcache, which exists in UNREAL4 builds only; without
+// UE4 support packages of all engine versions are always scanned from scratch.
+
+#define SCAN_CACHE_MAGIC		0x53504D55		// "UMPS"
+#define SCAN_CACHE_VERSION		1
+
+enum
 {
-	ScanPackageData()
-	:	Progress(NULL)
-	,	Cancelled(false)
-	,	Index(0)
-	{}
-
-	TArray<FileInfo>*	PkgInfo;
-	IProgressCallback*	Progress;
-	bool				Cancelled;
-	int					Index;
+	SCAN_VERSION = 1,						// Ver and LicVer are valid
+	SCAN_CONTENT = 2,						// object counts are valid
 };
 
-static bool ScanPackage(const CGameFileInfo *file, ScanPackageData &data)
+struct FPackageScanRecord
+{
+	FString		Name;
+	int64		Size;
+	int64		Time;
+	int32		Flags;						// SCAN_... flags
+	int32		Ver;						// -1 when the file is not a package
+	int32		LicVer;
+	int32		Game;						// GForceGame value used for content scan
+	uint16		NumSkeletalMeshes;
+	uint16		NumStaticMeshes;
+	uint16		NumAnimations;
+	uint16		NumTextures;
+
+	friend FArchive& operator<<(FArchive& Ar, FPackageScanRecord& R)
+	{
+		return Ar << R.Name << R.Size << R.Time << R.Flags << R.Ver << R.LicVer << R.Game
+			<< R.NumSkeletalMeshes << R.NumStaticMeshes << R.NumAnimations << R.NumTextures;
+	}
+};
+
+static FString ScanCacheFilename;
+static TArray<FPackageScanRecord> ScanCache;
+static int ScanCacheSorted = 0;				// number of records sorted by name, new records are appended after them
+static bool ScanCacheDirty = false;
+
+static int CompareScanRecords(const FPackageScanRecord& A, const FPackageScanRecord& B)
 {
-	guard(ScanPackage);
+	return stricmp(*A.Name, *B.Name);
+}
+
+// Load the cache for the current game directory, should be called before scanning
+static void LoadScanCache()
+{
+	guard(LoadScanCache);
 
-	if (data.Progress)
+	FString Filename = GetIndexCacheFilename("pkgscan", appGetRootDirectory());
+	if (Filename == ScanCacheFilename)
 	{
-		FStaticString<MAX_PACKAGE_PATH> RelativeName;
-		file->GetRelativeName(RelativeName);
-		if (!data.Progress->Progress(*RelativeName, data.Index++, GNumPackageFiles))
+		// Already loaded, sort records added by the previous scan
+		if (ScanCacheSorted != ScanCache.Num())
 		{
-			data.Cancelled = true;
-			return false;
+			ScanCache.Sort(CompareScanRecords);
+			ScanCacheSorted = ScanCache.Num();
 		}
+		return;
+	}
+
+	ScanCacheFilename = Filename;
+	ScanCache.Empty();
+	ScanCacheSorted = 0;
+	ScanCacheDirty = false;
+	if (Filename.IsEmpty()) return;
+
+	FFileReader Ar(*Filename, FAO_NoOpenError);
+	if (!Ar.IsOpen() || Ar.GetFileSize64() < 12) return;
+
+	uint32 Magic;
+	int32 Version;
+	Ar << Magic << Version;
+	if (Magic != SCAN_CACHE_MAGIC || Version != SCAN_CACHE_VERSION)
+	{
+		appPrintf("WARNING: ignoring bad package scan cache %s\n", *Filename);
+		return;
+	}
+	Ar << ScanCache;
+	ScanCacheSorted = ScanCache.Num();		// the file is saved sorted
+
+	unguard;
+}
+
+static void SaveScanCache()
+{
+	guard(SaveScanCache);
+
+	if (!ScanCacheDirty || ScanCacheFilename.IsEmpty()) return;
+
+	ScanCache.Sort(CompareScanRecords);
+	ScanCacheSorted = ScanCache.Num();
+	ScanCacheDirty = false;
+
+	// Write to a temporary file and rename it, the same way as SavePakIndexCache() does
+	char TempName[MAX_PACKAGE_PATH];
+	appSprintf(ARRAY_ARG(TempName), "%s.%d", *ScanCacheFilename, getpid());
+	appMakeDirectoryForFile(TempName);
+	FFileWriter* Ar = new FFileWriter(TempName, FAO_NoOpenError);
+	if (!Ar->IsOpen())
+	{
+		delete Ar;
+		appPrintf("WARNING: unable to write package scan cache %s\n", TempName);
+		return;
+	}
+	uint32 Magic = SCAN_CACHE_MAGIC;
+	int32 Version = SCAN_CACHE_VERSION;
+	*Ar << Magic << Version << ScanCache;
+	delete Ar;
+	remove(*ScanCacheFilename);		// rename() doesn't overwrite files on Windows
+	if (rename(TempName, *ScanCacheFilename) != 0)
+		remove(TempName);
+
+	unguard;
+}
+
+static int64 GetScanFileTime(const CGameFileInfo* File)
+{
+	// Files are enumerated grouped by container, so remember the last one
+	static const FVirtualFileSystem* LastVfs = NULL;
+	static int64 LastVfsTime = 0;
+
+	if (File->FileSystem)
+	{
+		if (File->FileSystem != LastVfs)
+		{
+			const char* ContainerName = File->FileSystem->GetFilename();
+			LastVfs = File->FileSystem;
+			LastVfsTime = ContainerName ? appGetFileTime(ContainerName) : 0;
+		}
+		return LastVfsTime;
+	}
+
+	char Buffer[MAX_PACKAGE_PATH];
+	appSprintf(ARRAY_ARG(Buffer), "%s/%s", appGetRootDirectory(), *File->GetRelativeName());
+	return appGetFileTime(Buffer);
+}
+
+// Returns index of the record in ScanCache, only sorted records are checked
+static int FindScanRecord(const char* Name)
+{
+	int Lo = 0, Hi = ScanCacheSorted - 1;
+	while (Lo <= Hi)
+	{
+		int Mid = (Lo + Hi) / 2;
+		int Cmp = stricmp(*ScanCache[Mid].Name, Name);
+		if (Cmp == 0) return Mid;
+		if (Cmp < 0)
+			Lo = Mid + 1;
+		else
+			Hi = Mid - 1;
+	}
+	return INDEX_NONE;
+}
+
+// Returns cached scan results of the file when they are still valid
+static const FPackageScanRecord* GetScanRecord(const CGameFileInfo* File, int Flags)
+{
+	if (!ScanCacheSorted) return NULL;
+
+	int Index = FindScanRecord(*File->GetRelativeName());
+	if (Index == INDEX_NONE) return NULL;
+
+	const FPackageScanRecord& R = ScanCache[Index];
+	if ((R.Flags & Flags) != Flags || R.Size != File->Size || R.Time != GetScanFileTime(File))
+		return NULL;
+	if ((Flags & SCAN_CONTENT) && R.Game != GForceGame)
+		return NULL;
+	return &R;
+}
+
+// Returns a record for storing scan results of the file. Returned reference is valid until the
+// next call.
+static FPackageScanRecord& UpdateScanRecord(const CGameFileInfo* File)
+{
+	FStaticString<MAX_PACKAGE_PATH> RelativeName;
+	File->GetRelativeName(RelativeName);
+
+	int Index = FindScanRecord(*RelativeName);
+	if (Index == INDEX_NONE)
+	{
+		Index = ScanCache.AddDefaulted();
+		ScanCache[Index].Name = *RelativeName;
+		ScanCache[Index].Flags = 0;
+	}
+	FPackageScanRecord& R = ScanCache[Index];
+
+	int64 Time = GetScanFileTime(File);
+	if (!R.Flags || R.Size != File->Size || R.Time != Time)
+	{
+		// New or changed file, drop all information
+		R.Size = File->Size;
+		R.Time = Time;
+		R.Flags = 0;
 	}
+	ScanCacheDirty = true;
+	return R;
+}
+
+#endif // UNREAL4
+
+// Execute Func(Index) for [0, Count) range using the thread pool. Items which are failed in worker
+// threads are processed again in the main thread: this will either display UI which can't be used
+// from workers (AES key or engine version request), or report an error in a regular way.
+template<typename F>
+static void ScanParallel(int Count, const F& Func)
+{
+	TArray<byte> Failed;
+	Failed.AddZeroed(Count);
+
+#if UNREAL4
+	GPakDeferAesKeyRequest = true;
+#endif
+	ParallelFor(Count, [&Func, &Failed](int Index)
+		{
+#if DO_GUARD
+			TRY
+			{
+#endif
+				Func(Index);
+#if DO_GUARD
+			}
+			CATCH_CRASH
+			{
+				Failed[Index] = 1;
+				GErrorHistory[0] = 0;
+			}
+#endif // DO_GUARD
+		});
+#if UNREAL4
+	GPakDeferAesKeyRequest = false;
+#endif
+	UnPackage::ApplyDetectedGame();
+
+	for (int i = 0; i < Count; i++)
+	{
+		if (Failed[i]) Func(i);
+	}
+}
+
+// Number of files processed between progress updates
+#define SCAN_BATCH_SIZE			(appGetNumThreads() * 16)
+
+
+/*-----------------------------------------------------------------------------
+	Package version scanner
+-----------------------------------------------------------------------------*/
+
+// Read a few first bytes of the file and extract version information. Ver is set to -1 if the
+// file is not a package.
+static void ReadPackageVersion(const CGameFileInfo *file, int& Ver, int& LicVer)
+{
+	guard(ReadPackageVersion);
+
+	Ver = LicVer = -1;
 
 	// read a few first bytes as integers
 	FArchive *Ar = file->CreateReader();
@@ -125,35 +365,41 @@ static bool ScanPackage(const CGameFileInfo *file, ScanPackageData &data)
 		//!! Use CreatePackageLoader() here to allow scanning of packages with custom header (Lineage etc);
 		//!! do that only when something "strange" within data noticed.
 		//!! Also, this function could react on custom package tags.
-		return true;
+		return;
 	}
 	uint32 Version = FileData[1];
 
-	FileInfo Info;
-
 #if UNREAL4
 	if ((Version & 0xFFFFF000) == 0xFFFFF000)
 	{
 		// next fields are: int VersionUE3, Version, LicenseeVersion
-		Info.Ver    = FileData[3];
-		Info.LicVer = FileData[4];
+		Ver    = FileData[3];
+		LicVer = FileData[4];
 	}
 	else
 #endif // UNREAL4
 	{
-		Info.Ver    = Version & 0xFFFF;
-		Info.LicVer = Version >> 16;
+		Ver    = Version & 0xFFFF;
+		LicVer = Version >> 16;
 	}
 
+	unguardf("%s", *file->GetRelativeName());
+}
+
+static void AddPackageVersion(TArray<FileInfo>& PkgInfo, const CGameFileInfo *file, int Ver, int LicVer)
+{
+	FileInfo Info;
+	Info.Ver    = Ver;
+	Info.LicVer = LicVer;
 	Info.Count  = 0;
 	FStaticString<MAX_PACKAGE_PATH> RelativeName;
 	file->GetRelativeName(RelativeName);
 	strcpy(Info.FileName, *RelativeName);
 //	printf("%s - %d/%d\n", *RelativeName, Info.Ver, Info.LicVer);
 	int Index = INDEX_NONE;
-	for (int i = 0; i < data.PkgInfo->Num(); i++)
+	for (int i = 0; i < PkgInfo.Num(); i++)
 	{
-		FileInfo &Info2 = (*data.PkgInfo)[i];
+		FileInfo &Info2 = PkgInfo[i];
 		if (Info2.Ver == Info.Ver && Info2.LicVer == Info.LicVer)
 		{
 			Index = i;
@@ -161,9 +407,9 @@ static bool ScanPackage(const CGameFileInfo *file, ScanPackageData &data)
 		}
 	}
 	if (Index == INDEX_NONE)
-		Index = data.PkgInfo->Add(Info);
+		Index = PkgInfo.Add(Info);
 	// update info
-	FileInfo& fileInfo = (*data.PkgInfo)[Index];
+	FileInfo& fileInfo = PkgInfo[Index];
 	fileInfo.Count++;
 	// combine filename
 	char *s = fileInfo.FileName;
@@ -174,20 +420,96 @@ static bool ScanPackage(const CGameFileInfo *file, ScanPackageData &data)
 		d++;
 	}
 	*s = 0;
-
-	return true;
-
-	unguardf("%s", *file->GetRelativeName());
 }
 
 
 bool ScanPackageVersions(TArray<FileInfo>& info, IProgressCallback* progress)
 {
+	guard(ScanPackageVersions);
+
 	info.Empty();
-	ScanPackageData data;
-	data.PkgInfo = &info;
-	data.Progress = progress;
-	appEnumGameFiles(ScanPackage, data);
+
+	TArray<const CGameFileInfo*> Files;
+	Files.Empty(GNumPackageFiles);
+	appEnumGameFiles<TArray<const CGameFileInfo*> >(
+		[](const CGameFileInfo* file, TArray<const CGameFileInfo*>& param) -> bool
+		{
+			param.Add(file);
+			return true;
+		}, Files);
+
+	// Pairs of Ver and LicVer for every file, -1 means "not a package" or "not scanned"
+	TArray<int> Versions;
+	Versions.Init(-1, Files.Num() * 2);
+
+	// Get versions from cache, and collect files which should be scanned
+	TArray<int> ToScan;
+	ToScan.Empty(Files.Num());
+#if UNREAL4
+	LoadScanCache();
+#endif
+	for (int i = 0; i < Files.Num(); i++)
+	{
+#if UNREAL4
+		const FPackageScanRecord* R = GetScanRecord(Files[i], SCAN_VERSION);
+		if (R)
+		{
+			Versions[i*2]   = R->Ver;
+			Versions[i*2+1] = R->LicVer;
+			continue;
+		}
+#endif
+		ToScan.Add(i);
+	}
+
+	bool cancelled = false;
+	int NumCached = Files.Num() - ToScan.Num();
+	for (int Done = 0; Done < ToScan.Num(); /* empty */)
+	{
+		int Count = min(SCAN_BATCH_SIZE, ToScan.Num() - Done);
+		const int* Batch = &ToScan[Done];
+
+		if (progress)
+		{
+			FStaticString<MAX_PACKAGE_PATH> RelativeName;
+			Files[Batch[0]]->GetRelativeName(RelativeName);
+			if (!progress->Progress(*RelativeName, NumCached + Done, Files.Num()))
+			{
+				cancelled = true;
+				break;
+			}
+		}
+
+		ScanParallel(Count, [&Files, &Versions, Batch](int Index)
+			{
+				int FileIndex = Batch[Index];
+				ReadPackageVersion(Files[FileIndex], Versions[FileIndex*2], Versions[FileIndex*2+1]);
+			});
+
+#if UNREAL4
+		for (int i = 0; i < Count; i++)
+		{
+			int FileIndex = Batch[i];
+			FPackageScanRecord& R = UpdateScanRecord(Files[FileIndex]);
+			R.Ver    = Versions[FileIndex*2];
+			R.LicVer = Versions[FileIndex*2+1];
+			R.Flags |= SCAN_VERSION;
+		}
+#endif
+		Done += Count;
+	}
+
+#if UNREAL4
+	// Save results even for cancelled scan, so it could be resumed later
+	SaveScanCache();
+#endif
+
+	// Combine results, files are processed in the enumeration order
+	for (int i = 0; i < Files.Num(); i++)
+	{
+		if (Versions[i*2] >= 0)
+			AddPackageVersion(info, Files[i], Versions[i*2], Versions[i*2+1]);
+	}
 	info.Sort([](const FileInfo& p1, const FileInfo& p2) -> int
 		{
 			int dif = p1.Ver - p2.Ver;
@@ -195,7 +517,9 @@ bool ScanPackageVersions(TArray<FileInfo>& info, IProgressCallback* progress)
 			return p1.LicVer - p2.LicVer;
 		});
 
-	return !data.Cancelled;
+	return !cancelled;
+
+	unguard;
 }
 
 
@@ -227,95 +551,220 @@ static void ScanPackageExports(UnPackage* package, CGameFileInfo* file)
 	} */
 }
 
-bool ScanContent(const TArray<const CGameFileInfo*>& Packages, IProgressCallback* Progress)
+bool ScanContent(const TArray<const CGameFileInfo*>& Packages, IProgressCallback* Progress, bool LoadPackages)
 {
+	guard(ScanContent);
+
 #if PROFILE
 	appResetProfiler();
 #endif
-	bool cancelled = false;
-	bool scanned = false; // says if anywhing was scanned or not, just for profiler message
+#if UNREAL4
+	LoadScanCache();
+#endif
+
+	// Collect packages which should be loaded
+	TArray<CGameFileInfo*> Files;
+	Files.Empty(Packages.Num());
 	for (int i = 0; i < Packages.Num(); i++)
 	{
 		CGameFileInfo* file = const_cast<CGameFileInfo*>(Packages[i]);		// we'll modify this structure here
-		if (file->PackageScanned) continue;
-
-		// Update progress dialog
-		FStaticString<MAX_PACKAGE_PATH> RelativeName;
-		file->GetRelativeName(RelativeName);
-		if (Progress && !Progress->Progress(*RelativeName, i, Packages.Num()))
+		if (file->Package)
 		{
-			cancelled = true;
-			break;
+			// package already loaded
+			if (!file->PackageScanned)
+			{
+				file->PackageScanned = true;
+				ScanPackageExports(file->Package, file);
+			}
+			continue;
+		}
+		if (file->PackageScanned && !LoadPackages) continue;
+#if UNREAL4
+		if (!file->PackageScanned && !LoadPackages)
+		{
+			const FPackageScanRecord* R = GetScanRecord(file, SCAN_CONTENT);
+			if (R)
+			{
+				file->PackageScanned    = true;
+				file->NumSkeletalMeshes = R->NumSkeletalMeshes;
+				file->NumStaticMeshes   = R->NumStaticMeshes;
+				file->NumAnimations     = R->NumAnimations;
+				file->NumTextures       = R->NumTextures;
+				continue;
+			}
 		}
+#endif // UNREAL4
+		Files.Add(file);
+	}
 
-		file->PackageScanned = true;
+	bool cancelled = false;
+	bool scanned = false; // says if anywhing was scanned or not, just for profiler message
+	for (int Done = 0; Done < Files.Num(); /* empty */)
+	{
+		// The first package is loaded alone: it could require UI for selecting engine version or
+		// entering AES key, so other packages will be loaded without it
+		int Count = Done ? min(SCAN_BATCH_SIZE, Files.Num() - Done) : 1;
+		CGameFileInfo** Batch = &Files[Done];
 
-		if (file->Package)
+		// Update progress dialog
+		if (Progress)
 		{
-			// package already loaded
-			ScanPackageExports(file->Package, file);
+			FStaticString<MAX_PACKAGE_PATH> RelativeName;
+			Batch[0]->GetRelativeName(RelativeName);
+			if (!Progress->Progress(*RelativeName, Done, Files.Num()))
+			{
+				cancelled = true;
+				break;
+			}
 		}
-		else
+
+		ScanParallel(Count, [Batch](int Index)
+			{
+				CGameFileInfo* file = Batch[Index];
+				UnPackage* package = UnPackage::LoadPackage(*file->GetRelativeName(), /*silent=*/ true);	// should always return non-NULL
+				if (package && !file->PackageScanned)
+					ScanPackageExports(package, file);
+			#if 0
+				// this code is disabled: it works, however we're going to use ScanContent not just to get objects counts,
+				// but also for collecting object references
+
+				// now unload package to not waste memory
+				UnPackage::UnloadPackage(package);
+				assert(file->Package == NULL);
+			#endif
+			});
+
+		for (int i = 0; i < Count; i++)
 		{
-			UnPackage* package = UnPackage::LoadPackage(*RelativeName, /*silent=*/ true);	// should always return non-NULL
-			if (!package) continue;		// should not happen
-			ScanPackageExports(package, file);
-		#if 0
-			// this code is disabled: it works, however we're going to use ScanContent not just to get objects counts,
-			// but also for collecting object references
-
-			// now unload package to not waste memory
-			UnPackage::UnloadPackage(package);
-			assert(file->Package == NULL);
-		#endif
+			CGameFileInfo* file = Batch[i];
+			file->PackageScanned = true;
+#if UNREAL4
+			FPackageScanRecord& R = UpdateScanRecord(file);
+			R.Game              = GForceGame;
+			R.NumSkeletalMeshes = file->NumSkeletalMeshes;
+			R.NumStaticMeshes   = file->NumStaticMeshes;
+			R.NumAnimations     = file->NumAnimations;
+			R.NumTextures       = file->NumTextures;
+			R.Flags |= SCAN_CONTENT;
+#endif
 		}
+		Done += Count;
 		scanned = true;
 	}
+
+#if UNREAL4
+	// Save results even for cancelled scan, so it could be resumed later
+	SaveScanCache();
+#endif
 #if 0
-	void PrintStringHashDistribution();
-	PrintStringHashDistribution();
+	appPrintStringPoolStats();
 #endif
 #if PROFILE
 	if (scanned)
 		appPrintProfiler("Scanned packages");
 #endif
 	return !cancelled;
+
+	unguard;
 }
 
 
 /*-----------------------------------------------------------------------------
-	Class statistics
+	Package streaming
 -----------------------------------------------------------------------------*/
 
-void CollectPackageStats(const TArray<UnPackage*> &Packages, TArray<ClassStats>& Stats)
+bool StreamPackagesWorker(const TArray<const CGameFileInfo*>& Files, StreamPackagesCallback_t Callback, void* Param)
 {
-	guard(CollectPackageStats);
+	guard(StreamPackagesWorker);
 
-	Stats.Empty(256);
+	TArray<UnPackage*> Loaded;
+	TArray<byte> WasLoaded;
 
-	for (int i = 0; i < Packages.Num(); i++)
+	for (int Done = 0; Done < Files.Num(); /* empty */)
 	{
-		UnPackage* pkg = Packages[i];
-		for (int j = 0; j < pkg->Summary.ExportCount; j++)
+		// The first package is loaded alone, the same way as in ScanContent()
+		int Count = Done ? min(SCAN_BATCH_SIZE, Files.Num() - Done) : 1;
+		const CGameFileInfo* const* Batch = &Files[Done];
+
+		Loaded.Empty(Count);
+		Loaded.AddZeroed(Count);
+		WasLoaded.Empty(Count);
+		WasLoaded.AddZeroed(Count);
+		for (int i = 0; i < Count; i++)
+			WasLoaded[i] = (Batch[i]->Package != NULL);
+
+		// Only package headers are read here, no objects are created
+		ScanParallel(Count, [Batch, &Loaded](int Index)
+			{
+				Loaded[Index] = UnPackage::LoadPackage(*Batch[Index]->GetRelativeName(), /*silent=*/ true);
+			});
+
+		// Report packages in original order, and release them to keep memory usage bounded by
+		// the batch size
+		bool bContinue = true;
+		for (int i = 0; i < Count; i++)
 		{
-			const FObjectExport &Exp = pkg->ExportTable[j];
-			const char* className = pkg->GetObjectName(Exp.ClassIndex);
-			ClassStats* found = NULL;
-			for (int k = 0; k < Stats.Num(); k++)
-				if (Stats[k].Name == className)
-				{
-					found = &Stats[k];
-					break;
-				}
-			if (!found)
-				found = new (Stats) ClassStats(className);
-			found->Count++;
+			UnPackage* Package = Loaded[i];
+			if (!Package) continue;
+			if (bContinue)
+				bContinue = Callback(Package, Param);
+			if (!WasLoaded[i])
+				UnPackage::UnloadPackage(Package);
 		}
+		if (!bContinue) return false;
+		Done += Count;
+	}
+
+	return true;
+
+	unguard;
+}
+
+
+/*-----------------------------------------------------------------------------
+	Class statistics
+-----------------------------------------------------------------------------*/
+
+void AppendPackageStats(const UnPackage* Package, TArray<ClassStats>& Stats)
+{
+	guard(AppendPackageStats);
+
+	for (int j = 0; j < Package->Summary.ExportCount; j++)
+	{
+		const FObjectExport &Exp = Package->ExportTable[j];
+		// Names are kept in the string pool, so these pointers remain valid when the package is unloaded
+		const char* className = Package->GetObjectName(Exp.ClassIndex);
+		ClassStats* found = NULL;
+		for (int k = 0; k < Stats.Num(); k++)
+			if (Stats[k].Name == className)
+			{
+				found = &Stats[k];
+				break;
+			}
+		if (!found)
+			found = new (Stats) ClassStats(className);
+		found->Count++;
 	}
+
+	unguard;
+}
+
+void SortPackageStats(TArray<ClassStats>& Stats)
+{
 	Stats.Sort([](const ClassStats& p1, const ClassStats& p2) -> int
 		{
 			return stricmp(p1.Name, p2.Name);
 		});
+}
+
+void CollectPackageStats(const TArray<UnPackage*> &Packages, TArray<ClassStats>& Stats)
+{
+	guard(CollectPackageStats);
+
+	Stats.Empty(256);
+	for (int i = 0; i < Packages.Num(); i++)
+		AppendPackageStats(Packages[i], Stats);
+	SortPackageStats(Stats);
 
 	unguard;
 }
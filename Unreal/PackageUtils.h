@@ -35,9 +35,29 @@ struct FileInfo
 	char	FileName[512];
 };
 
+// Packages are scanned using the thread pool. When GPakIndexCacheDir is set, results are cached,
+// so next scan will process only new or changed files.
 bool ScanPackageVersions(TArray<FileInfo>& info, IProgressCallback* progress = NULL);
 
-bool ScanContent(const TArray<const CGameFileInfo*>& Packages, IProgressCallback* Progress = NULL);
+// Fill object counts in CGameFileInfo. Scanned packages remain loaded, however counts could be
+// taken from the cache without loading a package, use LoadPackages=true when packages are needed.
+bool ScanContent(const TArray<const CGameFileInfo*>& Packages, IProgressCallback* Progress = NULL, bool LoadPackages = false);
+
+
+// Package streaming
+
+// Load package headers in batches using the thread pool and pass every package to Callback in the
+// order of Files. Packages which weren't loaded before the call are unloaded right after the callback,
+// so memory usage doesn't depend on number of files. Callback may return 'false' to stop enumeration.
+// Files which are not packages are silently skipped.
+typedef bool (*StreamPackagesCallback_t)(UnPackage*, void*);
+bool StreamPackagesWorker(const TArray<const CGameFileInfo*>& Files, StreamPackagesCallback_t Callback, void* Param = NULL);
+
+template<typename T>
+FORCEINLINE bool StreamPackages(const TArray<const CGameFileInfo*>& Files, bool (*Callback)(UnPackage*, T&), T& Param)
+{
+	return StreamPackagesWorker(Files, (StreamPackagesCallback_t)Callback, &Param);
+}
 
 
 // Class statistics
@@ -57,6 +77,10 @@ struct ClassStats
 };
 
 void CollectPackageStats(const TArray<UnPackage*> &Packages, TArray<ClassStats>& Stats);
+// Count exports of a single package, could be used for packages which are unloaded later. Stats are
+// not sorted, call SortPackageStats() when everything was appended.
+void AppendPackageStats(const UnPackage* Package, TArray<ClassStats>& Stats);
+void SortPackageStats(TArray<ClassStats>& Stats);
 
 
 #endif // __PACKAGE_UTILS_H__
@@ -176,8 +176,11 @@ int CSkeletalMesh::GetRootBone() const
 
 void CSkeletalMesh::FinalizeMesh()
 {
-	for (int lod = 0; lod < Lods.Num(); lod++)
-		Lods[lod].BuildNormals();
+	// LODs are independent, build their normals in parallel
+	ParallelFor(Lods.Num(), [this](int lod)
+		{
+			Lods[lod].BuildNormals();
+		});
 	SortBones();
 
 	// fix bone weights
@@ -474,3 +477,227 @@ void CAnimTrack::CopyFrom(const CAnimTrack &Src)
 	CopyArray(KeyQuatTime, Src.KeyQuatTime);
 	CopyArray(KeyPosTime,  Src.KeyPosTime );
 }
+
+
+/*-----------------------------------------------------------------------------
+	Cache of decoded CAnimSequence tracks
+-----------------------------------------------------------------------------*/
+
+// Least recently used sequences are released when total size of decoded data exceeds ANIM_CACHE_SIZE.
+// ANIM_CACHE_MIN_SEQUENCES most recent sequences are never released, so all sequences used by animation
+// channels of CSkelMeshInstance (up to 2 per channel) remain valid during skeleton update.
+#define ANIM_CACHE_SIZE				(256 << 20)
+#define ANIM_CACHE_MIN_SEQUENCES	64
+
+static CMutex GAnimCacheLock;
+static const CAnimSequence* GAnimCacheHead = NULL;	// most recently used
+static const CAnimSequence* GAnimCacheTail = NULL;	// least recently used
+static int GAnimCacheSize = 0;
+static int GAnimCacheCount = 0;
+
+CAnimSequence::~CAnimSequence()
+{
+	if (CacheSize)
+	{
+		CScopedLock Lock(GAnimCacheLock);
+		UnlinkFromCache();
+	}
+	FreeTracks();
+}
+
+void CAnimSequence::LinkToCache() const
+{
+	CachePrev = NULL;
+	CacheNext = GAnimCacheHead;
+	if (GAnimCacheHead)
+		GAnimCacheHead->CachePrev = this;
+	else
+		GAnimCacheTail = this;
+	GAnimCacheHead = this;
+	GAnimCacheSize += CacheSize;
+	GAnimCacheCount++;
+}
+
+void CAnimSequence::UnlinkFromCache() const
+{
+	if (CachePrev)
+		CachePrev->CacheNext = CacheNext;
+	else
+		GAnimCacheHead = CacheNext;
+	if (CacheNext)
+		CacheNext->CachePrev = CachePrev;
+	else
+		GAnimCacheTail = CachePrev;
+	CachePrev = CacheNext = NULL;
+	GAnimCacheSize -= CacheSize;
+	GAnimCacheCount--;
+}
+
+void CAnimSequence::FreeTracks() const
+{
+	for (int i = 0; i < Tracks.Num(); i++)
+	{
+		delete Tracks[i];
+	}
+	Tracks.Empty();
+	CacheSize = 0;
+}
+
+void CAnimSequence::DecodeTracks() const
+{
+	if (!DecodeFunc) return;			// not using lazy decoding
+
+	guard(CAnimSequence::DecodeTracks);
+
+	CScopedLock Lock(GAnimCacheLock);
+
+	if (CacheSize)
+	{
+		// already decoded, make it most recently used
+		UnlinkFromCache();
+		LinkToCache();
+		return;
+	}
+
+	unsigned StartTime = appMilliseconds();
+	AddToCache(Decode());
+	if (AnimSet)
+	{
+		AnimSet->NumDecodedSequences++;
+		AnimSet->DecodeTime += appMilliseconds() - StartTime;
+	}
+
+	unguardf("%s", *Name);
+}
+
+// Decode tracks and return size of decoded data. Doesn't touch the cache, so could be called without lock.
+int CAnimSequence::Decode() const
+{
+	FreeTracks();						// in a case of previous decoding error
+	DecodeFunc(DecodeOwner, OriginalSequence, const_cast<CAnimSequence*>(this));
+
+	int Size = sizeof(CAnimSequence);
+	for (int i = 0; i < Tracks.Num(); i++)
+	{
+		const CAnimTrack* T = Tracks[i];
+		Size += sizeof(CAnimTrack) + T->KeyQuat.Num() * sizeof(CQuat) + T->KeyPos.Num() * sizeof(CVec3)
+			+ (T->KeyTime.Num() + T->KeyQuatTime.Num() + T->KeyPosTime.Num()) * sizeof(float);
+	}
+	return Size;
+}
+
+void CAnimSequence::AddToCache(int Size) const
+{
+	CacheSize = Size;
+	LinkToCache();
+
+	// release least recently used sequences
+	while (GAnimCacheSize > ANIM_CACHE_SIZE && GAnimCacheCount > ANIM_CACHE_MIN_SEQUENCES)
+	{
+		const CAnimSequence* Seq = GAnimCacheTail;
+		Seq->UnlinkFromCache();
+		Seq->FreeTracks();
+	}
+}
+
+void CAnimSequence::ReleaseTracks() const
+{
+	if (!DecodeFunc) return;			// tracks can't be restored
+
+	CScopedLock Lock(GAnimCacheLock);
+	if (CacheSize)
+	{
+		UnlinkFromCache();
+		FreeTracks();
+	}
+}
+
+
+/*-----------------------------------------------------------------------------
+	Parallel decoding of CAnimSet sequences
+-----------------------------------------------------------------------------*/
+
+void CAnimSet::DecodeSequences(int First, int Count) const
+{
+	guard(CAnimSet::DecodeSequences);
+
+	// sequences of the batch must not be released from the cache by each other
+	assert(Count <= ANIM_DECODE_BATCH && ANIM_DECODE_BATCH <= ANIM_CACHE_MIN_SEQUENCES);
+
+	unsigned StartTime = appMilliseconds();
+
+	TStaticArray<const CAnimSequence*, ANIM_DECODE_BATCH> Pending;
+	int Sizes[ANIM_DECODE_BATCH];
+
+	{
+		CScopedLock Lock(GAnimCacheLock);
+		for (int i = First; i < First + Count; i++)
+		{
+			const CAnimSequence* Seq = Sequences[i];
+			if (!Seq->DecodeFunc) continue;		// not using lazy decoding
+			if (Seq->CacheSize)
+			{
+				// already decoded, make it most recently used
+				Seq->UnlinkFromCache();
+				Seq->LinkToCache();
+				continue;
+			}
+			Pending.Add(Seq);
+		}
+	}
+
+	if (!Pending.Num()) return;
+
+	// Decoders are working with const source data and write only to their own CAnimSequence
+	TRY
+	{
+		ParallelFor(Pending.Num(), [&Pending, &Sizes](int Index)
+			{
+				Sizes[Index] = Pending[Index]->Decode();
+			});
+	}
+	CATCH
+	{
+		// Tracks of successfully decoded sequences are not in the cache yet, don't keep them
+		for (int i = 0; i < Pending.Num(); i++)
+			Pending[i]->FreeTracks();
+		THROW_AGAIN;
+	}
+
+	{
+		// register sequences in original order, so cache state doesn't depend on thread timings
+		CScopedLock Lock(GAnimCacheLock);
+		for (int i = 0; i < Pending.Num(); i++)
+			Pending[i]->AddToCache(Sizes[i]);
+		NumDecodedSequences += Pending.Num();
+		DecodeTime += appMilliseconds() - StartTime;
+	}
+
+	unguardf("%s", OriginalAnim ? OriginalAnim->Name : "None");
+}
+
+const CAnimSequence& CScopedAnimSetTracks::Get(int SeqIndex)
+{
+	if (SeqIndex < First || SeqIndex >= First + Count)
+	{
+		Release();
+		First = SeqIndex;
+		Count = min(ANIM_DECODE_BATCH, Anim->Sequences.Num() - SeqIndex);
+		for (int i = First; i < First + Count; i++)
+		{
+			const CAnimSequence* Seq = Anim->Sequences[i];
+			if (!Seq->IsDecoded())
+				Decoded.Add(Seq);
+		}
+		Anim->DecodeSequences(First, Count);
+	}
+	return *Anim->Sequences[SeqIndex];
+}
+
+void CScopedAnimSetTracks::Release()
+{
+	for (int i = 0; i < Decoded.Num(); i++)
+		Decoded[i]->ReleaseTracks();
+	Decoded.Empty();
+	Count = 0;
+}
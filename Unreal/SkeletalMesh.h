@@ -71,7 +71,7 @@ struct CSkelMeshLod : public CBaseMeshLod
 	void BuildTangents()
 	{
 		if (HasTangents) return;
-		BuildTangentsCommon(Verts, sizeof(CSkelMeshVertex), Indices);
+		BuildTangentsCommon(Verts, sizeof(CSkelMeshVertex), NumVerts, Indices);
 		HasTangents = true;
 	}
 
@@ -251,29 +251,69 @@ struct CAnimTrack
 };
 
 
+class CAnimSequence;
+class CAnimSet;
+
+// Function which fills CAnimSequence.Tracks from compressed data of OriginalSequence
+typedef void (*AnimDecodeFunc_t)(UObject* Owner, const UObject* OriginalSequence, CAnimSequence* Dst);
+
 class CAnimSequence
 {
 public:
 	FName					Name;					// sequence's name
 	int						NumFrames;
 	float					Rate;
-	TArray<CAnimTrack*>		Tracks;					// for each CAnimSet.TrackBoneNames
+	mutable TArray<CAnimTrack*> Tracks;				// for each CAnimSet.TrackBoneNames; call DecodeTracks() before use
 	bool					bAdditive;				// used just for on-screen information
 #if ANIM_DEBUG_INFO
 	FString					DebugInfo;
 #endif
 
+	// Lazy decoding: when DecodeFunc is set, Tracks are empty until DecodeTracks() call, which decodes
+	// data from OriginalSequence. Decoded sequences are kept in a cache of limited size, so Tracks
+	// of one sequence could be released when other sequences are decoded.
+	AnimDecodeFunc_t		DecodeFunc;
+	UObject*				DecodeOwner;			// UAnimSet or USkeleton
+	const UObject*			OriginalSequence;		// UAnimSequence with compressed data
+	const CAnimSet*			AnimSet;				// receives decoding statistics
+
 	CAnimSequence()
-	: bAdditive(false)
+	:	bAdditive(false)
+	,	DecodeFunc(NULL)
+	,	DecodeOwner(NULL)
+	,	OriginalSequence(NULL)
+	,	AnimSet(NULL)
+	,	CacheSize(0)
+	,	CachePrev(NULL)
+	,	CacheNext(NULL)
 	{}
 
-	~CAnimSequence()
+	~CAnimSequence();
+
+	// Make Tracks available. Does nothing for sequences which were converted without lazy decoding.
+	void DecodeTracks() const;
+	// Release decoded Tracks, they will be decoded again with the next DecodeTracks() call.
+	void ReleaseTracks() const;
+
+	// Lazily decoded sequence has valid Tracks only while it is registered in the cache
+	inline bool IsDecoded() const
 	{
-		for (int i = 0; i < Tracks.Num(); i++)
-		{
-			delete Tracks[i];
-		}
+		return !DecodeFunc || CacheSize != 0;
 	}
+
+private:
+	friend class CAnimSet;
+
+	// cache of decoded sequences
+	mutable int				CacheSize;
+	mutable const CAnimSequence* CachePrev;
+	mutable const CAnimSequence* CacheNext;
+
+	int Decode() const;
+	void AddToCache(int Size) const;
+	void FreeTracks() const;
+	void LinkToCache() const;
+	void UnlinkFromCache() const;
 };
 
 
@@ -300,8 +340,14 @@ public:
 	TArray<bool>			UseAnimTranslation;		// per bone; used with AnimRotationOnly mode
 	TArray<bool>			ForceMeshTranslation;	// pre bone; used regardless of AnimRotationOnly
 
+	// decoding statistics for the whole lifetime of the AnimSet; updated with locked cache of decoded sequences
+	mutable int				NumDecodedSequences;
+	mutable int				DecodeTime;				// milliseconds spent in decoding
+
 	CAnimSet(UObject *Original)
 	:	OriginalAnim(Original)
+	,	NumDecodedSequences(0)
+	,	DecodeTime(0)
 	{}
 
 	~CAnimSet()
@@ -327,6 +373,41 @@ public:
 			return true;
 		return false;
 	}
+
+	// Decode tracks of Count sequences starting from First using all threads. Result doesn't
+	// depend on number of threads: each sequence is decoded independently.
+	void DecodeSequences(int First, int Count) const;
+};
+
+
+// Max number of sequences decoded by CAnimSet::DecodeSequences() call
+#define ANIM_DECODE_BATCH		32
+
+// Provides access to decoded sequences of CAnimSet when iterating over them. Sequences are decoded
+// in parallel by batches of ANIM_DECODE_BATCH items. Tracks which weren't decoded before are released
+// when switching to the next batch, so exporters don't fill the cache with sequences used just once.
+class CScopedAnimSetTracks
+{
+public:
+	CScopedAnimSetTracks(const CAnimSet* InAnim)
+	:	Anim(InAnim)
+	,	First(0)
+	,	Count(0)
+	{}
+	~CScopedAnimSetTracks()
+	{
+		Release();
+	}
+
+	const CAnimSequence& Get(int SeqIndex);
+
+private:
+	const CAnimSet*			Anim;
+	int						First;
+	int						Count;
+	TStaticArray<const CAnimSequence*, ANIM_DECODE_BATCH> Decoded;
+
+	void Release();
 };
 
 
@@ -36,7 +36,7 @@ struct CStaticMeshLod : public CBaseMeshLod
 	void BuildTangents()
 	{
 		if (HasTangents) return;
-		BuildTangentsCommon(Verts, sizeof(CStaticMeshVertex), Indices);
+		BuildTangentsCommon(Verts, sizeof(CStaticMeshVertex), NumVerts, Indices);
 		HasTangents = true;
 	}
 
@@ -76,8 +76,11 @@ public:
 
 	void FinalizeMesh()
 	{
-		for (int i = 0; i < Lods.Num(); i++)
-			Lods[i].BuildNormals();
+		// LODs are independent, build their normals in parallel
+		ParallelFor(Lods.Num(), [this](int i)
+			{
+				Lods[i].BuildNormals();
+			});
 	}
 
 #if RENDERING
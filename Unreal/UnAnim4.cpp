@@ -415,6 +415,11 @@ void AdjustSequenceBySkeleton(USkeleton* Skel, CAnimSequence* Anim)
 	unguard;
 }
 
+static void DecodeSequenceThunk(UObject* Owner, const UObject* OriginalSequence, CAnimSequence* Dst)
+{
+	static_cast<USkeleton*>(Owner)->DecodeSequence(static_cast<const UAnimSequence4*>(OriginalSequence), Dst);
+}
+
 void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 {
 	guard(USkeleton::ConvertAnims);
@@ -509,13 +514,29 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 		return;
 	}
 
-	// create CAnimSequence
+	// create CAnimSequence, tracks will be decoded on demand
 	CAnimSequence *Dst = new CAnimSequence;
 	AnimSet->Sequences.Add(Dst);
 	Dst->Name      = Seq->Name;
 	Dst->NumFrames = Seq->NumFrames;
 	Dst->Rate      = Seq->NumFrames / Seq->SequenceLength * Seq->RateScale;
 	Dst->bAdditive = Seq->AdditiveAnimType != AAT_None;
+	Dst->DecodeFunc       = DecodeSequenceThunk;
+	Dst->DecodeOwner      = this;
+	Dst->OriginalSequence = Seq;
+	Dst->AnimSet          = AnimSet;
+
+	unguardf("Skel=%s Anim=%s", Name, Seq->Name);
+}
+
+void USkeleton::DecodeSequence(const UAnimSequence4* Seq, CAnimSequence* Dst)
+{
+	guard(USkeleton::DecodeSequence);
+
+	int NumTracks = Seq->GetNumTracks();
+	int offsetsPerBone = 4;
+	if (Seq->KeyEncodingFormat == AKF_PerTrackCompression)
+		offsetsPerBone = 2;
 
 	// bone tracks ...
 	Dst->Tracks.Empty(NumTracks);
@@ -1263,13 +1284,8 @@ void UAnimSequence4::PostLoad()
 {
 	guard(UAnimSequence4::PostLoad);
 	if (!Skeleton) return;		// missing package etc
+	// Animation data is not released after conversion: CAnimSequence tracks are decoded from it on demand
 	Skeleton->ConvertAnims(this);
-
-	// Release original animation data to save memory
-	RawAnimationData.Empty();
-	CompressedByteStream.Empty();
-	CompressedTrackOffsets.Empty();
-
 	unguard;
 }
 
@@ -16,9 +16,10 @@ class FObbFile : public FArchive
 {
 	DECLARE_ARCHIVE(FObbFile, FArchive);
 public:
-	FObbFile(const FObbEntry* info, FArchive* reader)
+	FObbFile(const FObbEntry* info, FArchive* reader, CMutex* readerLock)
 	:	Info(info)
 	,	Reader(reader)
+	,	ReaderLock(readerLock)
 	{}
 
 	virtual void Serialize(void *data, int size)
@@ -28,8 +29,11 @@ public:
 			appError("Serializing behind stopper (%X+%X > %X)", ArPos, size, ArStopper);
 		// seek every time in a case if the same 'Reader' was used by different FObbFile
 		// (this is a lightweight operation for buffered FArchive)
-		Reader->Seek64(Info->Pos + ArPos);
-		Reader->Serialize(data, size);
+		{
+			CScopedLock Lock(*ReaderLock);
+			Reader->Seek64(Info->Pos + ArPos);
+			Reader->Serialize(data, size);
+		}
 		ArPos += size;
 		unguard;
 	}
@@ -50,6 +54,7 @@ public:
 protected:
 	const FObbEntry* Info;
 	FArchive*	Reader;
+	CMutex*		ReaderLock;			// 'Reader' is shared between FObbFile instances
 };
 
 
@@ -131,19 +136,27 @@ public:
 	{
 		const FObbEntry* info = FindFile(name);
 		if (!info) return NULL;
-		return new FObbFile(info, Reader);
+		return new FObbFile(info, Reader, &ReaderLock);
+	}
+
+	virtual const char* GetFilename() const
+	{
+		return *Filename;
 	}
 
 protected:
 	FString				Filename;
 	FArchive*			Reader;
+	CMutex				ReaderLock;
 	TArray<FObbEntry>	FileInfos;
 	FObbEntry*			LastInfo;			// cached last accessed file info, simple optimization
 
 	const FObbEntry* FindFile(const char* name)
 	{
-		if (LastInfo && !stricmp(LastInfo->Name, name))
-			return LastInfo;
+		// copy the pointer, it could be changed by another thread
+		FObbEntry* last = LastInfo;
+		if (last && !stricmp(last->Name, name))
+			return last;
 
 		for (int i = 0; i < FileInfos.Num(); i++)
 		{
@@ -2,10 +2,22 @@
 #include "UnCore.h"
 #include "GameFileSystem.h"
 
+#include "Parallel.h"
+
 #include "UnArchivePak.h"
 
+#include <sys/stat.h>				// for stat()
+#if _WIN32
+#	include <process.h>			// for getpid()
+#else
+#	include <unistd.h>
+#endif
+
 #if UNREAL4
 
+bool GPakDeferAesKeyRequest = false;
+volatile bool GPakAesKeyRequested = false;
+
 FArchive& operator<<(FArchive& Ar, FPakInfo& P)
 {
 	// New FPakInfo fields.
@@ -236,9 +248,113 @@ void FPakEntry::DecodeFrom(const uint8* Data)
 	unguard;
 }
 
+void FPakFile::DecompressBlocks(int FirstBlock, int NumBlocks)
+{
+	guard(FPakFile::DecompressBlocks);
+
+	int BlockSize = Info->CompressionBlockSize;
+	if (UncompressedBufferCapacity < NumBlocks * BlockSize)
+	{
+		// Grow the buffer, it will be reused for all following reads of this file
+		if (UncompressedBuffer) appFree(UncompressedBuffer);
+		UncompressedBufferCapacity = NumBlocks * BlockSize;
+		UncompressedBuffer = (byte*)appMalloc(UncompressedBufferCapacity);
+	}
+	UncompressedBufferPos = BlockSize * FirstBlock;
+	UncompressedBufferSize = min(NumBlocks * BlockSize, (int)Info->UncompressedSize - UncompressedBufferPos); // don't pass file end
+
+	if (Info->bEncrypted)
+		PakRequireAesKey();				// could display UI, do that before going parallel
+
+	// Compute layout of compressed data. Blocks are normally stored one after another, so read
+	// them all with a single call. Otherwise, read them one-by-one.
+	const FPakCompressedBlock* Blocks = &Info->CompressionBlocks[FirstBlock];
+	int ReadAlign = Info->bEncrypted ? EncryptionAlign : 1;
+	int64 DataStart = Blocks[0].CompressedStart;
+	int64 DataEnd = DataStart;
+	bool bContiguous = true;
+	for (int i = 0; i < NumBlocks; i++)
+	{
+		const FPakCompressedBlock& Block = Blocks[i];
+		if (Block.CompressedStart < DataEnd)
+			bContiguous = false;
+		DataEnd = Block.CompressedStart + Align(Block.CompressedEnd - Block.CompressedStart, ReadAlign);
+	}
+	int TotalCompressedSize = 0;
+	for (int i = 0; i < NumBlocks; i++)
+		TotalCompressedSize += Align((int)(Blocks[i].CompressedEnd - Blocks[i].CompressedStart), ReadAlign);
+	// Avoid reading large gaps between blocks (should not happen in normal pak files)
+	if (bContiguous && (DataEnd - DataStart > TotalCompressedSize * 2))
+		bContiguous = false;
+
+	int CompressedBufferSize = bContiguous ? (int)(DataEnd - DataStart) : TotalCompressedSize;
+	byte* CompressedData = NULL;
+
+	// Memory-mapped pak file: decompress directly from the mapping, when no decryption is needed
+	const byte* MappedData = NULL;
+	if (bContiguous && !Info->bEncrypted && !appDecompressModifiesInput(Info->CompressionMethod))
+	{
+		FFileReader* FileReader = Reader->CastTo<FFileReader>();
+		if (FileReader)
+			MappedData = FileReader->GetMappedData(DataStart, CompressedBufferSize);
+	}
+
+	int BlockOffsets[MaxReadAheadBlocks];
+	if (bContiguous)
+	{
+		if (MappedData)
+		{
+			CompressedData = const_cast<byte*>(MappedData);
+		}
+		else
+		{
+			CompressedData = (byte*)appMalloc(CompressedBufferSize);
+			CScopedLock Lock(*ReaderLock);
+			Reader->Seek64(DataStart);
+			Reader->Serialize(CompressedData, CompressedBufferSize);
+		}
+		for (int i = 0; i < NumBlocks; i++)
+			BlockOffsets[i] = (int)(Blocks[i].CompressedStart - DataStart);
+	}
+	else
+	{
+		CompressedData = (byte*)appMalloc(CompressedBufferSize);
+		CScopedLock Lock(*ReaderLock);
+		int Offset = 0;
+		for (int i = 0; i < NumBlocks; i++)
+		{
+			int ReadSize = Align((int)(Blocks[i].CompressedEnd - Blocks[i].CompressedStart), ReadAlign);
+			Reader->Seek64(Blocks[i].CompressedStart);
+			Reader->Serialize(CompressedData + Offset, ReadSize);
+			BlockOffsets[i] = Offset;
+			Offset += ReadSize;
+		}
+	}
+
+	// Decrypt and decompress blocks in parallel. Note: 'Reader' is shared between FPakFile instances
+	// and it is not thread-safe, so all reading is performed above, under ReaderLock.
+	ParallelFor(NumBlocks, [this, Blocks, CompressedData, &BlockOffsets, FirstBlock, BlockSize](int i)
+		{
+			const FPakCompressedBlock& Block = Blocks[i];
+			int CompressedBlockSize = (int)(Block.CompressedEnd - Block.CompressedStart);
+			byte* Src = CompressedData + BlockOffsets[i];
+			if (Info->bEncrypted)
+				appDecryptAES(Src, Align(CompressedBlockSize, EncryptionAlign));
+			int BlockPos = BlockSize * (FirstBlock + i);
+			int UncompressedBlockSize = min(BlockSize, (int)Info->UncompressedSize - BlockPos);
+			appDecompress(Src, CompressedBlockSize, UncompressedBuffer + BlockSize * i, UncompressedBlockSize, Info->CompressionMethod);
+		});
+
+	if (!MappedData)
+		appFree(CompressedData);
+
+	unguardf("block=%d/%d", FirstBlock, NumBlocks);
+}
+
 void FPakFile::Serialize(void *data, int size)
 {
 	guard(FPakFile::Serialize);
+	ArPos += ConsumeFastWindow();
 	if (ArStopper > 0 && ArPos + size > ArStopper)
 		appError("Serializing behind stopper (%X+%X > %X)", ArPos, size, ArStopper);
 
@@ -248,42 +364,27 @@ void FPakFile::Serialize(void *data, int size)
 
 		while (size > 0)
 		{
-			if ((UncompressedBuffer == NULL) || (ArPos < UncompressedBufferPos) || (ArPos >= UncompressedBufferPos + Info->CompressionBlockSize))
+			if ((UncompressedBuffer == NULL) || (ArPos < UncompressedBufferPos) || (ArPos >= UncompressedBufferPos + UncompressedBufferSize))
 			{
 				// buffer is not ready
-				if (UncompressedBuffer == NULL)
-				{
-					UncompressedBuffer = (byte*)appMalloc((int)Info->CompressionBlockSize); // size of uncompressed block
-				}
-				// prepare buffer
 				int BlockIndex = ArPos / Info->CompressionBlockSize;
-				UncompressedBufferPos = Info->CompressionBlockSize * BlockIndex;
-
-				const FPakCompressedBlock& Block = Info->CompressionBlocks[BlockIndex];
-				int CompressedBlockSize = (int)(Block.CompressedEnd - Block.CompressedStart);
-				int UncompressedBlockSize = min((int)Info->CompressionBlockSize, (int)Info->UncompressedSize - UncompressedBufferPos); // don't pass file end
-				byte* CompressedData;
-				if (!Info->bEncrypted)
+				// Detect sequential reading: requested block immediately follows previously decompressed data.
+				// In this case, decompress several blocks at once, increasing the number of blocks every time
+				// when reading continues. Random access drops read-ahead back to a single block.
+				if (UncompressedBuffer && (UncompressedBufferPos + UncompressedBufferSize == BlockIndex * Info->CompressionBlockSize))
 				{
-					CompressedData = (byte*)appMalloc(CompressedBlockSize);
-					Reader->Seek64(Block.CompressedStart);
-					Reader->Serialize(CompressedData, CompressedBlockSize);
+					ReadAheadBlocks = min(ReadAheadBlocks * 2, (int)MaxReadAheadBlocks);
 				}
 				else
 				{
-					int EncryptedSize = Align(CompressedBlockSize, EncryptionAlign);
-					CompressedData = (byte*)appMalloc(EncryptedSize);
-					Reader->Seek64(Block.CompressedStart);
-					Reader->Serialize(CompressedData, EncryptedSize);
-					PakRequireAesKey();
-					appDecryptAES(CompressedData, EncryptedSize);
+					ReadAheadBlocks = 1;
 				}
-				appDecompress(CompressedData, CompressedBlockSize, UncompressedBuffer, UncompressedBlockSize, Info->CompressionMethod);
-				appFree(CompressedData);
+				int NumBlocks = min(ReadAheadBlocks, Info->CompressionBlocks.Num() - BlockIndex);
+				DecompressBlocks(BlockIndex, NumBlocks);
 			}
 
 			// data is in buffer, copy it
-			int BytesToCopy = UncompressedBufferPos + Info->CompressionBlockSize - ArPos; // number of bytes until end of the buffer
+			int BytesToCopy = UncompressedBufferPos + UncompressedBufferSize - ArPos; // number of bytes until end of the buffer
 			if (BytesToCopy > size) BytesToCopy = size;
 			assert(BytesToCopy > 0);
 
@@ -316,12 +417,15 @@ void FPakFile::Serialize(void *data, int size)
 				// Should fetch block and decrypt it.
 				// Note: AES is block encryption, so we should always align read requests for correct decryption.
 				UncompressedBufferPos = ArPos & ~(EncryptionAlign - 1);
-				Reader->Seek64(Info->Pos + Info->StructSize + UncompressedBufferPos);
 				int RemainingSize = Info->Size - UncompressedBufferPos;
 				if (RemainingSize > EncryptedBufferSize)
 					RemainingSize = EncryptedBufferSize;
 				RemainingSize = Align(RemainingSize, EncryptionAlign); // align for AES, pak contains aligned data
-				Reader->Serialize(UncompressedBuffer, RemainingSize);
+				{
+					CScopedLock Lock(*ReaderLock);
+					Reader->Seek64(Info->Pos + Info->StructSize + UncompressedBufferPos);
+					Reader->Serialize(UncompressedBuffer, RemainingSize);
+				}
 				PakRequireAesKey();
 				appDecryptAES(UncompressedBuffer, RemainingSize);
 			}
@@ -350,15 +454,39 @@ void FPakFile::Serialize(void *data, int size)
 		// Pure data
 		// seek every time in a case if the same 'Reader' was used by different FPakFile
 		// (this is a lightweight operation for buffered FArchive)
-		Reader->Seek64(Info->Pos + Info->StructSize + ArPos);
-		Reader->Serialize(data, size);
+		{
+			CScopedLock Lock(*ReaderLock);
+			Reader->Seek64(Info->Pos + Info->StructSize + ArPos);
+			Reader->Serialize(data, size);
+		}
 		ArPos += size;
 
 		unguard;
 	}
+	UpdateFastWindow();
 	unguardf("file=%s", Info->Name);
 }
 
+void FPakFile::UpdateFastWindow()
+{
+	// Uncompressed unencrypted files are read directly from the shared 'Reader', there's no own buffer
+	if (!UncompressedBuffer || (!Info->CompressionMethod && !Info->bEncrypted))
+	{
+		ResetFastWindow();
+		return;
+	}
+	int BufferEnd = Info->CompressionMethod
+		? UncompressedBufferPos + UncompressedBufferSize
+		: min(UncompressedBufferPos + (int)EncryptedBufferSize, (int)Info->UncompressedSize);
+	if (ArStopper > 0 && ArStopper < BufferEnd)
+		BufferEnd = ArStopper;
+
+	if (ArPos >= UncompressedBufferPos && ArPos < BufferEnd)
+		SetFastWindow(UncompressedBuffer + ArPos - UncompressedBufferPos, BufferEnd - ArPos);
+	else
+		ResetFastWindow();
+}
+
 
 
 void FPakVFS::CompactFilePath(FString& Path)
@@ -404,6 +532,13 @@ bool FPakVFS::AttachReader(FArchive* reader, FString& error)
 
 	guard(FPakVFS::ReadDirectory);
 
+	// The directory could be already decoded in previous run
+	if (LoadFromIndexCache(reader))
+	{
+		PrintInfo(reader->ArLicenseeVer >> 4);
+		return true;
+	}
+
 	// Pak file may have different header sizes, try them all
 	static const int OffsetsToTry[] = { FPakInfo::Size, FPakInfo::Size8, FPakInfo::Size8a, FPakInfo::Size9 };
 	FPakInfo info;
@@ -474,13 +609,8 @@ bool FPakVFS::AttachReader(FArchive* reader, FString& error)
 
 	if (result)
 	{
-		// Print statistics
-		appPrintf("Pak %s: %d files", *Filename, FileInfos.Num());
-		if (NumEncryptedFiles)
-			appPrintf(" (%d encrypted)", NumEncryptedFiles);
-		if (strcmp(*MountPoint, "/") != 0)
-			appPrintf(", mount point: \"%s\"", *MountPoint);
-		appPrintf(", version %d\n", info.Version);
+		AddToIndexCache();
+		PrintInfo(info.Version);
 	}
 
 	return result;
@@ -488,6 +618,17 @@ bool FPakVFS::AttachReader(FArchive* reader, FString& error)
 	unguardf("PakVer=%d.%d", mainVer, subVer);
 }
 
+void FPakVFS::PrintInfo(int Version) const
+{
+	// Print statistics
+	appPrintf("Pak %s: %d files", *Filename, FileInfos.Num());
+	if (NumEncryptedFiles)
+		appPrintf(" (%d encrypted)", NumEncryptedFiles);
+	if (strcmp(*MountPoint, "/") != 0)
+		appPrintf(", mount point: \"%s\"", *MountPoint);
+	appPrintf(", version %d\n", Version);
+}
+
 static bool ValidateString(FArchive& Ar)
 {
 	// We're operating with index data, which is definitely less than 2Gb of size, so use Tell instead of Tell64.
@@ -888,8 +1029,10 @@ bool FPakVFS::LoadPakIndex(FArchive* reader, const FPakInfo& info, FString& erro
 
 const FPakEntry* FPakVFS::FindFile(const char* name)
 {
-	if (LastInfo && !stricmp(LastInfo->Name, name))
-		return LastInfo;
+	// copy the pointer, it could be changed by another thread
+	FPakEntry* Last = LastInfo;
+	if (Last && !stricmp(Last->Name, name))
+		return Last;
 
 	if (HashTable)
 	{
@@ -919,4 +1062,456 @@ const FPakEntry* FPakVFS::FindFile(const char* name)
 	return NULL;
 }
 
+
+/*-----------------------------------------------------------------------------
+	Pak index cache
+-----------------------------------------------------------------------------*/
+
+// Decoded directories of all pak files found in the game directory are stored in a single
+// file, so the next start will not need to read and decrypt pak indices. The file consists
+// of structures which are using offsets instead of pointers; every structure is serialized
+// field by field, so the file layout doesn't depend on compiler and platform. String data is
+// used directly from memory (mapped when possible). Pak files are identified by path, size,
+// modification time and AES key hash. Only records are parsed when the cache is loaded, entries
+// of a pak file are decoded from the cache data when the pak file is mounted.
+
+#define PAK_CACHE_MAGIC			0x43504D55		// "UMPC"
+#define PAK_CACHE_VERSION		2
+
+// Serialized sizes of cache structures
+#define PAK_CACHE_HEADER_SIZE	32
+#define PAK_CACHE_RECORD_SIZE	48
+#define PAK_CACHE_ENTRY_SIZE	47
+#define PAK_CACHE_BLOCK_SIZE	16
+
+struct FPakCacheHeader
+{
+	uint32		Magic;
+	int32		Version;
+	int64		FileSize;					// used for detection of truncated files
+	int32		NumPaks;
+	int32		NumEntries;
+	int32		NumBlocks;
+	int32		StringsSize;
+	// followed by FPakCacheRecord[NumPaks], FPakCacheEntry[NumEntries],
+	// FPakCompressedBlock[NumBlocks] and null-terminated strings
+
+	friend FArchive& operator<<(FArchive& Ar, FPakCacheHeader& H)
+	{
+		return Ar << H.Magic << H.Version << H.FileSize << H.NumPaks << H.NumEntries << H.NumBlocks << H.StringsSize;
+	}
+};
+
+struct FPakCacheRecord
+{
+	int64		FileSize;
+	int64		FileTime;
+	uint32		AesKeyHash;
+	int32		Game;
+	int32		PathOffset;					// offset in string data
+	int32		MountPointOffset;
+	int32		ArLicenseeVer;
+	int32		NumEncryptedFiles;
+	int32		FirstEntry;
+	int32		NumEntries;
+
+	friend FArchive& operator<<(FArchive& Ar, FPakCacheRecord& R)
+	{
+		return Ar << R.FileSize << R.FileTime << R.AesKeyHash << R.Game << R.PathOffset << R.MountPointOffset
+			<< R.ArLicenseeVer << R.NumEncryptedFiles << R.FirstEntry << R.NumEntries;
+	}
+};
+
+struct FPakCacheEntry
+{
+	int64		Pos;
+	int64		Size;
+	int64		UncompressedSize;
+	int32		NameOffset;
+	int32		CompressionMethod;
+	int32		CompressionBlockSize;
+	int32		FirstBlock;
+	int32		NumBlocks;
+	uint16		StructSize;
+	byte		bEncrypted;
+
+	friend FArchive& operator<<(FArchive& Ar, FPakCacheEntry& E)
+	{
+		return Ar << E.Pos << E.Size << E.UncompressedSize << E.NameOffset << E.CompressionMethod
+			<< E.CompressionBlockSize << E.FirstBlock << E.NumBlocks << E.StructSize << E.bEncrypted;
+	}
+};
+
+FString GPakIndexCacheDir;
+
+static FString PakCacheFilename;
+// Loaded cache, PakCacheStrings is NULL when there's no valid cache
+static TArray<FPakCacheRecord> PakCacheRecords;
+static TArray<int> PakCacheRecordHash;		// heads of record chains, indexed by hash of pak file path
+static TArray<int> PakCacheRecordNext;		// next record with the same hash, -1 for the end of chain
+static const byte* PakCacheData = NULL;		// whole cache file
+static int PakCacheNumEntries = 0;
+static int PakCacheNumBlocks = 0;
+static int PakCacheEntriesOffset = 0;		// serialized FPakCacheEntry[PakCacheNumEntries]
+static int PakCacheBlocksOffset = 0;		// serialized FPakCompressedBlock[PakCacheNumBlocks]
+static const char* PakCacheStrings = NULL;
+static int PakCacheStringsSize = 0;
+static byte* PakCacheBuffer = NULL;			// memory for PakCacheData when file is not mapped
+static CMappedFile* PakCacheMapping = NULL;
+static TArray<FPakVFS*> PakCacheMountedPaks;	// pak files which will be stored to the cache
+static bool PakCacheDirty = false;
+static CMutex PakCacheLock;
+
+static uint32 PakCacheHash(const char* s, int Len, bool bIgnoreCase)
+{
+	// FNV-1a
+	uint32 Hash = 2166136261u;
+	for (int i = 0; i < Len; i++)
+	{
+		char c = s[i];
+		if (bIgnoreCase && c >= 'A' && c <= 'Z') c += 'a' - 'A';
+		Hash = (Hash ^ (byte)c) * 16777619u;
+	}
+	return Hash;
+}
+
+FString GetIndexCacheFilename(const char* Prefix, const char* RootDirectory)
+{
+	FString Result;
+	if (!GPakIndexCacheDir.IsEmpty())
+	{
+		char Buffer[MAX_PACKAGE_PATH];
+		appSprintf(ARRAY_ARG(Buffer), "%s/%s_%08X.bin", *GPakIndexCacheDir, Prefix, PakCacheHash(RootDirectory, strlen(RootDirectory), true));
+		Result = Buffer;
+	}
+	return Result;
+}
+
+void LoadPakIndexCache(const char* RootDirectory)
+{
+	guard(LoadPakIndexCache);
+
+	if (GPakIndexCacheDir.IsEmpty()) return;
+	assert(!PakCacheStrings);
+
+	PakCacheFilename = GetIndexCacheFilename("pakindex", RootDirectory);
+	PakCacheDirty = false;
+
+	FFileReader Ar(*PakCacheFilename, FAO_NoOpenError);
+	if (!Ar.IsOpen()) return;
+
+	int64 Size = Ar.GetFileSize64();
+	if (Size < PAK_CACHE_HEADER_SIZE || Size > 0x7FFFFFFF) return;
+
+	const byte* Data = Ar.GetMappedData(0, (int)Size);
+	if (Data)
+	{
+		PakCacheMapping = Ar.GetMapping();
+		PakCacheMapping->AddRef();
+	}
+	else
+	{
+		PakCacheBuffer = (byte*)appMalloc((int)Size);
+		Ar.Serialize(PakCacheBuffer, (int)Size);
+		Data = PakCacheBuffer;
+	}
+
+	// Validate the file
+	FMemReader Reader(Data, (int)Size);
+	FPakCacheHeader Hdr;
+	Reader << Hdr;
+	bool bValid = (Hdr.Magic == PAK_CACHE_MAGIC && Hdr.Version == PAK_CACHE_VERSION && Hdr.FileSize == Size &&
+		Hdr.NumPaks >= 0 && Hdr.NumEntries >= 0 && Hdr.NumBlocks >= 0 && Hdr.StringsSize > 0);
+	if (bValid)
+	{
+		int64 ExpectedSize = PAK_CACHE_HEADER_SIZE + (int64)Hdr.NumPaks * PAK_CACHE_RECORD_SIZE +
+			(int64)Hdr.NumEntries * PAK_CACHE_ENTRY_SIZE + (int64)Hdr.NumBlocks * PAK_CACHE_BLOCK_SIZE + Hdr.StringsSize;
+		bValid = (ExpectedSize == Size) && (Data[Size - 1] == 0);
+	}
+
+	if (bValid)
+	{
+		PakCacheRecords.AddUninitialized(Hdr.NumPaks);
+		for (FPakCacheRecord& R : PakCacheRecords)
+			Reader << R;
+		PakCacheData = Data;
+		PakCacheNumEntries = Hdr.NumEntries;
+		PakCacheNumBlocks = Hdr.NumBlocks;
+		PakCacheEntriesOffset = Reader.Tell();
+		PakCacheBlocksOffset = PakCacheEntriesOffset + Hdr.NumEntries * PAK_CACHE_ENTRY_SIZE;
+		PakCacheStrings = (const char*)Data + PakCacheBlocksOffset + Hdr.NumBlocks * PAK_CACHE_BLOCK_SIZE;
+		PakCacheStringsSize = Hdr.StringsSize;
+
+		// Hash records by path, so mounting of every pak file will not scan all records
+		int HashSize = 16;
+		while (HashSize < Hdr.NumPaks) HashSize *= 2;
+		PakCacheRecordHash.AddUninitialized(HashSize);
+		for (int i = 0; i < HashSize; i++)
+			PakCacheRecordHash[i] = -1;
+		PakCacheRecordNext.AddUninitialized(Hdr.NumPaks);
+		for (int i = 0; i < Hdr.NumPaks; i++)
+		{
+			const FPakCacheRecord& R = PakCacheRecords[i];
+			if ((unsigned)R.PathOffset >= (unsigned)PakCacheStringsSize)
+			{
+				PakCacheRecordNext[i] = -1;		// corrupted record, never found
+				continue;
+			}
+			const char* Path = PakCacheStrings + R.PathOffset;
+			int Bucket = PakCacheHash(Path, strlen(Path), false) & (HashSize - 1);
+			PakCacheRecordNext[i] = PakCacheRecordHash[Bucket];
+			PakCacheRecordHash[Bucket] = i;
+		}
+	}
+	else
+	{
+		appPrintf("WARNING: ignoring bad pak index cache %s\n", *PakCacheFilename);
+		SavePakIndexCache();		// release data
+		PakCacheDirty = true;		// overwrite the file
+	}
+
+	unguard;
+}
+
+bool FPakVFS::LoadFromIndexCache(FArchive* reader)
+{
+	guard(FPakVFS::LoadFromIndexCache);
+
+	if (GPakIndexCacheDir.IsEmpty()) return false;
+
+	// Compute the key
+#if _WIN32
+	struct _stati64 Buf;
+	if (_stati64(*Filename, &Buf) != 0) return false;
+#else
+	struct stat64 Buf;
+	if (stat64(*Filename, &Buf) != 0) return false;
+#endif
+	CacheKey.FileSize = reader->GetFileSize64();
+	CacheKey.FileTime = Buf.st_mtime;
+	CacheKey.AesKeyHash = PakCacheHash(*GAesKey, GAesKey.Len(), false);
+	CacheKey.Game = GForceGame;
+	CacheKeyValid = true;
+
+	if (!PakCacheStrings) return false;
+
+	// Find a record for this file
+	const char* Strings = PakCacheStrings;
+	const FPakCacheRecord* Rec = NULL;
+	int Bucket = PakCacheHash(*Filename, Filename.Len(), false) & (PakCacheRecordHash.Num() - 1);
+	for (int Index = PakCacheRecordHash[Bucket]; Index >= 0; Index = PakCacheRecordNext[Index])
+	{
+		const FPakCacheRecord& R = PakCacheRecords[Index];
+		if (R.FileSize == CacheKey.FileSize && R.FileTime == CacheKey.FileTime && R.AesKeyHash == CacheKey.AesKeyHash &&
+			R.Game == CacheKey.Game && !strcmp(Strings + R.PathOffset, *Filename))
+		{
+			Rec = &R;
+			break;
+		}
+	}
+	if (!Rec) return false;
+	if (Rec->FirstEntry < 0 || Rec->NumEntries < 0 || Rec->FirstEntry + Rec->NumEntries > PakCacheNumEntries ||
+		(unsigned)Rec->MountPointOffset >= (unsigned)PakCacheStringsSize)
+	{
+		return false;
+	}
+
+	// Fill the directory directly from the cache data
+	MountPoint = Strings + Rec->MountPointOffset;
+	NumEncryptedFiles = Rec->NumEncryptedFiles;
+	FileInfos.AddZeroed(Rec->NumEntries);
+	TArray<const char*> Names;
+	Names.AddUninitialized(Rec->NumEntries);
+	FMemReader EntryReader(PakCacheData, PakCacheBlocksOffset + PakCacheNumBlocks * PAK_CACHE_BLOCK_SIZE);
+	FMemReader BlockReader(PakCacheData + PakCacheBlocksOffset, PakCacheNumBlocks * PAK_CACHE_BLOCK_SIZE);
+	EntryReader.Seek(PakCacheEntriesOffset + Rec->FirstEntry * PAK_CACHE_ENTRY_SIZE);
+	for (int i = 0; i < Rec->NumEntries; i++)
+	{
+		FPakCacheEntry S;
+		EntryReader << S;
+		if ((unsigned)S.NameOffset >= (unsigned)PakCacheStringsSize || S.FirstBlock < 0 || S.NumBlocks < 0 ||
+			S.FirstBlock + S.NumBlocks > PakCacheNumBlocks)
+		{
+			// Corrupted cache, read the pak file index instead
+			FileInfos.Empty();
+			return false;
+		}
+		FPakEntry& E = FileInfos[i];
+		Names[i] = Strings + S.NameOffset;
+		E.Pos = S.Pos;
+		E.Size = S.Size;
+		E.UncompressedSize = S.UncompressedSize;
+		E.CompressionMethod = S.CompressionMethod;
+		E.CompressionBlockSize = S.CompressionBlockSize;
+		E.bEncrypted = S.bEncrypted;
+		E.StructSize = S.StructSize;
+		if (S.NumBlocks)
+		{
+			BlockReader.Seek(S.FirstBlock * PAK_CACHE_BLOCK_SIZE);
+			E.CompressionBlocks.AddUninitialized(S.NumBlocks);
+			for (FPakCompressedBlock& B : E.CompressionBlocks)
+				BlockReader << B;
+		}
+	}
+	// Names are referencing cache data which will be released, copy them to the string pool at once
+	appStrdupPoolBatch(Names.GetData(), Names.Num());
+	for (int i = 0; i < Rec->NumEntries; i++)
+		FileInfos[i].Name = Names[i];
+	if (FileInfos.Num() >= MIN_PAK_SIZE_FOR_HASHING)
+	{
+		for (FPakEntry& E : FileInfos)
+		{
+			AddFileToHash(&E);
+		}
+	}
+
+	reader->ArLicenseeVer = Rec->ArLicenseeVer;
+	Reader = reader;
+
+	CScopedLock Lock(PakCacheLock);
+	PakCacheMountedPaks.Add(this);
+	return true;
+
+	unguard;
+}
+
+void FPakVFS::AddToIndexCache()
+{
+	if (!CacheKeyValid) return;
+	CScopedLock Lock(PakCacheLock);
+	PakCacheMountedPaks.Add(this);
+	PakCacheDirty = true;
+}
+
+void SavePakIndexCache()
+{
+	guard(SavePakIndexCache);
+
+	if (PakCacheDirty && PakCacheMountedPaks.Num())
+	{
+		TArray<FPakCacheRecord> Records;
+		TArray<FPakCacheEntry> Entries;
+		TArray<FPakCompressedBlock> Blocks;
+		TArray<char> Strings;
+
+		auto AddString = [&Strings](const char* s) -> int
+		{
+			int Offset = Strings.Num();
+			int Len = strlen(s) + 1;
+			Strings.AddUninitialized(Len);
+			memcpy(&Strings[Offset], s, Len);
+			return Offset;
+		};
+
+		int TotalEntries = 0;
+		for (const FPakVFS* Pak : PakCacheMountedPaks)
+			TotalEntries += Pak->FileInfos.Num();
+		Records.Reserve(PakCacheMountedPaks.Num());
+		Entries.Reserve(TotalEntries);
+		Strings.Reserve(TotalEntries * 64);
+
+		for (const FPakVFS* Pak : PakCacheMountedPaks)
+		{
+			FPakCacheRecord& R = Records[Records.AddZeroed()];
+			R.FileSize = Pak->CacheKey.FileSize;
+			R.FileTime = Pak->CacheKey.FileTime;
+			R.AesKeyHash = Pak->CacheKey.AesKeyHash;
+			R.Game = Pak->CacheKey.Game;
+			R.PathOffset = AddString(*Pak->Filename);
+			R.MountPointOffset = AddString(*Pak->MountPoint);
+			R.ArLicenseeVer = Pak->Reader->ArLicenseeVer;
+			R.NumEncryptedFiles = Pak->NumEncryptedFiles;
+			R.FirstEntry = Entries.Num();
+			R.NumEntries = Pak->FileInfos.Num();
+			for (const FPakEntry& E : Pak->FileInfos)
+			{
+				FPakCacheEntry& D = Entries[Entries.AddZeroed()];
+				D.Pos = E.Pos;
+				D.Size = E.Size;
+				D.UncompressedSize = E.UncompressedSize;
+				D.NameOffset = AddString(E.Name);
+				D.CompressionMethod = E.CompressionMethod;
+				D.CompressionBlockSize = E.CompressionBlockSize;
+				D.FirstBlock = Blocks.Num();
+				D.NumBlocks = E.CompressionBlocks.Num();
+				D.StructSize = E.StructSize;
+				D.bEncrypted = E.bEncrypted;
+				if (D.NumBlocks)
+				{
+					if (Blocks.Num() + D.NumBlocks > Blocks.Max())
+						Blocks.Reserve((Blocks.Num() + D.NumBlocks) * 2);
+					int Index = Blocks.AddUninitialized(D.NumBlocks);
+					memcpy(&Blocks[Index], E.CompressionBlocks.GetData(), D.NumBlocks * sizeof(FPakCompressedBlock));
+				}
+			}
+		}
+
+		FPakCacheHeader Hdr;
+		Hdr.Magic = PAK_CACHE_MAGIC;
+		Hdr.Version = PAK_CACHE_VERSION;
+		Hdr.NumPaks = Records.Num();
+		Hdr.NumEntries = Entries.Num();
+		Hdr.NumBlocks = Blocks.Num();
+		Hdr.StringsSize = Strings.Num();
+		Hdr.FileSize = PAK_CACHE_HEADER_SIZE + (int64)Records.Num() * PAK_CACHE_RECORD_SIZE + (int64)Entries.Num() * PAK_CACHE_ENTRY_SIZE +
+			(int64)Blocks.Num() * PAK_CACHE_BLOCK_SIZE + Strings.Num();
+
+		// Write to a temporary file and rename it, so other umodel processes will never see a partially written cache
+		char TempName[MAX_PACKAGE_PATH];
+		appSprintf(ARRAY_ARG(TempName), "%s.%d", *PakCacheFilename, getpid());
+		appMakeDirectoryForFile(TempName);
+		FFileWriter* Ar = new FFileWriter(TempName, FAO_NoOpenError);
+		if (Ar->IsOpen())
+		{
+			*Ar << Hdr;
+			for (FPakCacheRecord& R : Records)
+				*Ar << R;
+			for (FPakCacheEntry& E : Entries)
+				*Ar << E;
+			for (FPakCompressedBlock& B : Blocks)
+				*Ar << B;
+			Ar->Serialize(Strings.GetData(), Strings.Num());
+			assert(Ar->Tell64() == Hdr.FileSize);
+			delete Ar;
+			// Release the old file before replacing it
+			if (PakCacheMapping)
+			{
+				PakCacheMapping->Release();
+				PakCacheMapping = NULL;
+			}
+			remove(*PakCacheFilename);	// rename() doesn't overwrite files on Windows
+			if (rename(TempName, *PakCacheFilename) != 0)
+				remove(TempName);
+		}
+		else
+		{
+			delete Ar;
+			appPrintf("WARNING: unable to write pak index cache %s\n", TempName);
+		}
+	}
+
+	// Release loaded data
+	PakCacheRecords.Empty();
+	PakCacheRecordHash.Empty();
+	PakCacheRecordNext.Empty();
+	PakCacheData = NULL;
+	PakCacheNumEntries = PakCacheNumBlocks = 0;
+	PakCacheStrings = NULL;
+	PakCacheStringsSize = 0;
+	if (PakCacheMapping)
+	{
+		PakCacheMapping->Release();
+		PakCacheMapping = NULL;
+	}
+	if (PakCacheBuffer)
+	{
+		appFree(PakCacheBuffer);
+		PakCacheBuffer = NULL;
+	}
+	PakCacheMountedPaks.Empty();
+	PakCacheDirty = false;
+
+	unguard;
+}
+
 #endif // UNREAL4
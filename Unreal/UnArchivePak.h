@@ -102,8 +102,21 @@ struct FPakEntry
 	}
 };
 
+// Set while pak files are mounted or packages are scanned with ParallelFor(). UE4EncryptedPak()
+// could display UI, so the key is not requested at this time, GPakAesKeyRequested is set instead,
+// and files which requires a key are processed once again from the main thread.
+extern bool GPakDeferAesKeyRequest;
+extern volatile bool GPakAesKeyRequested;
+
 inline bool PakRequireAesKey(bool fatal = true)
 {
+	if (GAesKey.Len() == 0 && GPakDeferAesKeyRequest)
+	{
+		GPakAesKeyRequested = true;
+		if (fatal)
+			appError("AES key is required");
+		return false;
+	}
 	if ((GAesKey.Len() == 0) && !UE4EncryptedPak())
 	{
 		if (fatal)
@@ -117,10 +130,13 @@ class FPakFile : public FArchive
 {
 	DECLARE_ARCHIVE(FPakFile, FArchive);
 public:
-	FPakFile(const FPakEntry* info, FArchive* reader)
+	FPakFile(const FPakEntry* info, FArchive* reader, CMutex* readerLock)
 	:	Info(info)
 	,	Reader(reader)
+	,	ReaderLock(readerLock)
 	,	UncompressedBuffer(NULL)
+	,	UncompressedBufferCapacity(0)
+	,	ReadAheadBlocks(1)
 	{}
 
 	virtual ~FPakFile()
@@ -136,34 +152,66 @@ public:
 		guard(FPakFile::Seek);
 		assert(Pos >= 0 && Pos < Info->UncompressedSize);
 		ArPos = Pos;
+		UpdateFastWindow();
 		unguardf("file=%s", Info->Name);
 	}
 
+	virtual int Tell() const
+	{
+		return ArPos + GetFastWindowConsumed();
+	}
+
 	virtual int GetFileSize() const
 	{
 		return (int)Info->UncompressedSize;
 	}
 
+	virtual void SetStopper(int Pos)
+	{
+		ArPos += ConsumeFastWindow();
+		ArStopper = Pos;
+		UpdateFastWindow();
+	}
+
 	virtual void Close()
 	{
+		ArPos += ConsumeFastWindow();
+		ResetFastWindow();
 		if (UncompressedBuffer)
 		{
 			appFree(UncompressedBuffer);
 			UncompressedBuffer = NULL;
+			UncompressedBufferCapacity = 0;
 		}
 	}
 
 protected:
 	const FPakEntry* Info;
 	FArchive*	Reader;
+	CMutex*		ReaderLock;					// 'Reader' is shared between FPakFile instances
 	byte*		UncompressedBuffer;
 	int			UncompressedBufferPos;
+	int			UncompressedBufferSize;		// amount of valid data in UncompressedBuffer (compressed files only)
+	int			UncompressedBufferCapacity;
+	int			ReadAheadBlocks;			// number of compression blocks to decompress at once
 
 	enum { EncryptionAlign = 16 }; // AES-specific constant
 	enum { EncryptedBufferSize = 256 }; //?? TODO: check - may be value 16 will be better for performance
+	enum { MaxReadAheadBlocks = 8 };
+
+	// Read and decompress a range of compression blocks into UncompressedBuffer
+	void DecompressBlocks(int FirstBlock, int NumBlocks);
+	// Expose decompressed or decrypted data as inline read window
+	void UpdateFastWindow();
 };
 
 
+// Load cached indices for the game directory, should be called before mounting pak files
+void LoadPakIndexCache(const char* RootDirectory);
+// Store indices of all mounted pak files when any of them was missing in the cache, and
+// release the loaded cache
+void SavePakIndexCache();
+
 class FPakVFS : public FVirtualFileSystem
 {
 public:
@@ -173,6 +221,7 @@ public:
 	,	LastInfo(NULL)
 	,	HashTable(NULL)
 	,	NumEncryptedFiles(0)
+	,	CacheKeyValid(false)
 	{}
 
 	virtual ~FPakVFS()
@@ -208,7 +257,12 @@ public:
 	{
 		const FPakEntry* info = FindFile(name);
 		if (!info) return NULL;
-		return new FPakFile(info, Reader);
+		return new FPakFile(info, Reader, &ReaderLock);
+	}
+
+	virtual const char* GetFilename() const
+	{
+		return *Filename;
 	}
 
 protected:
@@ -218,6 +272,7 @@ protected:
 
 	FString				Filename;
 	FArchive*			Reader;
+	CMutex				ReaderLock;
 	TArray<FPakEntry>	FileInfos;
 	FPakEntry*			LastInfo;			// cached last accessed file info, simple optimization
 	FPakEntry**			HashTable;
@@ -225,12 +280,28 @@ protected:
 	int					NumEncryptedFiles;
 
 	void ValidateMountPoint(FString& MountPoint);
+	void PrintInfo(int Version) const;
 
 	// UE4.24 and older
 	bool LoadPakIndexLegacy(FArchive* reader, const FPakInfo& info, FString& error);
 	// UE4.25 and newer
 	bool LoadPakIndex(FArchive* reader, const FPakInfo& info, FString& error);
 
+	// Pak index cache
+	struct FPakCacheKey
+	{
+		int64			FileSize;
+		int64			FileTime;
+		uint32			AesKeyHash;
+		int32			Game;
+	};
+	FPakCacheKey		CacheKey;
+	bool				CacheKeyValid;
+
+	bool LoadFromIndexCache(FArchive* reader);
+	void AddToIndexCache();
+	friend void SavePakIndexCache();
+
 	static uint16 GetHashForFileName(const char* FileName)
 	{
 		uint16 hash = 0;
@@ -1,5 +1,6 @@
 #include "Core.h"
 #include "UnCore.h"
+#include "Parallel.h"
 
 
 int  GForceGame           = GAME_UNKNOWN;
@@ -455,113 +456,193 @@ void FString::TrimStartAndEndInline()
 	FName (string) pool
 -----------------------------------------------------------------------------*/
 
-#define STRING_HASH_SIZE		(65536*4)		// 1Mb of 32-bit pointers
+#define STRING_POOL_INITIAL_SIZE	65536		// number of slots, should be power of 2
 
-struct CStringPoolEntry
-{
-	CStringPoolEntry*	HashNext;
-	uint16				Length;
-	char				Str[1];
-};
+CStringPool::CStringPool()
+:	Slots(NULL)
+,	Mask(0)
+,	Count(0)
+,	Chain(NULL)
+{}
 
-static CStringPoolEntry* StringHashTable[STRING_HASH_SIZE];
-static CMemoryChain* StringPool;
+CStringPool::~CStringPool()
+{
+	delete[] Slots;
+	delete Chain;
+}
 
-const char* appStrdupPool(const char* str)
+uint32 CStringPool::Hash(const char* str, int len)
 {
-	int len = strlen(str);
-	unsigned int hash = 0;
-	for (int i = 0; i < len; i++)
+	// MurmurHash3 (32-bit), processing 4 bytes at time
+	const byte* p = (const byte*)str;
+	uint32 h = len;
+	uint32 k;
+	for ( ; len >= 4; len -= 4, p += 4)
 	{
-		char c = str[i];
-		hash = ROL32(hash, 1) + c;
+		memcpy(&k, p, 4);
+		k *= 0xCC9E2D51;
+		k = ROL32(k, 15);
+		k *= 0x1B873593;
+		h ^= k;
+		h = ROL32(h, 13);
+		h = h * 5 + 0xE6546B64;
 	}
-	hash &= (STRING_HASH_SIZE - 1);
-
-#if 0
-	if (true)
+	k = 0;
+	switch (len)
 	{
-		// Compare "Length" and first 2 characters with single operation
-		uint32 cmp = len | (str[0] << 16) | (str[1] << 24);
-		for (const CStringPoolEntry* s = StringHashTable[hash]; s; s = s->HashNext)
-		{
-			uint32 cmp2 = *(uint32*)&s->Length;
-			if (cmp == cmp2)
-			{
-				if (!memcmp(str, s->Str, len))
-				{
-					// found a string
-					return s->Str;
-				}
-			}
-		}
+	case 3:
+		k ^= p[2] << 16;
+		// fallthrough
+	case 2:
+		k ^= p[1] << 8;
+		// fallthrough
+	case 1:
+		k ^= p[0];
+		k *= 0xCC9E2D51;
+		k = ROL32(k, 15);
+		k *= 0x1B873593;
+		h ^= k;
 	}
-	else
-#endif
+	// final mix
+	h ^= h >> 16;
+	h *= 0x85EBCA6B;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35;
+	h ^= h >> 16;
+	return h ? h : 1;					// 0 is used for empty slots
+}
+
+const char* CStringPool::Add(const char* str, int len, uint32 hash)
+{
+	if ((Count + 1) * 2 > (int)(Mask + 1))
+		Grow();
+
+	uint32 i = hash & Mask;
+	while (true)
 	{
-		for (const CStringPoolEntry* s = StringHashTable[hash]; s; s = s->HashNext)
-		{
-			if (s->Length == len && !memcmp(str, s->Str, len))
-			{
-				// found a string
-				return s->Str;
-			}
-		}
+		CSlot& slot = Slots[i];
+		if (!slot.Hash) break;
+		// compare hash and length first, so string memory is accessed only for a real match
+		if (slot.Hash == hash && slot.Length == (uint32)len && !memcmp(slot.Str, str, len))
+			return slot.Str;
+		i = (i + 1) & Mask;
 	}
 
-	if (!StringPool) StringPool = new CMemoryChain();
-
 	// allocate new string from pool
-	CStringPoolEntry* n = (CStringPoolEntry*)StringPool->Alloc(sizeof(CStringPoolEntry) + len);	// note: null byte is taken into account in CStringPoolEntry
-	n->HashNext = StringHashTable[hash];
-	StringHashTable[hash] = n;
-	n->Length = len;
-	memcpy(n->Str, str, len+1);
+	if (!Chain) Chain = new CMemoryChain();
+	char* s = (char*)Chain->Alloc(len + 1, 1);
+	memcpy(s, str, len);
+	s[len] = 0;
 
-	return n->Str;
+	CSlot& slot = Slots[i];
+	slot.Hash = hash;
+	slot.Length = len;
+	slot.Str = s;
+	Count++;
+	return s;
 }
 
-#if 0
-void PrintStringHashDistribution()
+void CStringPool::Grow()
 {
-	int hashCounts[1024];
-	int totalCount = 0;
-	memset(hashCounts, 0, sizeof(hashCounts));
-	for (int hash = 0; hash < STRING_HASH_SIZE; hash++)
+	guard(CStringPool::Grow);
+
+	uint32 oldSize = Slots ? Mask + 1 : 0;
+	uint32 newSize = oldSize ? oldSize * 2 : STRING_POOL_INITIAL_SIZE;
+	CSlot* oldSlots = Slots;
+
+	Slots = new CSlot[newSize];
+	memset(Slots, 0, newSize * sizeof(CSlot));
+	Mask = newSize - 1;
+
+	// reinsert strings using stored hashes
+	for (uint32 j = 0; j < oldSize; j++)
 	{
-		int count = 0;
-		for (CStringPoolEntry* info = StringHashTable[hash]; info; info = info->HashNext)
-			count++;
-		assert(count < ARRAY_COUNT(hashCounts));
-		hashCounts[count]++;
-		totalCount += count;
+		const CSlot& slot = oldSlots[j];
+		if (!slot.Hash) continue;
+		uint32 i = slot.Hash & Mask;
+		while (Slots[i].Hash)
+			i = (i + 1) & Mask;
+		Slots[i] = slot;
 	}
-	appPrintf("String hash distribution: collision count -> num chains\n");
-	int totalCount2 = 0;
-	for (int i = 0; i < ARRAY_COUNT(hashCounts); i++)
+	delete[] oldSlots;
+
+	unguard;
+}
+
+void CStringPool::GetStats(Stats& stats) const
+{
+	memset(&stats, 0, sizeof(stats));
+	if (!Slots) return;
+
+	stats.NumStrings = Count;
+	stats.NumSlots = Mask + 1;
+	stats.LoadFactor = (float)Count / stats.NumSlots;
+	double totalProbes = 0;
+	for (uint32 i = 0; i <= Mask; i++)
 	{
-		int count = hashCounts[i];
-		if (count > 0)
-		{
-			totalCount2 += count * i;
-			float percent = totalCount2 * 100.0f / totalCount;
-			appPrintf("%d -> %d [%.1f%%]\n", i, count, percent);
-		}
+		const CSlot& slot = Slots[i];
+		if (!slot.Hash) continue;
+		int probes = ((i - slot.Hash) & Mask) + 1;
+		totalProbes += probes;
+		if (probes > stats.MaxProbeLength) stats.MaxProbeLength = probes;
 	}
-	assert(totalCount == totalCount2);
+	if (Count) stats.AvgProbeLength = (float)(totalProbes / Count);
+	if (Chain) stats.StringMemory = Chain->GetSize();
+}
+
+static CStringPool* StringPool;
+static CMutex StringPoolLock;
 
-	// Store string table to a file
-	FILE* f = fopen("StringTable.txt", "w");
-	for (int hash = 0; hash < STRING_HASH_SIZE; hash++)
+const char* appStrdupPool(const char* str)
+{
+	int len = strlen(str);
+	uint32 hash = CStringPool::Hash(str, len);
+
+	// Pool could be used from ParallelFor() tasks (for example, when loading pak file indices)
+	CScopedLock ScopedLock(StringPoolLock);
+	if (!StringPool) StringPool = new CStringPool;
+	return StringPool->Add(str, len, hash);
+}
+
+void appStrdupPoolBatch(const char** strs, int count)
+{
+	guard(appStrdupPoolBatch);
+
+	// Hash strings before locking the pool
+	TArray<uint32> Hashes;
+	Hashes.AddUninitialized(count * 2);		// pairs of length and hash
+	for (int i = 0; i < count; i++)
 	{
-		for (CStringPoolEntry* info = StringHashTable[hash]; info; info = info->HashNext)
-		{
-			fprintf(f, "%s\n", info->Str);
-		}
+		int len = strlen(strs[i]);
+		Hashes[i*2]   = len;
+		Hashes[i*2+1] = CStringPool::Hash(strs[i], len);
 	}
-	fclose(f);
+
+	CScopedLock ScopedLock(StringPoolLock);
+	if (!StringPool) StringPool = new CStringPool;
+	for (int i = 0; i < count; i++)
+		strs[i] = StringPool->Add(strs[i], Hashes[i*2], Hashes[i*2+1]);
+
+	unguard;
+}
+
+void appGetStringPoolStats(CStringPool::Stats& stats)
+{
+	CScopedLock ScopedLock(StringPoolLock);
+	if (StringPool)
+		StringPool->GetStats(stats);
+	else
+		memset(&stats, 0, sizeof(stats));
+}
+
+void appPrintStringPoolStats()
+{
+	CStringPool::Stats stats;
+	appGetStringPoolStats(stats);
+	appPrintf("String pool: %d strings (%d Kb), %d slots, load %.2f, probes avg %.2f max %d\n",
+		stats.NumStrings, stats.StringMemory >> 10, stats.NumSlots, stats.LoadFactor,
+		stats.AvgProbeLength, stats.MaxProbeLength);
 }
-#endif
 
 
 /*-----------------------------------------------------------------------------
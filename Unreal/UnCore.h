@@ -98,10 +98,12 @@ const char *appGetRootDirectory();
 // forwards
 class FString;
 class FVirtualFileSystem;
+struct CMountedVFS;
 
 struct CGameFileInfo
 {
 	friend void appRegisterGameFile(const char *FullName, FVirtualFileSystem* parentVfs);
+	friend void RegisterGameFile(const char *FullName, FVirtualFileSystem* parentVfs, CMountedVFS* Mounted, int64 FileSize);
 	friend const CGameFileInfo* appFindGameFile(const char *Filename, const char *Ext);
 
 	CGameFileInfo* HashNext;						// used for fast search; computed from ShortFilename excluding extension
@@ -201,7 +203,57 @@ extern const char *GStartupPackage;
 	FName class
 -----------------------------------------------------------------------------*/
 
+// Hash table of unique strings, used for FName strings. Open addressing with linear probing, the table
+// grows when it becomes half full. Strings are allocated from a memory chain and never released, so
+// returned pointers are valid for the whole lifetime of the pool. Not thread-safe.
+class CStringPool
+{
+public:
+	struct Stats
+	{
+		int		NumStrings;
+		int		NumSlots;
+		float	LoadFactor;
+		float	AvgProbeLength;				// average number of slots checked to find an existing string
+		int		MaxProbeLength;
+		int		StringMemory;				// size of memory chain holding strings
+	};
+
+	CStringPool();
+	~CStringPool();
+
+	static uint32 Hash(const char* str, int len);
+	// Find or add a string, 'hash' should be computed with Hash()
+	const char* Add(const char* str, int len, uint32 hash);
+
+	void GetStats(Stats& stats) const;
+
+private:
+	struct CSlot
+	{
+		uint32		Hash;					// 0 for empty slot
+		uint32		Length;
+		const char*	Str;
+	};
+
+	CSlot*			Slots;
+	uint32			Mask;					// number of slots - 1
+	int				Count;
+	CMemoryChain*	Chain;
+
+	void Grow();
+
+	// disable copying
+	CStringPool(const CStringPool&);
+	CStringPool& operator=(const CStringPool&);
+};
+
 const char* appStrdupPool(const char* str);
+// Replace every string of the array with its pooled copy, the pool is locked only once
+void appStrdupPoolBatch(const char** strs, int count);
+// Statistics of the pool used by appStrdupPool()
+void appGetStringPoolStats(CStringPool::Stats& stats);
+void appPrintStringPoolStats();
 
 class FName
 {
@@ -466,6 +518,39 @@ enum EPlatform
 	FArchive class
 -----------------------------------------------------------------------------*/
 
+// Reverse byte order for data array, inplace
+void appReverseBytes(void *Block, int NumItems, int ItemSize);
+
+// Reverse byte order of a single value, used for serialization of primitive types
+FORCEINLINE void appReverseItemBytes(void *Data, int Size)
+{
+	switch (Size)
+	{
+	case 2:
+		{
+			uint16 v = *(uint16*)Data;
+			*(uint16*)Data = (v >> 8) | (v << 8);
+		}
+		break;
+	case 4:
+		{
+			uint32 v = *(uint32*)Data;
+			*(uint32*)Data = (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+		}
+		break;
+	case 8:
+		{
+			uint32 lo = ((uint32*)Data)[0];
+			uint32 hi = ((uint32*)Data)[1];
+			((uint32*)Data)[0] = (hi >> 24) | ((hi >> 8) & 0xFF00) | ((hi << 8) & 0xFF0000) | (hi << 24);
+			((uint32*)Data)[1] = (lo >> 24) | ((lo >> 8) & 0xFF00) | ((lo << 8) & 0xFF0000) | (lo << 24);
+		}
+		break;
+	default:
+		appReverseBytes(Data, 1, Size);
+	}
+}
+
 class FArchive
 {
 public:
@@ -483,6 +568,17 @@ public:
 	int		Game;				// EGame
 	int		Platform;			// EPlatform
 
+	// Inline read window. Readers which have the data in memory expose it here, so primitive types
+	// could be read without calling virtual Serialize(): [FastPtr, FastEnd) are the bytes located at
+	// the current position of FastAr. FastAr is 'this' unless reading is forwarded to another archive.
+	FArchive*	FastAr;
+	const byte*	FastPtr;
+	const byte*	FastEnd;
+
+protected:
+	const byte*	FastStart;		// FastPtr value at the moment of the last SetFastWindow() or ConsumeFastWindow()
+
+public:
 	FArchive()
 	:	ArPos(0)
 	,	ArStopper(0)
@@ -492,6 +588,10 @@ public:
 	,	ReverseBytes(false)
 	,	Game(GAME_UNKNOWN)
 	,	Platform(PLATFORM_PC)
+	,	FastAr(this)
+	,	FastPtr(NULL)
+	,	FastEnd(NULL)
+	,	FastStart(NULL)
 	{}
 
 	virtual ~FArchive()
@@ -573,6 +673,31 @@ public:
 	virtual void Serialize(void *data, int size) = 0;
 	void ByteOrderSerialize(void *data, int size);
 
+	// Read data from the inline window, returns false when the window has not enough data.
+	FORCEINLINE bool FastRead(void *data, int size)
+	{
+		FArchive* Ar = FastAr;
+		if (Ar->FastEnd - Ar->FastPtr < size) return false;
+		memcpy(data, Ar->FastPtr, size);
+		Ar->FastPtr += size;
+		return true;
+	}
+
+	// Versions of Serialize() and ByteOrderSerialize() which are using the inline window when possible
+	FORCEINLINE void SerializeInline(void *data, int size)
+	{
+		if (!FastRead(data, size))
+			Serialize(data, size);
+	}
+
+	FORCEINLINE void ByteOrderSerializeInline(void *data, int size)
+	{
+		if (!FastRead(data, size))
+			ByteOrderSerialize(data, size);
+		else if (ReverseBytes)
+			appReverseItemBytes(data, size);
+	}
+
 	// "Stopper" is used to check for overrun serialization.
 	// Note: there's no 64-bit "stopper" - large files are used only as containers for smaller
 	// files, so stopper validation is performed on upper level, with 32-bit values.
@@ -656,6 +781,30 @@ public:
 		else
 			return NULL;
 	}
+
+protected:
+	// Inline read window helpers for derived classes. A reader should advance its own position by
+	// ConsumeFastWindow() before doing anything else in Serialize(), Seek() etc, and account
+	// GetFastWindowConsumed() in Tell().
+	void SetFastWindow(const byte* Data, int Size)
+	{
+		FastStart = FastPtr = Data;
+		FastEnd = Data + Size;
+	}
+	void ResetFastWindow()
+	{
+		FastStart = FastPtr = FastEnd = NULL;
+	}
+	int ConsumeFastWindow()
+	{
+		int Consumed = (int)(FastPtr - FastStart);
+		FastStart = FastPtr;
+		return Consumed;
+	}
+	int GetFastWindowConsumed() const
+	{
+		return (int)(FastPtr - FastStart);
+	}
 };
 
 #define DECLARE_ARCHIVE(Class,Base)		\
@@ -681,53 +830,53 @@ private:
 FORCEINLINE FArchive& operator<<(FArchive &Ar, bool &B)
 {
 	int32 b32 = B;
-	Ar.Serialize(&b32, 4);
+	Ar.SerializeInline(&b32, 4);
 	if (Ar.IsLoading) B = (b32 != 0);
 	return Ar;
 }
 FORCEINLINE FArchive& operator<<(FArchive &Ar, char &B) // int8
 {
-	Ar.Serialize(&B, 1);
+	Ar.SerializeInline(&B, 1);
 	return Ar;
 }
 FORCEINLINE FArchive& operator<<(FArchive &Ar, byte &B) // uint8
 {
-	Ar.Serialize(&B, 1);
+	Ar.SerializeInline(&B, 1);
 	return Ar;
 }
 FORCEINLINE FArchive& operator<<(FArchive &Ar, int16 &B)
 {
-	Ar.ByteOrderSerialize(&B, 2);
+	Ar.ByteOrderSerializeInline(&B, 2);
 	return Ar;
 }
 FORCEINLINE FArchive& operator<<(FArchive &Ar, uint16 &B)
 {
-	Ar.ByteOrderSerialize(&B, 2);
+	Ar.ByteOrderSerializeInline(&B, 2);
 	return Ar;
 }
 FORCEINLINE FArchive& operator<<(FArchive &Ar, int32 &B)
 {
-	Ar.ByteOrderSerialize(&B, 4);
+	Ar.ByteOrderSerializeInline(&B, 4);
 	return Ar;
 }
 FORCEINLINE FArchive& operator<<(FArchive &Ar, uint32 &B)
 {
-	Ar.ByteOrderSerialize(&B, 4);
+	Ar.ByteOrderSerializeInline(&B, 4);
 	return Ar;
 }
 FORCEINLINE FArchive& operator<<(FArchive &Ar, int64 &B)
 {
-	Ar.ByteOrderSerialize(&B, 8);
+	Ar.ByteOrderSerializeInline(&B, 8);
 	return Ar;
 }
 FORCEINLINE FArchive& operator<<(FArchive &Ar, uint64 &B)
 {
-	Ar.ByteOrderSerialize(&B, 8);
+	Ar.ByteOrderSerializeInline(&B, 8);
 	return Ar;
 }
 FORCEINLINE FArchive& operator<<(FArchive &Ar, float &B)
 {
-	Ar.ByteOrderSerialize(&B, 4);
+	Ar.ByteOrderSerializeInline(&B, 4);
 	return Ar;
 }
 
@@ -754,6 +903,7 @@ enum EFileArchiveOptions
 {
 	FAO_NoOpenError = 1,
 	FAO_TextFile = 2,
+	FAO_AtomicWrite = 4,		// FFileWriter: write to a temporary file, rename it to Filename when closed
 };
 
 class FFileArchive : public FArchive
@@ -796,6 +946,37 @@ inline bool appFileExists(const char* filename)
 }
 
 
+// Memory-mapped reading of files (non-Windows platforms only). Large files are always
+// mapped, this variable enables mapping of all files.
+extern bool GUseMmap;
+
+// Memory-mapped file data. Reference counted, so the data could be used after the
+// file is closed. Mapping is read-only, the data should be copied before modification.
+class CMappedFile
+{
+public:
+	byte*		Data;
+	int64		Size;
+
+	CMappedFile(byte* InData, int64 InSize)
+	:	Data(InData)
+	,	Size(InSize)
+	,	RefCount(1)
+	{}
+
+	void AddRef()
+	{
+		appInterlockedIncrement(&RefCount);
+	}
+	// Unmaps file when the last reference is released
+	void Release();
+
+private:
+	volatile int RefCount;
+
+	~CMappedFile();
+};
+
 class FFileReader : public FFileArchive
 {
 	DECLARE_ARCHIVE(FFileReader, FFileArchive);
@@ -805,18 +986,40 @@ public:
 
 	virtual void Serialize(void *data, int size);
 	virtual bool Open();
+	virtual void Close();
 	virtual void Seek(int Pos);
 	virtual void Seek64(int64 Pos);
 	virtual int Tell() const;
 	virtual int64 Tell64() const;
 	virtual int64 GetFileSize64() const;
 	virtual bool IsEof() const;
+	virtual void SetStopper(int Pos);
+
+	// Returns pointer to file data for memory-mapped files, or NULL when file is not mapped.
+	// Could be used to avoid copying of data. Use GetMapping() to keep data after closing the file.
+	const byte* GetMappedData(int64 Pos, int Size) const
+	{
+		if (!Mapping || Pos < 0 || Pos + Size > FileSize) return NULL;
+		return Mapping->Data + Pos;
+	}
+	CMappedFile* GetMapping() const
+	{
+		return Mapping;
+	}
 
 protected:
 	int64		SeekPos;
 	int64		FileSize;
 	int			BufferBytesLeft;
 	int			LocalReadPos;
+	// When file is mapped, file buffer is not used, and BufferPos holds current position
+	CMappedFile* Mapping;
+
+	void MapFile();
+	// Inline read window support: apply bytes consumed from the window to the file position,
+	// and expose remaining buffered (or mapped) data
+	void SyncFastWindow();
+	void UpdateFastWindow();
 };
 
 
@@ -842,6 +1045,7 @@ public:
 protected:
 	int64		FileSize;
 	int64		ArPos64;
+	const char	*TargetName;	// final file name for FAO_AtomicWrite mode, allocated with appStrdup
 
 	void FlushBuffer();
 };
@@ -916,6 +1120,7 @@ public:
 	{
 		IsLoading = true;
 		ArStopper = size;
+		UpdateFastWindow();
 	}
 
 	virtual void Seek(int Pos)
@@ -923,26 +1128,41 @@ public:
 		guard(FMemReader::Seek);
 		assert(Pos >= 0 && Pos <= DataSize);
 		ArPos = Pos;
+		UpdateFastWindow();
 		unguard;
 	}
 
+	virtual int Tell() const
+	{
+		return ArPos + GetFastWindowConsumed();
+	}
+
 	virtual bool IsEof() const
 	{
-		return ArPos >= DataSize;
+		return Tell() >= DataSize;
 	}
 
 	virtual void Serialize(void *data, int size)
 	{
 		guard(FMemReader::Serialize);
+		ArPos += ConsumeFastWindow();
 		if (ArStopper > 0 && ArPos + size > ArStopper)
 			appError("Serializing behind stopper (%X+%X > %X)", ArPos, size, ArStopper);
 		if (ArPos + size > DataSize)
 			appError("Serializing behind end of buffer");
 		memcpy(data, DataPtr + ArPos, size);
 		ArPos += size;
+		UpdateFastWindow();
 		unguard;
 	}
 
+	virtual void SetStopper(int Pos)
+	{
+		ArPos += ConsumeFastWindow();
+		ArStopper = Pos;
+		UpdateFastWindow();
+	}
+
 	virtual int GetFileSize() const
 	{
 		return DataSize;
@@ -951,6 +1171,15 @@ public:
 protected:
 	const byte *DataPtr;
 	int		DataSize;
+
+	void UpdateFastWindow()
+	{
+		int End = (ArStopper > 0 && ArStopper < DataSize) ? ArStopper : DataSize;
+		if (ArPos < End)
+			SetFastWindow(DataPtr + ArPos, End - ArPos);
+		else
+			ResetFastWindow();
+	}
 };
 
 
@@ -991,9 +1220,6 @@ inline void DUMP_MEM_BYTES(const void* Data, int NumBytes)
 }
 
 
-// Reverse byte order for data array, inplace
-void appReverseBytes(void *Block, int NumItems, int ItemSize);
-
 
 /*-----------------------------------------------------------------------------
 	Math classes
@@ -2421,6 +2647,7 @@ struct FByteBulkData //?? separate FUntypedBulkData
 //	int		SavedBulkDataOffsetInFile;
 //	int		SavedBulkDataSizeOnDisk;
 	byte	*BulkData;					// pointer to array data
+	CMappedFile *MappedFile;			// when not NULL, BulkData points to read-only memory-mapped file and not owned by this object
 //	int		LockStatus;
 //	FArchive *AttachedAr;
 
@@ -2430,6 +2657,7 @@ struct FByteBulkData //?? separate FUntypedBulkData
 
 	FByteBulkData()
 	:	BulkData(NULL)
+	,	MappedFile(NULL)
 	,	BulkDataOffsetInFile(0)
 #if UNREAL4
 	,	bIsUE4Data(false)
@@ -2448,7 +2676,15 @@ struct FByteBulkData //?? separate FUntypedBulkData
 
 	void ReleaseData()
 	{
-		if (BulkData) appFree(BulkData);
+		if (MappedFile)
+		{
+			MappedFile->Release();
+			MappedFile = NULL;
+		}
+		else if (BulkData)
+		{
+			appFree(BulkData);
+		}
 		BulkData = NULL;
 	}
 
@@ -2518,6 +2754,9 @@ struct FIntBulkData : public FByteBulkData
 #define PKG_FilterEditorOnly 0x80000000
 
 int appDecompress(byte *CompressedBuffer, int CompressedSize, byte *UncompressedBuffer, int UncompressedSize, int Flags);
+// Returns true when appDecompress() decrypts CompressedBuffer in place, so it can't point to
+// read-only data like a memory-mapped file
+bool appDecompressModifiesInput(int Flags);
 
 // UE4 has built-in AES encryption
 
@@ -2535,6 +2774,14 @@ inline void appDecryptAES(byte* Data, int Size)
 // Callback called when encrypted pak file is attempted to load
 bool UE4EncryptedPak();
 
+// Directory for persistent cache of decoded pak file indices and package scan results, empty
+// string disables the cache
+extern FString GPakIndexCacheDir;
+
+// Returns name of the cache file with specified prefix for the game directory, or empty string
+// when caching is disabled
+FString GetIndexCacheFilename(const char* Prefix, const char* RootDirectory);
+
 
 /*-----------------------------------------------------------------------------
 	UE4 support
@@ -194,6 +194,24 @@ void DecryptBladeAndSoul(byte* CompressedBuffer, int CompressedSize);
 void DecryptTaoYuan(byte* CompressedBuffer, int CompressedSize);
 void DecryptDevlsThird(byte* CompressedBuffer, int CompressedSize);
 
+bool appDecompressModifiesInput(int Flags)
+{
+	// Should match decryption code in appDecompress()
+#if BLADENSOUL
+	if (GForceGame == GAME_BladeNSoul && Flags == COMPRESS_LZO_ENC_BNS) return true;
+#endif
+#if SMITE
+	if (GForceGame == GAME_Smite && (Flags & 512)) return true;
+#endif
+#if TAO_YUAN
+	if (GForceGame == GAME_TaoYuan) return true;
+#endif
+#if DEVILS_THIRD
+	if (GForceGame == GAME_DevilsThird && (Flags & 8)) return true;
+#endif
+	return false;
+}
+
 int appDecompress(byte *CompressedBuffer, int CompressedSize, byte *UncompressedBuffer, int UncompressedSize, int Flags)
 {
 	int OldFlags = Flags;
@@ -371,6 +389,168 @@ int appDecompress(byte *CompressedBuffer, int CompressedSize, byte *Uncompressed
 FString GAesKey;
 
 #define AES_KEYBITS		256
+#define AES_NUMROUNDS	NROUNDS(AES_KEYBITS)
+
+// Hardware AES is available on x86 CPUs only
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define USE_AESNI		1
+#else
+#define USE_AESNI		0
+#endif
+
+#if USE_AESNI
+
+#include <wmmintrin.h>			// AES-NI intrinsics
+#if _MSC_VER
+#include <intrin.h>				// __cpuid
+#define AESNI_FUNC
+#else
+#include <cpuid.h>				// __get_cpuid
+#define AESNI_FUNC		__attribute__((target("aes")))
+#endif
+
+#endif // USE_AESNI
+
+// Expanded key is cached per thread, because pak files are decrypted from worker threads
+struct CAesKeyCache
+{
+	bool			Valid;
+	byte			Key[KEYLENGTH(AES_KEYBITS)];
+	unsigned long	rk[RKLENGTH(AES_KEYBITS)];			// rijndael decryption key schedule
+#if USE_AESNI
+	byte			RoundKeys[AES_NUMROUNDS+1][16];		// AES-NI decryption key schedule
+#endif
+};
+
+static THREAD_LOCAL CAesKeyCache GAesKeyCache;
+
+#if USE_AESNI
+
+// Build key schedule for AESDEC instruction from the rijndael's encryption key schedule
+AESNI_FUNC static void SetupAesNiDecrypt(const byte* Key, byte RoundKeys[AES_NUMROUNDS+1][16])
+{
+	unsigned long ek[RKLENGTH(AES_KEYBITS)];
+	rijndaelSetupEncrypt(ek, Key, AES_KEYBITS);
+
+	// rijndael stores round keys as big-endian 32-bit words
+	__m128i Keys[AES_NUMROUNDS+1];
+	for (int r = 0; r <= AES_NUMROUNDS; r++)
+	{
+		byte b[16];
+		for (int i = 0; i < 16; i++)
+			b[i] = (ek[r * 4 + i / 4] >> (24 - (i & 3) * 8)) & 0xFF;
+		Keys[r] = _mm_loadu_si128((__m128i*)b);
+	}
+
+	// "Equivalent inverse cipher": reversed round keys, InvMixColumns applied to middle ones
+	_mm_storeu_si128((__m128i*)RoundKeys[0], Keys[AES_NUMROUNDS]);
+	for (int r = 1; r < AES_NUMROUNDS; r++)
+		_mm_storeu_si128((__m128i*)RoundKeys[r], _mm_aesimc_si128(Keys[AES_NUMROUNDS - r]));
+	_mm_storeu_si128((__m128i*)RoundKeys[AES_NUMROUNDS], Keys[0]);
+}
+
+#define AES_PARALLEL_BLOCKS		8
+
+// ECB decryption, blocks are independent, so several of them are decrypted at the same time to
+// hide latency of AESDEC instruction
+AESNI_FUNC static void DecryptAesNi(const byte RoundKeys[AES_NUMROUNDS+1][16], byte* Data, int Size)
+{
+	__m128i K[AES_NUMROUNDS+1];
+	for (int r = 0; r <= AES_NUMROUNDS; r++)
+		K[r] = _mm_loadu_si128((const __m128i*)RoundKeys[r]);
+
+	__m128i* p = (__m128i*)Data;
+	int NumBlocks = Size / 16;
+
+	for ( ; NumBlocks >= AES_PARALLEL_BLOCKS; NumBlocks -= AES_PARALLEL_BLOCKS, p += AES_PARALLEL_BLOCKS)
+	{
+		__m128i b[AES_PARALLEL_BLOCKS];
+		for (int i = 0; i < AES_PARALLEL_BLOCKS; i++)
+			b[i] = _mm_xor_si128(_mm_loadu_si128(p + i), K[0]);
+		for (int r = 1; r < AES_NUMROUNDS; r++)
+		{
+			for (int i = 0; i < AES_PARALLEL_BLOCKS; i++)
+				b[i] = _mm_aesdec_si128(b[i], K[r]);
+		}
+		for (int i = 0; i < AES_PARALLEL_BLOCKS; i++)
+			_mm_storeu_si128(p + i, _mm_aesdeclast_si128(b[i], K[AES_NUMROUNDS]));
+	}
+
+	for ( ; NumBlocks > 0; NumBlocks--, p++)
+	{
+		__m128i b = _mm_xor_si128(_mm_loadu_si128(p), K[0]);
+		for (int r = 1; r < AES_NUMROUNDS; r++)
+			b = _mm_aesdec_si128(b, K[r]);
+		_mm_storeu_si128(p, _mm_aesdeclast_si128(b, K[AES_NUMROUNDS]));
+	}
+}
+
+static bool CpuHasAesNi()
+{
+#if _MSC_VER
+	int Regs[4];
+	__cpuid(Regs, 1);
+	return (Regs[2] & (1 << 25)) != 0;
+#else
+	unsigned eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+	return (ecx & (1 << 25)) != 0;
+#endif
+}
+
+// Compare AES-NI decryption with rijndael code, use AES-NI only when results are identical
+static bool TestAesNi()
+{
+	const int KeySize = KEYLENGTH(AES_KEYBITS);
+	const int DataSize = 16 * (AES_PARALLEL_BLOCKS + 3);
+	byte Key[KeySize];
+	byte Data1[DataSize], Data2[DataSize];
+	for (int i = 0; i < KeySize; i++)
+		Key[i] = i * 7 + 1;
+	for (int i = 0; i < DataSize; i++)
+		Data1[i] = Data2[i] = i * 13 + 5;
+
+	unsigned long rk[RKLENGTH(AES_KEYBITS)];
+	int nrounds = rijndaelSetupDecrypt(rk, Key, AES_KEYBITS);
+	for (int pos = 0; pos < DataSize; pos += 16)
+		rijndaelDecrypt(rk, nrounds, Data1 + pos, Data1 + pos);
+
+	byte RoundKeys[AES_NUMROUNDS+1][16];
+	SetupAesNiDecrypt(Key, RoundKeys);
+	DecryptAesNi(RoundKeys, Data2, DataSize);
+
+	return memcmp(Data1, Data2, DataSize) == 0;
+}
+
+// -1 = not checked yet, 0 = use rijndael code, 1 = use AES-NI
+static volatile int GAesNiStatus = -1;
+
+static bool UseAesNi()
+{
+	// Atomic read: pak files are decrypted from several threads
+	int Status = appInterlockedCompareExchange(&GAesNiStatus, -1, -1);
+	if (Status < 0)
+	{
+		// Several threads may run the check at the same time, only the first result is stored
+		bool Ok = CpuHasAesNi();
+		bool TestFailed = Ok && !TestAesNi();
+		if (TestFailed) Ok = false;
+		int PrevStatus = appInterlockedCompareExchange(&GAesNiStatus, Ok ? 1 : 0, -1);
+		if (PrevStatus < 0)
+		{
+			if (TestFailed)
+				appPrintf("WARNING: AES-NI self-test failed, using software AES\n");
+			Status = Ok ? 1 : 0;
+		}
+		else
+		{
+			Status = PrevStatus;
+		}
+	}
+	return Status > 0;
+}
+
+#endif // USE_AESNI
 
 void appDecryptAES(byte* Data, int Size, const char* Key, int KeyLen)
 {
@@ -392,12 +572,30 @@ void appDecryptAES(byte* Data, int Size, const char* Key, int KeyLen)
 
 	assert((Size & 15) == 0);
 
-	unsigned long rk[RKLENGTH(AES_KEYBITS)];
-	int nrounds = rijndaelSetupDecrypt(rk, (const byte*)Key, AES_KEYBITS);
+	// Reuse expanded key when possible
+	CAesKeyCache& Cache = GAesKeyCache;
+	if (!Cache.Valid || memcmp(Cache.Key, Key, KEYLENGTH(AES_KEYBITS)) != 0)
+	{
+		memcpy(Cache.Key, Key, KEYLENGTH(AES_KEYBITS));
+		rijndaelSetupDecrypt(Cache.rk, (const byte*)Key, AES_KEYBITS);
+#if USE_AESNI
+		if (UseAesNi())
+			SetupAesNiDecrypt((const byte*)Key, Cache.RoundKeys);
+#endif
+		Cache.Valid = true;
+	}
+
+#if USE_AESNI
+	if (UseAesNi())
+	{
+		DecryptAesNi(Cache.RoundKeys, Data, Size);
+		return;
+	}
+#endif
 
 	for (int pos = 0; pos < Size; pos += 16)
 	{
-		rijndaelDecrypt(rk, nrounds, Data + pos, Data + pos);
+		rijndaelDecrypt(Cache.rk, AES_NUMROUNDS, Data + pos, Data + pos);
 	}
 
 	unguard;
@@ -8,12 +8,25 @@
 
 #include <errno.h>				// not needed for VC
 
+#ifndef USE_SSE
+#define USE_SSE					1
+#endif
+
+#if USE_SSE
+#include <emmintrin.h>
+#endif
+
 #if _WIN32
 #include <io.h>					// for _filelengthi64
+#include <process.h>			// for getpid()
+#else
+#include <sys/mman.h>			// for mmap
+#include <unistd.h>				// for getpid()
 #endif
 
 
 #define FILE_BUFFER_SIZE		4096
+#define MMAP_THRESHOLD			(64 << 20)		// files larger than this size are memory-mapped
 
 
 //#define DEBUG_BULK			1
@@ -159,8 +172,71 @@ void SkipLazyArray(FArchive &Ar)
 	unguard;
 }
 
+#if USE_SSE
+
+// Byte swapping of 16, 32 and 64-bit items, 16 bytes at a time. SSSE3's pshufb would do that with
+// a single instruction, but we're limited to SSE2 which is the minimal requirement for umodel.
+static FORCEINLINE __m128i ReverseBytes16(__m128i v)
+{
+	return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static FORCEINLINE __m128i ReverseBytes32(__m128i v)
+{
+	v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+	v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+	return ReverseBytes16(v);
+}
+
+static FORCEINLINE __m128i ReverseBytes64(__m128i v)
+{
+	v = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+	return ReverseBytes32(v);
+}
+
+#define REVERSE_BLOCK(Func)								\
+	for ( ; Size >= 32; p += 32, Size -= 32)				\
+	{														\
+		__m128i v0 = _mm_loadu_si128((__m128i*)p);			\
+		__m128i v1 = _mm_loadu_si128((__m128i*)(p + 16));	\
+		_mm_storeu_si128((__m128i*)p, Func(v0));			\
+		_mm_storeu_si128((__m128i*)(p + 16), Func(v1));		\
+	}														\
+	if (Size >= 16)											\
+	{														\
+		_mm_storeu_si128((__m128i*)p, Func(_mm_loadu_si128((__m128i*)p))); \
+		p += 16;											\
+		Size -= 16;											\
+	}
+
+#endif // USE_SSE
+
 void appReverseBytes(void *Block, int NumItems, int ItemSize)
 {
+	if (ItemSize == 2 || ItemSize == 4 || ItemSize == 8)
+	{
+		byte *p = (byte*)Block;
+		int Size = NumItems * ItemSize;
+#if USE_SSE
+		switch (ItemSize)
+		{
+		case 2:
+			REVERSE_BLOCK(ReverseBytes16);
+			break;
+		case 4:
+			REVERSE_BLOCK(ReverseBytes32);
+			break;
+		case 8:
+			REVERSE_BLOCK(ReverseBytes64);
+			break;
+		}
+#endif // USE_SSE
+		// remaining items
+		for ( ; Size > 0; p += ItemSize, Size -= ItemSize)
+			appReverseItemBytes(p, ItemSize);
+		return;
+	}
+
 	byte *p1 = (byte*)Block;
 	byte *p2 = p1 + ItemSize - 1;
 	for (int i = 0; i < NumItems; i++, p1 += ItemSize, p2 += ItemSize)
@@ -200,7 +276,7 @@ FArchive& FArray::SerializeRaw(FArchive &Ar, void (*Serializer)(FArchive&, void*
 	if (!Count) return Ar;
 
 	// perform serialization itself
-	Ar.Serialize(DataPtr, elementSize * Count);
+	Ar.SerializeInline(DataPtr, elementSize * Count);
 	return Ar;
 
 	unguard;
@@ -232,7 +308,7 @@ FArchive& FArray::SerializeSimple(FArchive &Ar, int NumFields, int FieldSize)
 	if (!Count) return Ar;
 
 	// perform serialization itself
-	Ar.Serialize(DataPtr, elementSize * Count);
+	Ar.SerializeInline(DataPtr, elementSize * Count);
 	// reverse bytes when needed
 	if (FieldSize > 1 && Ar.ReverseBytes)
 	{
@@ -437,14 +513,7 @@ void FArchive::ByteOrderSerialize(void *data, int size)
 	if (!ReverseBytes || size <= 1) return;
 
 	assert(IsLoading);
-	byte *p1 = (byte*)data;
-	byte *p2 = p1 + size - 1;
-	while (p1 < p2)
-	{
-		Exchange(*p1, *p2);
-		p1++;
-		p2--;
-	}
+	appReverseItemBytes(data, size);
 
 	unguard;
 }
@@ -567,12 +636,28 @@ bool FFileArchive::OpenFile()
 	unguard;
 }
 
+bool GUseMmap = false;
+
+void CMappedFile::Release()
+{
+	if (appInterlockedDecrement(&RefCount) == 0)
+		delete this;
+}
+
+CMappedFile::~CMappedFile()
+{
+#if !_WIN32
+	munmap(Data, (size_t)Size);
+#endif
+}
+
 FFileReader::FFileReader(const char *Filename, unsigned InOptions)
 :	FFileArchive(Filename, InOptions)
 ,	SeekPos(-1)
 ,	FileSize(-1)
 ,	BufferBytesLeft(0)
 ,	LocalReadPos(0)
+,	Mapping(NULL)
 {
 	guard(FFileReader::FFileReader);
 	IsLoading = true;
@@ -590,10 +675,36 @@ void FFileReader::Serialize(void *data, int size)
 	guard(FFileReader::Serialize);
 
 	assert(data);
+	SyncFastWindow();
 
 	if (ArStopper > 0 && LocalReadPos + size > ArStopper - BufferPos)
 		appError("Serializing behind stopper (%llX+%X > %X)", BufferPos + LocalReadPos, size, ArStopper);
 
+	if (Mapping)
+	{
+		// Memory-mapped file, BufferPos is the current file position
+		if (size < 0 || BufferPos + size > FileSize)
+			appError("Unable to read %d bytes at pos=0x%llX", size, BufferPos);
+		const byte* Src = Mapping->Data + BufferPos;
+		switch (size)
+		{
+		case 1:
+			*(byte*)data = *Src;
+			break;
+		case 2:
+			*(uint16*)data = *(uint16*)Src;
+			break;
+		case 4:
+			*(uint32*)data = *(uint32*)Src;
+			break;
+		default:
+			memcpy(data, Src, size);
+		}
+		BufferPos += size;
+		UpdateFastWindow();
+		return;
+	}
+
 	// The function is optimized for calling frequently with reading data from buffer
 	while (size > 0)
 	{
@@ -659,6 +770,7 @@ void FFileReader::Serialize(void *data, int size)
 				BufferSize = 0;
 				BufferBytesLeft = 0;
 				LocalReadPos = 0;
+				ResetFastWindow();
 				return;
 			}
 			// Fill buffer
@@ -677,13 +789,104 @@ void FFileReader::Serialize(void *data, int size)
 			LocalReadPos = 0;
 		}
 	}
+	UpdateFastWindow();
 
 	unguardf("File=%s", ShortName);
 }
 
+void FFileReader::SyncFastWindow()
+{
+	int Consumed = ConsumeFastWindow();
+	if (Mapping)
+	{
+		BufferPos += Consumed;
+	}
+	else
+	{
+		LocalReadPos += Consumed;
+		BufferBytesLeft -= Consumed;
+	}
+}
+
+void FFileReader::UpdateFastWindow()
+{
+	const byte* Data;
+	int64 Avail;
+	if (Mapping)
+	{
+		Data = Mapping->Data + BufferPos;
+		Avail = FileSize - BufferPos;
+	}
+	else
+	{
+		Data = Buffer + LocalReadPos;
+		Avail = BufferBytesLeft;
+	}
+	// Do not let inline reads to pass the stopper, Serialize() will report the error
+	int64 Pos = BufferPos + LocalReadPos;
+	if (ArStopper > 0 && ArStopper - Pos < Avail)
+		Avail = ArStopper - Pos;
+	if (Avail > 0x40000000)
+		Avail = 0x40000000;
+
+	if (Avail > 0)
+		SetFastWindow(Data, (int)Avail);
+	else
+		ResetFastWindow();
+}
+
 bool FFileReader::Open()
 {
-	return OpenFile();
+	if (!OpenFile()) return false;
+	MapFile();
+	return true;
+}
+
+void FFileReader::Close()
+{
+	SyncFastWindow();
+	ResetFastWindow();
+#if !_WIN32
+	if (Mapping)
+	{
+		// Mapped data could be still used by someone else
+		Mapping->Release();
+		Mapping = NULL;
+		BufferSize = 0;
+		BufferBytesLeft = 0;
+		LocalReadPos = 0;
+	}
+#endif // !_WIN32
+	FFileArchive::Close();
+}
+
+void FFileReader::MapFile()
+{
+#if !_WIN32
+	guard(FFileReader::MapFile);
+
+	assert(!Mapping);
+	if (Options & FAO_TextFile) return;
+
+	int64 Size = GetFileSize64();
+	if (Size <= 0 || (!GUseMmap && Size < MMAP_THRESHOLD)) return;
+	if ((uint64)Size != (size_t)Size) return;				// too large file for 32-bit address space
+
+	// Mapping is read-only: data is shared between all users of the file (block cache, bulk data),
+	// so it must not be modified in place
+	void* Data = mmap(NULL, (size_t)Size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+	if (Data == MAP_FAILED) return;		// use regular file reading
+	Mapping = new CMappedFile((byte*)Data, Size);
+
+	// Switch to the position which buffered reader would use
+	BufferPos = (SeekPos >= 0) ? SeekPos : Tell64();
+	SeekPos = -1;
+	BufferSize = 0;
+	BufferBytesLeft = 0;
+	LocalReadPos = 0;
+
+	unguardf("%s", ShortName);
+#endif // !_WIN32
 }
 
 void FFileReader::Seek(int Pos)
@@ -694,6 +897,12 @@ void FFileReader::Seek(int Pos)
 void FFileReader::Seek64(int64 Pos)
 {
 //	appPrintf("seek: %d\n", (int)Pos);
+	if (Mapping)
+	{
+		BufferPos = Pos;
+		UpdateFastWindow();
+		return;
+	}
 	// Check for buffer validity
 	int64 LocalPos64 = Pos - BufferPos;
 	if (LocalPos64 < 0 || LocalPos64 >= BufferSize)
@@ -711,17 +920,25 @@ void FFileReader::Seek64(int64 Pos)
 		LocalReadPos = (int)LocalPos64;
 		BufferBytesLeft = BufferSize - LocalReadPos;
 	}
+	UpdateFastWindow();
 }
 
 int FFileReader::Tell() const
 {
 	assert((BufferPos >> 32) == 0);
-	return (int)BufferPos + LocalReadPos;
+	return (int)BufferPos + LocalReadPos + GetFastWindowConsumed();
 }
 
 int64 FFileReader::Tell64() const
 {
-	return BufferPos + LocalReadPos;
+	return BufferPos + LocalReadPos + GetFastWindowConsumed();
+}
+
+void FFileReader::SetStopper(int Pos)
+{
+	SyncFastWindow();
+	ArStopper = Pos;
+	UpdateFastWindow();
 }
 
 int64 FFileReader::GetFileSize64() const
@@ -749,7 +966,9 @@ bool FFileReader::IsEof() const
 		// skipping "\r" characters, so position may not match.
 		appError("FFileReader::IsEof is not suitable for text files (%s)", FullName);
 	}
-	return (BufferBytesLeft == 0) && (FilePos == GetFileSize64());
+	if (Mapping)
+		return Tell64() >= FileSize;
+	return (BufferBytesLeft == GetFastWindowConsumed()) && (FilePos == GetFileSize64());
 }
 
 static TArray<FFileWriter*> GFileWriters;
@@ -758,9 +977,19 @@ FFileWriter::FFileWriter(const char *Filename, unsigned InOptions)
 :	FFileArchive(Filename, InOptions)
 ,	FileSize(0)
 ,	ArPos64(0)
+,	TargetName(NULL)
 {
 	guard(FFileWriter::FFileWriter);
 	IsLoading = false;
+	if (Options & FAO_AtomicWrite)
+	{
+		// Other processes could write the same file at the same time, so write to a process-specific
+		// file and rename it when done. ShortName still points to the target name.
+		char TempName[1024];
+		appSprintf(ARRAY_ARG(TempName), "%s.%d.tmp", FullName, getpid());
+		TargetName = FullName;
+		FullName = appStrdup(TempName);
+	}
 	Open();
 	GFileWriters.Add(this);
 	unguardf("%s", Filename);
@@ -770,6 +999,7 @@ FFileWriter::~FFileWriter()
 {
 	GFileWriters.RemoveSingle(this);
 	Close();
+	if (TargetName) appFree(const_cast<char*>(TargetName));
 }
 
 void FFileWriter::CleanupOnError()
@@ -778,6 +1008,7 @@ void FFileWriter::CleanupOnError()
 	{
 		FFileWriter* Writer = GFileWriters[i];
 		FString FileName(Writer->FullName);
+		Writer->Options &= ~FAO_AtomicWrite;	// don't replace the target file with partially saved data
 		delete Writer;
 		appPrintf("Deleting partially saved file %s\n", *FileName);
 #if MAX_DEBUG
@@ -858,8 +1089,15 @@ bool FFileWriter::Open()
 
 void FFileWriter::Close()
 {
+	bool bWasOpen = IsOpen();
 	FlushBuffer();
 	Super::Close();
+	if (bWasOpen && (Options & FAO_AtomicWrite))
+	{
+		remove(TargetName);				// rename() doesn't overwrite files on Windows
+		if (rename(FullName, TargetName) != 0)
+			remove(FullName);
+	}
 }
 
 void FFileWriter::FlushBuffer()
@@ -1431,11 +1669,31 @@ void FByteBulkData::SerializeDataChunk(FArchive &Ar)
 {
 	guard(FByteBulkData::SerializeDataChunk);
 
-	// allocate array
-	if (BulkData) appFree(BulkData);
-	BulkData = NULL;
+	ReleaseData();
 	int DataSize = ElementCount * GetElementSize();
 	if (!DataSize) return;		// nothing to serialize
+
+	bool bCompressed = (BulkDataFlags & (BULKDATA_CompressedLzo | BULKDATA_CompressedZlib | BULKDATA_CompressedLzx)) != 0;
+#if BLADENSOUL
+	if (Ar.Game == GAME_BladeNSoul && (BulkDataFlags & BULKDATA_CompressedLzoEncr))
+		bCompressed = true;
+#endif
+	if (!bCompressed)
+	{
+		// Uncompressed data in memory-mapped file: use it without copying
+		FFileReader* FileReader = Ar.CastTo<FFileReader>();
+		int64 Pos = Ar.Tell64();
+		if (FileReader && FileReader->GetMappedData(Pos, DataSize))
+		{
+			MappedFile = FileReader->GetMapping();
+			MappedFile->AddRef();
+			BulkData = const_cast<byte*>(FileReader->GetMappedData(Pos, DataSize));
+			Ar.Seek64(Pos + DataSize);
+			return;
+		}
+	}
+
+	// allocate array
 	BulkData = (byte*)appMalloc(DataSize);
 
 	if (BulkDataFlags & (BULKDATA_CompressedLzo | BULKDATA_CompressedZlib | BULKDATA_CompressedLzx))
@@ -212,7 +212,11 @@ struct CTextureData
 	unsigned GetFourCC() const;
 	bool IsDXT() const;
 
-	byte *Decompress(int MipLevel = 0);				// may return NULL in a case of error
+	// Size of buffer required for decompressed mip level
+	int GetDecompressedSize(int MipLevel = 0) const;
+	// Returns RGBA8 or float RGBA image, may return NULL in a case of error. When DstBuffer is provided,
+	// it is used instead of allocation of new buffer, it should have GetDecompressedSize() bytes.
+	byte *Decompress(int MipLevel = 0, byte* DstBuffer = NULL);
 
 #if SUPPORT_XBOX360
 	bool DecodeXBox360(int MipLevel);
@@ -225,6 +229,10 @@ struct CTextureData
 #endif
 };
 
+// Decode BC1-BC5 image with umodel's decoder and with nvtt's one, and return the number of pixels
+// which differ. Returns -1 when Format is not supported by the built-in decoder.
+int CompareDXTDecoders(ETexturePixelFormat Format, const byte* Data, int USize, int VSize);
+
 
 class UUnrealMaterial : public UObject				// no such class in Unreal Engine, needed as common base for UE1/UE2/UE3
 {
@@ -2027,6 +2027,178 @@ after_skeleton:
 }
 
 
+// Convert vertices [FirstVert, FirstVert+NumVerts) of the LOD. Could be called for several ranges of
+// the same LOD in parallel.
+static void ConvertSkeletalLodVerts(const FStaticLODModel3& SrcLod, CSkelMeshLod* Lod, bool UseGpuSkinVerts, int FirstVert, int NumVerts)
+{
+	int NumTexCoords = Lod->NumTexCoords;
+
+	int chunkIndex = 0;
+	const FSkelMeshChunk3 *C = NULL;
+	int lastChunkVertex = -1;
+	const FSkeletalMeshVertexBuffer3 &S = SrcLod.GPUSkin;
+
+	// Find the chunk of FirstVert, walking chunks exactly as the conversion loop does
+	for (int Vert = 0; Vert < FirstVert; /* empty */)
+	{
+		if (Vert >= lastChunkVertex)
+		{
+			C = &SrcLod.Chunks[chunkIndex++];
+			lastChunkVertex = C->FirstVertex + C->NumRigidVerts + C->NumSoftVerts;
+		}
+		Vert = (lastChunkVertex > Vert) ? min(lastChunkVertex, FirstVert) : Vert + 1;
+	}
+
+	CSkelMeshVertex *D = Lod->Verts + FirstVert;
+	for (int Vert = FirstVert; Vert < FirstVert + NumVerts; Vert++, D++)
+	{
+		if (Vert >= lastChunkVertex)
+		{
+			// proceed to next chunk
+			C = &SrcLod.Chunks[chunkIndex++];
+			lastChunkVertex = C->FirstVertex + C->NumRigidVerts + C->NumSoftVerts;
+		}
+
+		if (Lod->VertexColors)
+			Lod->VertexColors[Vert] = SrcLod.VertexColor[Vert];
+
+		if (UseGpuSkinVerts)
+		{
+			// NOTE: Gears3 has some issues:
+			// - chunk may have FirstVertex set to incorrect value (for recent UE3 versions), which overlaps with the
+			//   previous chunk (FirstVertex=0 for a few chunks)
+			// - index count may be greater than sum of all face counts * 3 from all mesh sections -- this is verified in PSK exporter
+
+			// get vertex from GPU skin
+			const FGPUVert3Common *V;		// has normal and influences, but no UV[] and position
+
+			if (!S.bUseFullPrecisionUVs)
+			{
+				// position
+				const FMeshUVHalf *SUV;
+				if (!S.bUsePackedPosition)
+				{
+					const FGPUVert3Half &V0 = S.VertsHalf[Vert];
+					D->Position = CVT(V0.Pos);
+					V   = &V0;
+					SUV = V0.UV;
+				}
+				else
+				{
+					const FGPUVert3PackedHalf &V0 = S.VertsHalfPacked[Vert];
+					FVector VPos;
+					VPos = V0.Pos.ToVector(S.MeshOrigin, S.MeshExtension);
+					D->Position = CVT(VPos);
+					V   = &V0;
+					SUV = V0.UV;
+				}
+				// UV
+				FMeshUVFloat fUV = SUV[0];			// convert half->float
+				D->UV = CVT(fUV);
+				for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
+				{
+					Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SUV[TexCoordIndex]);
+				}
+			}
+			else
+			{
+				// position
+				const FMeshUVFloat *SUV;
+				if (!S.bUsePackedPosition)
+				{
+					const FGPUVert3Float &V0 = S.VertsFloat[Vert];
+					V = &V0;
+					D->Position = CVT(V0.Pos);
+					SUV = V0.UV;
+				}
+				else
+				{
+					const FGPUVert3PackedFloat &V0 = S.VertsFloatPacked[Vert];
+					V = &V0;
+					FVector VPos;
+					VPos = V0.Pos.ToVector(S.MeshOrigin, S.MeshExtension);
+					D->Position = CVT(VPos);
+					SUV = V0.UV;
+				}
+				// UV
+				FMeshUVFloat fUV = SUV[0];
+				D->UV = CVT(fUV);
+				for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
+				{
+					Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SUV[TexCoordIndex]);
+				}
+			}
+			// convert Normal[3]
+			UnpackNormals(V->Normal, *D);
+			// convert influences
+			int i2 = 0;
+			unsigned PackedWeights = 0;
+			for (int i = 0; i < NUM_INFLUENCES_UE3; i++)
+			{
+				int BoneIndex  = V->BoneIndex[i];
+				byte BoneWeight = V->BoneWeight[i];
+				if (BoneWeight == 0) continue;				// skip this influence (but do not stop the loop!)
+				PackedWeights |= BoneWeight << (i2 * 8);
+				D->Bone[i2]   = C->Bones[BoneIndex];
+				i2++;
+			}
+			D->PackedWeights = PackedWeights;
+			if (i2 < NUM_INFLUENCES_UE3) D->Bone[i2] = INDEX_NONE; // mark end of list
+		}
+		else
+		{
+			// old UE3 version without a GPU skin
+			// get vertex from chunk
+			const FMeshUVFloat *SUV;
+			if (Vert < C->FirstVertex + C->NumRigidVerts)
+			{
+				// rigid vertex
+				const FRigidVertex3 &V0 = C->RigidVerts[Vert - C->FirstVertex];
+				// position and normal
+				D->Position = CVT(V0.Pos);
+				UnpackNormals(V0.Normal, *D);
+				// single influence
+				D->PackedWeights = 0xFF;
+				D->Bone[0]   = C->Bones[V0.BoneIndex];
+				SUV = V0.UV;
+			}
+			else
+			{
+				// soft vertex
+				const FSoftVertex3 &V0 = C->SoftVerts[Vert - C->FirstVertex - C->NumRigidVerts];
+				// position and normal
+				D->Position = CVT(V0.Pos);
+				UnpackNormals(V0.Normal, *D);
+				// influences
+//				int TotalWeight = 0;
+				int i2 = 0;
+				unsigned PackedWeights = 0;
+				for (int i = 0; i < NUM_INFLUENCES_UE3; i++)
+				{
+					int BoneIndex  = V0.BoneIndex[i];
+					byte BoneWeight = V0.BoneWeight[i];
+					if (BoneWeight == 0) continue;
+					PackedWeights |= BoneWeight << (i2 * 8);
+					D->Bone[i2]   = C->Bones[BoneIndex];
+					i2++;
+//					TotalWeight += BoneWeight;
+				}
+				D->PackedWeights = PackedWeights;
+//				assert(TotalWeight == 255);
+				if (i2 < NUM_INFLUENCES_UE3) D->Bone[i2] = INDEX_NONE; // mark end of list
+				SUV = V0.UV;
+			}
+			// UV
+			FMeshUVFloat fUV = SUV[0];			// convert half->float
+			D->UV = CVT(fUV);
+			for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
+			{
+				Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SUV[TexCoordIndex]);
+			}
+		}
+	}
+}
+
 void USkeletalMesh3::ConvertMesh()
 {
 	guard(USkeletalMesh3::ConvertMesh);
@@ -2077,6 +2249,8 @@ void USkeletalMesh3::ConvertMesh()
 	// convert LODs
 	Mesh->Lods.Empty(LODModels.Num());
 	assert(LODModels.Num() == LODInfo.Num());
+	TStaticArray<int, 16> SrcLodIndices;				// LODModels index for each converted LOD
+	TStaticArray<bool, 16> UseGpuSkin;
 	for (int lod = 0; lod < LODModels.Num(); lod++)
 	{
 		guard(ConvertLod);
@@ -2093,8 +2267,6 @@ void USkeletalMesh3::ConvertMesh()
 		Lod->HasNormals   = true;
 		Lod->HasTangents  = true;
 
-		guard(ProcessVerts);
-
 		// get vertex count and determine vertex source
 		int VertexCount = SrcLod.GPUSkin.GetVertexCount();
 		bool UseGpuSkinVerts = (VertexCount > 0);
@@ -2103,172 +2275,15 @@ void USkeletalMesh3::ConvertMesh()
 			const FSkelMeshChunk3 &C = SrcLod.Chunks[SrcLod.Chunks.Num() - 1];		// last chunk
 			VertexCount = C.FirstVertex + C.NumRigidVerts + C.NumSoftVerts;
 		}
-		// allocate the vertices
+		// allocate the vertices, they're converted later for all LODs at once
 		Lod->AllocateVerts(VertexCount);
 		if (SrcLod.VertexColor.Num() == VertexCount)
 			Lod->AllocateVertexColorBuffer();
 		else if (SrcLod.VertexColor.Num())
 			appPrintf("LOD %d has invalid vertex color stream\n", lod);
+		SrcLodIndices.Add(lod);
+		UseGpuSkin.Add(UseGpuSkinVerts);
 
-		int chunkIndex = 0;
-		const FSkelMeshChunk3 *C = NULL;
-		int lastChunkVertex = -1;
-		const FSkeletalMeshVertexBuffer3 &S = SrcLod.GPUSkin;
-		CSkelMeshVertex *D = Lod->Verts;
-		int NumReweightedVerts = 0;
-
-		for (int Vert = 0; Vert < VertexCount; Vert++, D++)
-		{
-			if (Vert >= lastChunkVertex)
-			{
-				// proceed to next chunk
-				C = &SrcLod.Chunks[chunkIndex++];
-				lastChunkVertex = C->FirstVertex + C->NumRigidVerts + C->NumSoftVerts;
-			}
-
-			if (Lod->VertexColors)
-				Lod->VertexColors[Vert] = SrcLod.VertexColor[Vert];
-
-			if (UseGpuSkinVerts)
-			{
-				// NOTE: Gears3 has some issues:
-				// - chunk may have FirstVertex set to incorrect value (for recent UE3 versions), which overlaps with the
-				//   previous chunk (FirstVertex=0 for a few chunks)
-				// - index count may be greater than sum of all face counts * 3 from all mesh sections -- this is verified in PSK exporter
-
-				// get vertex from GPU skin
-				const FGPUVert3Common *V;		// has normal and influences, but no UV[] and position
-
-				if (!S.bUseFullPrecisionUVs)
-				{
-					// position
-					const FMeshUVHalf *SUV;
-					if (!S.bUsePackedPosition)
-					{
-						const FGPUVert3Half &V0 = S.VertsHalf[Vert];
-						D->Position = CVT(V0.Pos);
-						V   = &V0;
-						SUV = V0.UV;
-					}
-					else
-					{
-						const FGPUVert3PackedHalf &V0 = S.VertsHalfPacked[Vert];
-						FVector VPos;
-						VPos = V0.Pos.ToVector(S.MeshOrigin, S.MeshExtension);
-						D->Position = CVT(VPos);
-						V   = &V0;
-						SUV = V0.UV;
-					}
-					// UV
-					FMeshUVFloat fUV = SUV[0];			// convert half->float
-					D->UV = CVT(fUV);
-					for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
-					{
-						Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SUV[TexCoordIndex]);
-					}
-				}
-				else
-				{
-					// position
-					const FMeshUVFloat *SUV;
-					if (!S.bUsePackedPosition)
-					{
-						const FGPUVert3Float &V0 = S.VertsFloat[Vert];
-						V = &V0;
-						D->Position = CVT(V0.Pos);
-						SUV = V0.UV;
-					}
-					else
-					{
-						const FGPUVert3PackedFloat &V0 = S.VertsFloatPacked[Vert];
-						V = &V0;
-						FVector VPos;
-						VPos = V0.Pos.ToVector(S.MeshOrigin, S.MeshExtension);
-						D->Position = CVT(VPos);
-						SUV = V0.UV;
-					}
-					// UV
-					FMeshUVFloat fUV = SUV[0];
-					D->UV = CVT(fUV);
-					for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
-					{
-						Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SUV[TexCoordIndex]);
-					}
-				}
-				// convert Normal[3]
-				UnpackNormals(V->Normal, *D);
-				// convert influences
-				int i2 = 0;
-				unsigned PackedWeights = 0;
-				for (int i = 0; i < NUM_INFLUENCES_UE3; i++)
-				{
-					int BoneIndex  = V->BoneIndex[i];
-					byte BoneWeight = V->BoneWeight[i];
-					if (BoneWeight == 0) continue;				// skip this influence (but do not stop the loop!)
-					PackedWeights |= BoneWeight << (i2 * 8);
-					D->Bone[i2]   = C->Bones[BoneIndex];
-					i2++;
-				}
-				D->PackedWeights = PackedWeights;
-				if (i2 < NUM_INFLUENCES_UE3) D->Bone[i2] = INDEX_NONE; // mark end of list
-			}
-			else
-			{
-				// old UE3 version without a GPU skin
-				// get vertex from chunk
-				const FMeshUVFloat *SUV;
-				if (Vert < C->FirstVertex + C->NumRigidVerts)
-				{
-					// rigid vertex
-					const FRigidVertex3 &V0 = C->RigidVerts[Vert - C->FirstVertex];
-					// position and normal
-					D->Position = CVT(V0.Pos);
-					UnpackNormals(V0.Normal, *D);
-					// single influence
-					D->PackedWeights = 0xFF;
-					D->Bone[0]   = C->Bones[V0.BoneIndex];
-					SUV = V0.UV;
-				}
-				else
-				{
-					// soft vertex
-					const FSoftVertex3 &V0 = C->SoftVerts[Vert - C->FirstVertex - C->NumRigidVerts];
-					// position and normal
-					D->Position = CVT(V0.Pos);
-					UnpackNormals(V0.Normal, *D);
-					// influences
-//					int TotalWeight = 0;
-					int i2 = 0;
-					unsigned PackedWeights = 0;
-					for (int i = 0; i < NUM_INFLUENCES_UE3; i++)
-					{
-						int BoneIndex  = V0.BoneIndex[i];
-						byte BoneWeight = V0.BoneWeight[i];
-						if (BoneWeight == 0) continue;
-						PackedWeights |= BoneWeight << (i2 * 8);
-						D->Bone[i2]   = C->Bones[BoneIndex];
-						i2++;
-//						TotalWeight += BoneWeight;
-					}
-					D->PackedWeights = PackedWeights;
-//					assert(TotalWeight == 255);
-					if (i2 < NUM_INFLUENCES_UE3) D->Bone[i2] = INDEX_NONE; // mark end of list
-					SUV = V0.UV;
-				}
-				// UV
-				FMeshUVFloat fUV = SUV[0];			// convert half->float
-				D->UV = CVT(fUV);
-				for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
-				{
-					Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SUV[TexCoordIndex]);
-				}
-			}
-		}
-
-		if (NumReweightedVerts > 0)
-			appPrintf("LOD %d: adjusted weights for %d vertices\n", lod, NumReweightedVerts);
-
-		unguard;	// ProcessVerts
 
 		// indices
 		Lod->Indices.Initialize(&SrcLod.IndexBuffer.Indices16, &SrcLod.IndexBuffer.Indices32);
@@ -2298,6 +2313,14 @@ void USkeletalMesh3::ConvertMesh()
 		unguardf("lod=%d", lod); // ConvertLod
 	}
 
+	// convert vertices of all LODs
+	guard(ProcessVerts);
+	ParallelForMeshVerts(Mesh->Lods, [this, Mesh, &SrcLodIndices, &UseGpuSkin](int LodIndex, int FirstVert, int NumVerts)
+		{
+			ConvertSkeletalLodVerts(LODModels[SrcLodIndices[LodIndex]], &Mesh->Lods[LodIndex], UseGpuSkin[LodIndex], FirstVert, NumVerts);
+		});
+	unguard;	// ProcessVerts
+
 	// copy skeleton
 	guard(ProcessSkeleton);
 	Mesh->RefSkeleton.Empty(RefSkeleton.Num());
@@ -3816,6 +3839,34 @@ done:
 	unguard;
 }
 
+// Convert vertices [FirstVert, FirstVert+NumVerts) of the LOD
+static void ConvertStaticLodVerts(const FStaticMeshLODModel3& SrcLod, CStaticMeshLod* Lod, int FirstVert, int NumVerts)
+{
+	int NumTexCoords = Lod->NumTexCoords;
+	bool bUseColorStream = (SrcLod.ColorStream.Colors.Num() == Lod->NumVerts);
+
+	for (int i = FirstVert; i < FirstVert + NumVerts; i++)
+	{
+		const FStaticMeshUVItem3 &SUV = SrcLod.UVStream.UV[i];
+		CStaticMeshVertex &V = Lod->Verts[i];
+
+		V.Position = CVT(SrcLod.VertexStream.Verts[i]);
+		UnpackNormals(SUV.Normal, V);
+		// copy UV
+		const FMeshUVFloat* fUV = &SUV.UV[0];
+		V.UV = *CVT(fUV);
+		for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
+		{
+			fUV++;
+			Lod->ExtraUV[TexCoordIndex-1][i] = *CVT(fUV);
+		}
+		if (bUseColorStream)
+			Lod->VertexColors[i] = SrcLod.ColorStream.Colors[i];
+		else
+			Lod->VertexColors[i] = SUV.Color;
+	}
+}
+
 // convert UStaticMesh3 to CStaticMesh
 void UStaticMesh3::ConvertMesh()
 {
@@ -3834,6 +3885,7 @@ void UStaticMesh3::ConvertMesh()
 
 	// convert lods
 	Mesh->Lods.Empty(Lods.Num());
+	TStaticArray<int, 16> SrcLodIndices;				// Lods index for each converted LOD
 	for (int lod = 0; lod < Lods.Num(); lod++)
 	{
 		guard(ConvertLod);
@@ -3872,29 +3924,29 @@ void UStaticMesh3::ConvertMesh()
 			Dst.NumFaces   = Src.NumFaces;
 		}
 
-		// vertices
+		// vertices, they're converted later for all LODs at once
 		Lod->AllocateVerts(NumVerts);
 		Lod->AllocateVertexColorBuffer();
-		for (int i = 0; i < NumVerts; i++)
+		SrcLodIndices.Add(lod);
+
+		// indices
+		Lod->Indices.Initialize(&SrcLod.Indices.Indices);			// 16-bit only
+		if (Lod->Indices.Num() == 0) appNotify("This StaticMesh doesn't have an index buffer");
+
+		unguardf("lod=%d", lod);
+	}
+
+	guard(ProcessVerts);
+	ParallelForMeshVerts(Mesh->Lods, [this, Mesh, &SrcLodIndices](int LodIndex, int FirstVert, int NumVerts)
 		{
-			const FStaticMeshUVItem3 &SUV = SrcLod.UVStream.UV[i];
-			CStaticMeshVertex &V = Lod->Verts[i];
+			ConvertStaticLodVerts(Lods[SrcLodIndices[LodIndex]], &Mesh->Lods[LodIndex], FirstVert, NumVerts);
+		});
+	unguard;
 
-			V.Position = CVT(SrcLod.VertexStream.Verts[i]);
-			UnpackNormals(SUV.Normal, V);
-			// copy UV
-			const FMeshUVFloat* fUV = &SUV.UV[0];
-			V.UV = *CVT(fUV);
-			for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
-			{
-				fUV++;
-				Lod->ExtraUV[TexCoordIndex-1][i] = *CVT(fUV);
-			}
-			if (SrcLod.ColorStream.Colors.Num() == NumVerts)
-				Lod->VertexColors[i] = SrcLod.ColorStream.Colors[i];
-			else
-				Lod->VertexColors[i] = SUV.Color;
-		}
+	for (int lod = 0; lod < Mesh->Lods.Num(); lod++)
+	{
+		CStaticMeshLod *Lod = &Mesh->Lods[lod];
+		int NumVerts = Lod->NumVerts;
 
 		// Remove vertex colors if they're filled with white color
 		bool bAllWhite = true;
@@ -3917,12 +3969,6 @@ void UStaticMesh3::ConvertMesh()
 			appFree(Lod->VertexColors);
 			Lod->VertexColors = NULL;
 		}
-
-		// indices
-		Lod->Indices.Initialize(&SrcLod.Indices.Indices);			// 16-bit only
-		if (Lod->Indices.Num() == 0) appNotify("This StaticMesh doesn't have an index buffer");
-
-		unguardf("lod=%d", lod);
 	}
 
 	Mesh->FinalizeMesh();
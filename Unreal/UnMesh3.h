@@ -528,12 +528,14 @@ public:
 	TArray<int>				TrackOffsets;
 	TArray<uint8>			Trans3Data;
 #endif
+	mutable bool			HolesReported;					// UAnimSet::DecodeSequence() already reported gaps in CompressedByteStream
 
 	UAnimSequence()
 	:	RateScale(1.0f)
 	,	TranslationCompressionFormat(ACF_None)
 	,	RotationCompressionFormat(ACF_None)
 	,	KeyEncodingFormat(AKF_ConstantKeyLerp)
+	,	HolesReported(false)
 	{}
 
 	BEGIN_PROP_TABLE
@@ -705,6 +707,7 @@ public:
 	END_PROP_TABLE
 
 	void ConvertAnims();
+	void DecodeSequence(const UAnimSequence* Seq, CAnimSequence* Dst);
 	virtual void Serialize(FArchive &Ar);
 
 	virtual void PostLoad()
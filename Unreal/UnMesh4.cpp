@@ -1627,6 +1627,118 @@ void USkeletalMesh4::PostLoad()
 	unguard;
 }
 
+// Convert vertices [FirstVert, FirstVert+NumVerts) of the LOD. Could be called for several ranges of
+// the same LOD in parallel.
+static void ConvertSkeletalLodVerts(const FStaticLODModel4& SrcLod, CSkelMeshLod* Lod, bool bUseVerticesFromSections, int FirstVert, int NumVerts)
+{
+	int NumTexCoords = Lod->NumTexCoords;
+
+	int chunkIndex = -1;
+	int lastChunkVertex = -1;
+	int chunkVertexIndex = 0;
+
+	const TArray<uint16>* BoneMap = NULL;
+	const FSkeletalMeshVertexBuffer4& VertBuffer = SrcLod.VertexBufferGPUSkin;
+
+	auto NextChunk = [&]()
+	{
+		// proceed to next chunk or section
+		if (SrcLod.Chunks.Num())
+		{
+			// pre-UE4.13 code: chunks
+			const FSkelMeshChunk4& C = SrcLod.Chunks[++chunkIndex];
+			lastChunkVertex = C.BaseVertexIndex + C.NumRigidVertices + C.NumSoftVertices;
+			BoneMap = &C.BoneMap;
+		}
+		else
+		{
+			// UE4.13+ code: chunk information migrated to sections
+			const FSkelMeshSection4& S = SrcLod.Sections[++chunkIndex];
+			lastChunkVertex = S.BaseVertexIndex + S.NumVertices;
+			BoneMap = &S.BoneMap;
+		}
+		chunkVertexIndex = 0;
+	};
+
+	// Find the chunk of FirstVert, walking chunks exactly as the conversion loop does
+	for (int Vert = 0; Vert < FirstVert; /* empty */)
+	{
+		while (Vert >= lastChunkVertex)
+			NextChunk();
+		int Count = min(lastChunkVertex, FirstVert) - Vert;
+		chunkVertexIndex += Count;
+		Vert += Count;
+	}
+
+	CSkelMeshVertex* D = Lod->Verts + FirstVert;
+	for (int Vert = FirstVert; Vert < FirstVert + NumVerts; Vert++, D++)
+	{
+		while (Vert >= lastChunkVertex) // this will fix any issues with empty chunks or sections
+			NextChunk();
+
+		// get vertex from GPU skin
+		const FSkelMeshVertexBase *V;				// has everything but UV[]
+
+		if (bUseVerticesFromSections)
+		{
+			const FSoftVertex4& V0 = SrcLod.Sections[chunkIndex].SoftVertices[chunkVertexIndex++];
+			const FMeshUVFloat *SrcUV = V0.UV;
+			V = &V0;
+			// UV: simply copy float data
+			D->UV = CVT(SrcUV[0]);
+			for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
+			{
+				Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SrcUV[TexCoordIndex]);
+			}
+		}
+		else if (!VertBuffer.bUseFullPrecisionUVs)
+		{
+			const FGPUVert4Half& V0 = VertBuffer.VertsHalf[Vert];
+			const FMeshUVHalf* SrcUV = V0.UV;
+			V = &V0;
+			// UV: convert half -> float
+			D->UV = CVT(SrcUV[0]);
+			for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
+			{
+				Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SrcUV[TexCoordIndex]);
+			}
+		}
+		else
+		{
+			const FGPUVert4Float& V0 = VertBuffer.VertsFloat[Vert];
+			const FMeshUVFloat *SrcUV = V0.UV;
+			V = &V0;
+			// UV: simply copy float data
+			D->UV = CVT(SrcUV[0]);
+			for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
+			{
+				Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SrcUV[TexCoordIndex]);
+			}
+		}
+		D->Position = CVT(V->Pos);
+		UnpackNormals(V->Normal, *D);
+		if (Lod->VertexColors)
+		{
+			//todo: check if this will work with "source" models - FSoftVertex4 has Color field
+			Lod->VertexColors[Vert] = SrcLod.ColorVertexBuffer.Data[Vert];
+		}
+		// convert influences
+		int i2 = 0;
+		unsigned PackedWeights = 0;
+		for (int i = 0; i < NUM_INFLUENCES_UE4; i++)
+		{
+			int BoneIndex  = V->Infs.BoneIndex[i];
+			byte BoneWeight = V->Infs.BoneWeight[i];
+			if (BoneWeight == 0) continue;				// skip this influence (but do not stop the loop!)
+			PackedWeights |= BoneWeight << (i2 * 8);
+			D->Bone[i2]   = (*BoneMap)[BoneIndex];
+			i2++;
+		}
+		D->PackedWeights = PackedWeights;
+		if (i2 < NUM_INFLUENCES_UE4) D->Bone[i2] = INDEX_NONE; // mark end of list
+	}
+}
+
 void USkeletalMesh4::ConvertMesh()
 {
 	guard(USkeletalMesh4::ConvertMesh);
@@ -1649,6 +1761,8 @@ void USkeletalMesh4::ConvertMesh()
 	// convert LODs
 	Mesh->Lods.Empty(LODModels.Num());
 	assert(LODModels.Num() == LODInfo.Num());
+	TStaticArray<int, 16> SrcLodIndices;				// LODModels index for each converted LOD
+	TStaticArray<bool, 16> UseVerticesFromSections;
 	for (int lod = 0; lod < LODModels.Num(); lod++)
 	{
 		guard(ConvertLod);
@@ -1669,8 +1783,6 @@ void USkeletalMesh4::ConvertMesh()
 		Lod->HasNormals   = true;
 		Lod->HasTangents  = true;
 
-		guard(ProcessVerts);
-
 		// get vertex count and determine vertex source
 		int VertexCount = SrcLod.VertexBufferGPUSkin.GetVertexCount();
 
@@ -1686,108 +1798,16 @@ void USkeletalMesh4::ConvertMesh()
 			}
 		}
 
-		// allocate the vertices
+		// allocate the vertices, they're converted later for all LODs at once
 		Lod->AllocateVerts(VertexCount);
-
-		int chunkIndex = -1;
-		int lastChunkVertex = -1;
-		int chunkVertexIndex = 0;
-
-		const TArray<uint16>* BoneMap = NULL;
-		const FSkeletalMeshVertexBuffer4& VertBuffer = SrcLod.VertexBufferGPUSkin;
-		CSkelMeshVertex* D = Lod->Verts;
+		SrcLodIndices.Add(lod);
+		UseVerticesFromSections.Add(bUseVerticesFromSections);
 
 		if (SrcLod.ColorVertexBuffer.Data.Num() == VertexCount)
 			Lod->AllocateVertexColorBuffer();
 		else if (SrcLod.ColorVertexBuffer.Data.Num())
 			appPrintf("LOD %d has invalid vertex color stream\n", lod);
 
-		for (int Vert = 0; Vert < VertexCount; Vert++, D++)
-		{
-			while (Vert >= lastChunkVertex) // this will fix any issues with empty chunks or sections
-			{
-				// proceed to next chunk or section
-				if (SrcLod.Chunks.Num())
-				{
-					// pre-UE4.13 code: chunks
-					const FSkelMeshChunk4& C = SrcLod.Chunks[++chunkIndex];
-					lastChunkVertex = C.BaseVertexIndex + C.NumRigidVertices + C.NumSoftVertices;
-					BoneMap = &C.BoneMap;
-				}
-				else
-				{
-					// UE4.13+ code: chunk information migrated to sections
-					const FSkelMeshSection4& S = SrcLod.Sections[++chunkIndex];
-					lastChunkVertex = S.BaseVertexIndex + S.NumVertices;
-					BoneMap = &S.BoneMap;
-				}
-				chunkVertexIndex = 0;
-			}
-
-			// get vertex from GPU skin
-			const FSkelMeshVertexBase *V;				// has everything but UV[]
-
-			if (bUseVerticesFromSections)
-			{
-				const FSoftVertex4& V0 = SrcLod.Sections[chunkIndex].SoftVertices[chunkVertexIndex++];
-				const FMeshUVFloat *SrcUV = V0.UV;
-				V = &V0;
-				// UV: simply copy float data
-				D->UV = CVT(SrcUV[0]);
-				for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
-				{
-					Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SrcUV[TexCoordIndex]);
-				}
-			}
-			else if (!VertBuffer.bUseFullPrecisionUVs)
-			{
-				const FGPUVert4Half& V0 = VertBuffer.VertsHalf[Vert];
-				const FMeshUVHalf* SrcUV = V0.UV;
-				V = &V0;
-				// UV: convert half -> float
-				D->UV = CVT(SrcUV[0]);
-				for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
-				{
-					Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SrcUV[TexCoordIndex]);
-				}
-			}
-			else
-			{
-				const FGPUVert4Float& V0 = VertBuffer.VertsFloat[Vert];
-				const FMeshUVFloat *SrcUV = V0.UV;
-				V = &V0;
-				// UV: simply copy float data
-				D->UV = CVT(SrcUV[0]);
-				for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
-				{
-					Lod->ExtraUV[TexCoordIndex-1][Vert] = CVT(SrcUV[TexCoordIndex]);
-				}
-			}
-			D->Position = CVT(V->Pos);
-			UnpackNormals(V->Normal, *D);
-			if (Lod->VertexColors)
-			{
-				//todo: check if this will work with "source" models - FSoftVertex4 has Color field
-				Lod->VertexColors[Vert] = SrcLod.ColorVertexBuffer.Data[Vert];
-			}
-			// convert influences
-			int i2 = 0;
-			unsigned PackedWeights = 0;
-			for (int i = 0; i < NUM_INFLUENCES_UE4; i++)
-			{
-				int BoneIndex  = V->Infs.BoneIndex[i];
-				byte BoneWeight = V->Infs.BoneWeight[i];
-				if (BoneWeight == 0) continue;				// skip this influence (but do not stop the loop!)
-				PackedWeights |= BoneWeight << (i2 * 8);
-				D->Bone[i2]   = (*BoneMap)[BoneIndex];
-				i2++;
-			}
-			D->PackedWeights = PackedWeights;
-			if (i2 < NUM_INFLUENCES_UE4) D->Bone[i2] = INDEX_NONE; // mark end of list
-		}
-
-		unguard;	// ProcessVerts
-
 		// indices
 		Lod->Indices.Initialize(&SrcLod.Indices.Indices16, &SrcLod.Indices.Indices32);
 
@@ -1818,6 +1838,14 @@ void USkeletalMesh4::ConvertMesh()
 		unguardf("lod=%d", lod); // ConvertLod
 	}
 
+	// convert vertices of all LODs
+	guard(ProcessVerts);
+	ParallelForMeshVerts(Mesh->Lods, [this, Mesh, &SrcLodIndices, &UseVerticesFromSections](int LodIndex, int FirstVert, int NumVerts)
+		{
+			ConvertSkeletalLodVerts(LODModels[SrcLodIndices[LodIndex]], &Mesh->Lods[LodIndex], UseVerticesFromSections[LodIndex], FirstVert, NumVerts);
+		});
+	unguard;	// ProcessVerts
+
 	// copy skeleton
 	guard(ProcessSkeleton);
 	int NumBones = RefSkeleton.RefBoneInfo.Num();
@@ -2548,6 +2576,33 @@ no_nav_collision:
 }
 
 
+// Convert vertices [FirstVert, FirstVert+NumVerts) of the LOD
+static void ConvertStaticLodVerts(const FStaticMeshLODModel4& SrcLod, CStaticMeshLod* Lod, int FirstVert, int NumVerts)
+{
+	int NumTexCoords = Lod->NumTexCoords;
+
+	for (int i = FirstVert; i < FirstVert + NumVerts; i++)
+	{
+		const FStaticMeshUVItem4 &SUV = SrcLod.VertexBuffer.UV[i];
+		CStaticMeshVertex &V = Lod->Verts[i];
+
+		V.Position = CVT(SrcLod.PositionVertexBuffer.Verts[i]);
+		UnpackNormals(SUV.Normal, V);
+		// copy UV
+		const FMeshUVFloat* fUV = &SUV.UV[0];
+		V.UV = *CVT(fUV);
+		for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
+		{
+			fUV++;
+			Lod->ExtraUV[TexCoordIndex-1][i] = *CVT(fUV);
+		}
+		if (Lod->VertexColors)
+		{
+			Lod->VertexColors[i] = SrcLod.ColorVertexBuffer.Data[i];
+		}
+	}
+}
+
 void UStaticMesh4::ConvertMesh()
 {
 	guard(UStaticMesh4::ConvertMesh);
@@ -2562,6 +2617,7 @@ void UStaticMesh4::ConvertMesh()
 
 	// convert lods
 	Mesh->Lods.Empty(Lods.Num());
+	TStaticArray<int, 16> SrcLodIndices;				// Lods index for each converted LOD
 	for (int lodIndex = 0; lodIndex < Lods.Num(); lodIndex++)
 	{
 		guard(ConvertLod);
@@ -2599,31 +2655,11 @@ void UStaticMesh4::ConvertMesh()
 			Dst.NumFaces   = Src.NumTriangles;
 		}
 
-		// vertices
+		// vertices, they're converted later for all LODs at once
 		Lod->AllocateVerts(NumVerts);
 		if (SrcLod.ColorVertexBuffer.NumVertices)
 			Lod->AllocateVertexColorBuffer();
-
-		for (int i = 0; i < NumVerts; i++)
-		{
-			const FStaticMeshUVItem4 &SUV = SrcLod.VertexBuffer.UV[i];
-			CStaticMeshVertex &V = Lod->Verts[i];
-
-			V.Position = CVT(SrcLod.PositionVertexBuffer.Verts[i]);
-			UnpackNormals(SUV.Normal, V);
-			// copy UV
-			const FMeshUVFloat* fUV = &SUV.UV[0];
-			V.UV = *CVT(fUV);
-			for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
-			{
-				fUV++;
-				Lod->ExtraUV[TexCoordIndex-1][i] = *CVT(fUV);
-			}
-			if (Lod->VertexColors)
-			{
-				Lod->VertexColors[i] = SrcLod.ColorVertexBuffer.Data[i];
-			}
-		}
+		SrcLodIndices.Add(lodIndex);
 
 		// indices
 		Lod->Indices.Initialize(&SrcLod.IndexBuffer.Indices16, &SrcLod.IndexBuffer.Indices32);
@@ -2632,6 +2668,13 @@ void UStaticMesh4::ConvertMesh()
 		unguardf("lod=%d", lodIndex);
 	}
 
+	guard(ProcessVerts);
+	ParallelForMeshVerts(Mesh->Lods, [this, Mesh, &SrcLodIndices](int LodIndex, int FirstVert, int NumVerts)
+		{
+			ConvertStaticLodVerts(Lods[SrcLodIndices[LodIndex]], &Mesh->Lods[LodIndex], FirstVert, NumVerts);
+		});
+	unguard;
+
 	Mesh->FinalizeMesh();
 
 	unguard;
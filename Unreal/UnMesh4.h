@@ -182,6 +182,7 @@ public:
 	virtual void PostLoad();
 
 	void ConvertAnims(UAnimSequence4* Seq);
+	void DecodeSequence(const UAnimSequence4* Seq, CAnimSequence* Dst);
 };
 
 
@@ -6,9 +6,38 @@
 #include "UnPackageUE3Reader.h"
 
 #include "GameDatabase.h"		// for GetGameTag()
+#include "Parallel.h"
 
 byte GForceCompMethod = 0;		// COMPRESS_...
 
+// Packages could be created from multiple threads (see ScanContent)
+static CMutex PackageMapLock;
+
+// LoadPackage() holds one of these locks while looking up and creating a package, so the same file
+// is never loaded by two threads at the same time. The lock is selected by CGameFileInfo address.
+#define PACKAGE_LOAD_LOCKS		64
+static CMutex PackageLoadLocks[PACKAGE_LOAD_LOCKS];
+
+// Game detected by a custom package tag while packages are loaded in parallel. GForceGame is
+// used by other loading threads, so it is updated by ApplyDetectedGame() after they're finished.
+static volatile int GDetectedGame = 0;
+
+// Make the game detected by package tag the default one for the next packages
+static void SetDetectedGame(int Game)
+{
+	if (appIsWorkerThread())
+		appInterlockedCompareExchange(&GDetectedGame, Game, 0);
+	else if (!GForceGame)
+		GForceGame = Game;
+}
+
+/*static*/ void UnPackage::ApplyDetectedGame()
+{
+	if (GDetectedGame && !GForceGame)
+		GForceGame = GDetectedGame;
+	GDetectedGame = 0;
+}
+
 
 //#define DEBUG_PACKAGE			1
 //#define PROFILE_PACKAGE_TABLES	1
@@ -528,6 +557,10 @@ void FPackageFileSummary::Serialize4(FArchive &Ar)
 
 	if (IsUnversioned && GForceGame == GAME_UNKNOWN)
 	{
+		// GForceGame is changed here, and UI could be displayed; both can't be done from the worker
+		// thread, the caller will load this package again from the main thread
+		if (appIsWorkerThread())
+			appError("Engine version is required for unversioned package");
 		int ver = -LegacyVersion - 1;
 		int verMin = legacyVerToEngineVer[ver];
 		int verMax = legacyVerToEngineVer[ver+1] - 1;
@@ -744,7 +777,7 @@ bool FPackageFileSummary::Serialize(FArchive &Ar)
 		int tmp;			// some additional version?
 		Ar << tmp;
 		Ar.Game = GAME_TaoYuan;
-		if (!GForceGame) GForceGame = GAME_TaoYuan;
+		SetDetectedGame(GAME_TaoYuan);
 		goto tag_ok;
 	}
 #endif // TAO_YUAN
@@ -761,7 +794,7 @@ bool FPackageFileSummary::Serialize(FArchive &Ar)
 	if (Tag == 0x879A4B41)
 	{
 		Ar.Game = GAME_GunLegend;
-		if (!GForceGame) GForceGame = GAME_GunLegend;
+		SetDetectedGame(GAME_GunLegend);
 		goto tag_ok;
 	}
 #endif // GUNLEGEND
@@ -776,7 +809,7 @@ bool FPackageFileSummary::Serialize(FArchive &Ar)
 	if (Tag == 0x7BC342F0)
 	{
 		Ar.Game = GAME_DevilsThird;
-		if (!GForceGame) GForceGame = GAME_DevilsThird;
+		SetDetectedGame(GAME_DevilsThird);
 		goto tag_ok;		// Devil's Third
 	}
 #endif // DEVILS_THIRD
@@ -1292,6 +1325,9 @@ void FObjectImport::Serialize(FArchive& Ar)
 
 UnPackage::UnPackage(const char *filename, FArchive *baseLoader, bool silent)
 :	Loader(NULL)
+,	ExportHashHeads(NULL)
+,	ExportHashNext(NULL)
+,	ExportHashMask(0)
 {
 	guard(UnPackage::UnPackage);
 
@@ -1307,6 +1343,7 @@ UnPackage::UnPackage(const char *filename, FArchive *baseLoader, bool silent)
 		// File is too small
 		return;
 	}
+	UpdateFastReader();
 
 	SetupFrom(*Loader);
 
@@ -1323,22 +1360,7 @@ UnPackage::UnPackage(const char *filename, FArchive *baseLoader, bool silent)
 	if (!silent)
 #endif
 	{
-		PKG_LOG("Loading package: %s Ver: %d/%d ", Filename, Loader->ArVer, Loader->ArLicenseeVer);
-			// don't use 'Summary.FileVersion, Summary.LicenseeVersion' because UE4 has overrides for unversioned packages
-#if UNREAL3
-		if (Game >= GAME_UE3)
-		{
-			PKG_LOG("Engine: %d ", Summary.EngineVersion);
-			FUE3ArchiveReader* UE3Loader = Loader->CastTo<FUE3ArchiveReader>();
-			if (UE3Loader && UE3Loader->IsFullyCompressed)
-				PKG_LOG("[FullComp] ");
-		}
-#endif // UNREAL3
-#if UNREAL4
-		if (Game >= GAME_UE4_BASE && Summary.IsUnversioned)
-			PKG_LOG("[Unversioned] ");
-#endif // UNREAL4
-		PKG_LOG("Names: %d Exports: %d Imports: %d Game: %X\n", Summary.NameCount, Summary.ExportCount, Summary.ImportCount, Game);
+		PrintSummary();
 	}
 
 #if DEBUG_PACKAGE
@@ -1359,7 +1381,8 @@ UnPackage::UnPackage(const char *filename, FArchive *baseLoader, bool silent)
 		if (UE3Loader && UE3Loader->IsFullyCompressed)
 			appError("Fully compressed package %s has additional compression table", filename);
 		// replace Loader with special reader for compressed UE3 archives
-		Loader = new FUE3ArchiveReader(Loader, Summary.CompressionFlags, Summary.CompressedChunks);
+		Loader = new FUE3ArchiveReader(Loader, Summary.CompressionFlags, Summary.CompressedChunks, Filename);
+		UpdateFastReader();
 	}
 #endif // UNREAL3
 
@@ -1411,6 +1434,7 @@ no_depends: ;
 			// Replace loader with this file, but add offset so it will work like it is part of original uasset
 			delete Loader;
 			Loader = new FReaderWrapper(expLoader, -Summary.HeadersSize);
+			UpdateFastReader();
 		}
 		else
 		{
@@ -1428,7 +1452,10 @@ no_depends: ;
 	char *s2 = strchr(buf, '.');
 	if (s2) *s2 = 0;
 	Name = appStrdupPool(buf);
-	PackageMap.Add(this);
+	{
+		CScopedLock Lock(PackageMapLock);
+		PackageMap.Add(this);
+	}
 
 	// Release package file handle
 	CloseReader();
@@ -1441,14 +1468,205 @@ no_depends: ;
 }
 
 
-void UnPackage::LoadNameTable()
+// Verify name, some Korean games (B&S) has garbage there
+static bool IsGoodName(const char* nameStr, int nameLen)
+{
+	int numBadChars = 0;
+	for (int j = 0; j < nameLen; j++)
+	{
+		char c = *nameStr++;
+		if (c < ' ' || c > 0x7F)
+		{
+			// unreadable character
+			return false;
+		}
+		if (c == '$') numBadChars++;		// unicode characters replaced with '$' in FString serializer
+	}
+	if (numBadChars && nameLen >= 64) return false;
+	if (numBadChars >= nameLen / 2 && nameLen > 16) return false;
+	return true;
+}
+
+// Read the whole name table with a single Serialize() call and parse it in place, then put all
+// names to the string pool at once. Used for name formats without game-specific serialization.
+// Returns false when format is not supported or when data doesn't look as expected, in this case
+// the regular name serializer should be used.
+bool UnPackage::LoadNameTableBulk()
+{
+	guard(UnPackage::LoadNameTableBulk);
+
+	if (ReverseBytes) return false;
+
+	// Determine the format of name entry: string followed by object flags or name hashes
+	bool nullTerminated = false;
+	int trailerSize;
+	if ((ArVer < 64) && (Game < GAME_UE4_BASE))
+	{
+		nullTerminated = true;
+		trailerSize = 4;
+	}
+#if UNREAL4
+	else if (Game >= GAME_UE4_BASE)
+	{
+		trailerSize = (ArVer >= VER_UE4_NAME_HASHES_SERIALIZED) ? 4 : 0;
+	#if GEARS4 || DAYSGONE
+		if (Game == GAME_Gears4 || Game == GAME_DaysGone) trailerSize = 4;
+	#endif
+	}
+#endif // UNREAL4
+#if UNREAL3
+	else if (Game >= GAME_UE3)
+	{
+		// games with custom name entries, see LoadNameTable()
+	#if DCU_ONLINE
+		if (Game == GAME_DCUniverse) return false;
+	#endif
+	#if R6VEGAS
+		if (Game == GAME_R6Vegas2) return false;
+	#endif
+	#if TRANSFORMERS
+		if (Game == GAME_Transformers) return false;
+	#endif
+	#if AVA
+		if (Game == GAME_AVA) return false;
+	#endif
+	#if WHEELMAN
+		if (Game == GAME_Wheelman) return false;
+	#endif
+	#if MASSEFF
+		if (Game >= GAME_MassEffect && Game <= GAME_MassEffect3) return false;
+	#endif
+	#if MKVSDC
+		if (Game == GAME_MK) return false;
+	#endif
+	#if METRO_CONF
+		if (Game == GAME_MetroConflict) return false;
+	#endif
+		trailerSize = (ArVer >= 195) ? 8 : 4;
+	}
+#endif // UNREAL3
+	else
+	{
+		return false;
+	}
+
+	// Name table size is not stored, so read everything up to the next table
+	int endPos = GetFileSize();
+	if (Summary.ImportOffset > Summary.NameOffset) endPos = min(endPos, Summary.ImportOffset);
+	if (Summary.ExportOffset > Summary.NameOffset) endPos = min(endPos, Summary.ExportOffset);
+	int dataSize = endPos - Summary.NameOffset;
+	if (dataSize <= 0 || dataSize > (64 << 20)) return false;
+
+	TArray<byte> Data;
+	Data.AddUninitialized(dataSize);
+	Seek(Summary.NameOffset);
+	Serialize(Data.GetData(), dataSize);
+
+	// Parse names, strings are converted to ANSI and null-terminated in place
+	byte* p = Data.GetData();
+	const byte* end = p + dataSize;
+	for (int i = 0; i < Summary.NameCount; i++)
+	{
+		char* str;
+		int len;
+		if (nullTerminated)
+		{
+			str = (char*)p;
+			byte* term = (byte*)memchr(p, 0, min(end - p, MAX_FNAME_LEN));
+			if (!term) return false;
+			len = term - p;
+			p = term + 1;
+		}
+		else
+		{
+			if (end - p < 4) return false;
+			memcpy(&len, p, 4);
+			p += 4;
+			str = (char*)p;
+			if (len > 0)
+			{
+				// ANSI string
+				if (len > end - p || p[len-1] != 0) return false;
+				p += len;
+			}
+			else if (len < 0)
+			{
+				// UNICODE string, the same conversion as in FString serializer
+				len = -len;
+				if (len > (end - p) / 2) return false;
+				for (int j = 0; j < len; j++, p += 2)
+				{
+					uint16 c = p[0] | (p[1] << 8);
+					if (c & 0xFF00) c = '$';
+					str[j] = c & 255;
+				}
+				if (str[len-1] != 0) return false;
+			}
+			else
+			{
+				// empty string, point to the null byte of the length
+				str = (char*)p - 1;
+				len = 1;
+			}
+			len--;			// don't count null character
+		}
+		if (trailerSize > end - p) return false;
+		p += trailerSize;
+
+		if (!nullTerminated)
+		{
+			// Trim spaces in place, as LoadNameTable() does for FString names
+			while (len > 0 && isspace(*str))
+			{
+				str++;
+				len--;
+			}
+			while (len > 0 && isspace(str[len-1]))
+				len--;
+			str[len] = 0;
+		}
+		NameTable[i] = str;
+	}
+	Seek(Summary.NameOffset + (p - Data.GetData()));
+
+	// Verify FString names only when the whole table was parsed, so warnings are not displayed twice
+	if (!nullTerminated)
+	{
+		for (int i = 0; i < Summary.NameCount; i++)
+		{
+			if (!IsGoodName(NameTable[i], strlen(NameTable[i])))
+			{
+				// replace name
+				appPrintf("WARNING: %s: fixing name %d (%s)\n", Filename, i, NameTable[i]);
+				char buf[64];
+				appSprintf(ARRAY_ARG(buf), "__name_%d__", i);
+				NameTable[i] = appStrdupPool(buf);
+			}
+		}
+	}
+
+	// Put names to the string pool, NameTable entries will point to pooled copies
+	appStrdupPoolBatch(NameTable, Summary.NameCount);
+
+#if DEBUG_PACKAGE
+	for (int i = 0; i < Summary.NameCount; i++)
+		PKG_LOG("Name[%d]: \"%s\"\n", i, NameTable[i]);
+#endif
+	return true;
+
+	unguard;
+}
+
+void UnPackage::LoadNameTable(bool allowBulk)
 {
 	guard(UnPackage::LoadNameTable);
 
 	if (Summary.NameCount == 0) return;
 
-	Seek(Summary.NameOffset);
 	NameTable = new const char* [Summary.NameCount];
+	if (allowBulk && LoadNameTableBulk()) return;
+
+	Seek(Summary.NameOffset);
 	for (int i = 0; i < Summary.NameCount; i++)
 	{
 		guard(Name);
@@ -1609,24 +1827,7 @@ void UnPackage::LoadNameTable()
 			{
 				// Paragon has many names ended with '\n', so it's good idea to trim spaces
 				name.TrimStartAndEndInline();
-				bool goodName = true;
-				int numBadChars = 0;
-				int nameLen = name.Len();
-				const char* nameStr = *name;
-				for (int j = 0; j < nameLen; j++)
-				{
-					char c = *nameStr++;
-					if (c < ' ' || c > 0x7F)
-					{
-						// unreadable character
-						goodName = false;
-						break;
-					}
-					if (c == '$') numBadChars++;		// unicode characters replaced with '$' in FString serializer
-				}
-				if (numBadChars && nameLen >= 64) goodName = false;
-				if (numBadChars >= nameLen / 2 && nameLen > 16) goodName = false;
-				if (!goodName)
+				if (!IsGoodName(*name, name.Len()))
 				{
 					// replace name
 					appPrintf("WARNING: %s: fixing name %d (%s)\n", Filename, i, *name);
@@ -1719,6 +1920,20 @@ void UnPackage::LoadNameTable()
 	unguard;
 }
 
+void UnPackage::ReloadNameTable(bool allowBulk)
+{
+	guard(UnPackage::ReloadNameTable);
+
+	bool wasOpen = IsOpen();
+	if (!wasOpen) Open();
+	delete[] NameTable;
+	NameTable = NULL;
+	LoadNameTable(allowBulk);
+	if (!wasOpen) CloseReader();
+
+	unguardf("%s", Filename);
+}
+
 
 void UnPackage::LoadImportTable()
 {
@@ -1779,6 +1994,9 @@ void UnPackage::LoadExportTable()
 	}
 #endif // DEBUG_PACKAGE
 
+	// Build the hash here rather than in FindExport(), which could be called from several threads at once
+	BuildExportHash();
+
 	unguard;
 }
 
@@ -1788,11 +2006,14 @@ UnPackage::~UnPackage()
 	guard(UnPackage::~UnPackage);
 
 	// Remove self from package table (it will be there even if package is not "valid")
-	int i = PackageMap.FindItem(this);
-	if (i != INDEX_NONE)
 	{
-		// Could be INDEX_NONE in a case of bad package
-		PackageMap.RemoveAt(i);
+		CScopedLock Lock(PackageMapLock);
+		int i = PackageMap.FindItem(this);
+		if (i != INDEX_NONE)
+		{
+			// Could be INDEX_NONE in a case of bad package
+			PackageMap.RemoveAt(i);
+		}
 	}
 	// unlink package from CGameFileInfo
 	const CGameFileInfo * expInfo = appFindGameFile(Filename);
@@ -1817,6 +2038,11 @@ UnPackage::~UnPackage()
 #if UNREAL3
 	if (DependsTable) delete DependsTable;
 #endif
+	if (ExportHashHeads)
+	{
+		delete[] ExportHashHeads;
+		delete[] ExportHashNext;
+	}
 
 	unguard;
 }
@@ -1829,6 +2055,26 @@ UnPackage::~UnPackage()
 	}
 }
 
+void UnPackage::PrintSummary() const
+{
+	PKG_LOG("Loading package: %s Ver: %d/%d ", Filename, Loader->ArVer, Loader->ArLicenseeVer);
+		// don't use 'Summary.FileVersion, Summary.LicenseeVersion' because UE4 has overrides for unversioned packages
+#if UNREAL3
+	if (Game >= GAME_UE3)
+	{
+		PKG_LOG("Engine: %d ", Summary.EngineVersion);
+		const FUE3ArchiveReader* UE3Loader = Loader->CastTo<FUE3ArchiveReader>();
+		if (UE3Loader && UE3Loader->IsFullyCompressed)
+			PKG_LOG("[FullComp] ");
+	}
+#endif // UNREAL3
+#if UNREAL4
+	if (Game >= GAME_UE4_BASE && Summary.IsUnversioned)
+		PKG_LOG("[Unversioned] ");
+#endif // UNREAL4
+	PKG_LOG("Names: %d Exports: %d Imports: %d Game: %X\n", Summary.NameCount, Summary.ExportCount, Summary.ImportCount, Game);
+}
+
 
 #if 0
 // Commented, not used
@@ -2035,18 +2281,66 @@ FArchive& UnPackage::operator<<(UObject *&Obj)
 	Loading particular import or export package entry
 -----------------------------------------------------------------------------*/
 
+// Case-insensitive hash of object name
+static unsigned GetObjectNameHash(const char* Name)
+{
+	unsigned hash = 0;
+	while (char c = *Name++)
+	{
+		if (c >= 'A' && c <= 'Z') c += 'a' - 'A'; // lowercase a character
+		hash = ROL32(hash, 1) + c;
+	}
+	return hash;
+}
+
+void UnPackage::BuildExportHash()
+{
+	guard(UnPackage::BuildExportHash);
+
+	// Use power of 2 hash size, not less than number of exports
+	int HashSize = 256;
+	while (HashSize < Summary.ExportCount)
+		HashSize <<= 1;
+	ExportHashMask = HashSize - 1;
+	ExportHashHeads = new int[HashSize];
+	ExportHashNext = new int[Summary.ExportCount];
+	for (int i = 0; i < HashSize; i++)
+		ExportHashHeads[i] = INDEX_NONE;
+
+	// Add items in reverse order, so every hash chain will be sorted by export index
+	for (int i = Summary.ExportCount - 1; i >= 0; i--)
+	{
+		int hash = GetObjectNameHash(ExportTable[i].ObjectName) & ExportHashMask;
+		ExportHashNext[i] = ExportHashHeads[hash];
+		ExportHashHeads[hash] = i;
+	}
+
+	unguard;
+}
+
 int UnPackage::FindExport(const char *name, const char *className, int firstIndex) const
 {
-	for (int i = firstIndex; i < Summary.ExportCount; i++)
+	if (Summary.ExportCount <= 0 || !ExportHashHeads)		// no exports, or the export table wasn't loaded
+		return INDEX_NONE;
+
+	// Names are allocated with appStrdupPool, so in most cases pointer comparison will succeed,
+	// but names are case-insensitive, so fall back to stricmp
+	for (int i = ExportHashHeads[GetObjectNameHash(name) & ExportHashMask]; i != INDEX_NONE; i = ExportHashNext[i])
 	{
+		if (i < firstIndex)
+			continue;
 		const FObjectExport &Exp = ExportTable[i];
 		// compare object name
-		if (stricmp(Exp.ObjectName, name) != 0)
+		const char *foundName = Exp.ObjectName;
+		if (foundName != name && stricmp(foundName, name) != 0)
 			continue;
 		// if class name specified - compare it too
-		const char *foundClassName = GetObjectName(Exp.ClassIndex);
-		if (className && stricmp(foundClassName, className) != 0)
-			continue;
+		if (className)
+		{
+			const char *foundClassName = GetObjectName(Exp.ClassIndex);
+			if (foundClassName != className && stricmp(foundClassName, className) != 0)
+				continue;
+		}
 		return i;
 	}
 	return INDEX_NONE;
@@ -2440,6 +2734,7 @@ TArray<char*>		MissingPackages;
 
 	if (info && info->IsPackage)
 	{
+		CScopedLock Lock(PackageLoadLocks[(size_t(info) >> 4) % PACKAGE_LOAD_LOCKS]);
 		// Check if package was already loaded.
 		if (info->Package)
 			return info->Package;
@@ -2461,17 +2756,20 @@ TArray<char*>		MissingPackages;
 		// This is rare situation, so we can allow a bit unoptimized code here - linear search
 		// for package inside a PackageMap array.
 
-		// Check in missing package names. This check will allow to print "missing package"
-		// warning only once.
-		for (i = 0; i < MissingPackages.Num(); i++)
-			if (!stricmp(LocalName, MissingPackages[i]))
-				return NULL;
-		// Check in loaded packages list. This is done to prevent loading the same package
-		// twice when this function is called with a different filename qualifiers:
-		// "path/package.ext", "package.ext", "package"
-		for (i = 0; i < PackageMap.Num(); i++)
-			if (!stricmp(LocalName, PackageMap[i]->Filename))
-				return PackageMap[i];
+		{
+			CScopedLock Lock(PackageMapLock);
+			// Check in missing package names. This check will allow to print "missing package"
+			// warning only once.
+			for (i = 0; i < MissingPackages.Num(); i++)
+				if (!stricmp(LocalName, MissingPackages[i]))
+					return NULL;
+			// Check in loaded packages list. This is done to prevent loading the same package
+			// twice when this function is called with a different filename qualifiers:
+			// "path/package.ext", "package.ext", "package"
+			for (i = 0; i < PackageMap.Num(); i++)
+				if (!stricmp(LocalName, PackageMap[i]->Filename))
+					return PackageMap[i];
+		}
 
 		// Try to load package using file name.
 		if (appFileExists(Name))
@@ -2484,6 +2782,7 @@ TArray<char*>		MissingPackages;
 			}
 			return package;
 		}
+		CScopedLock Lock(PackageMapLock);
 		MissingPackages.Add(appStrdup(LocalName));
 	}
 
@@ -258,13 +258,22 @@ public:
 	// When the package is already loaded, this function will simply return a pointer
 	// to previously loaded UnPackage.
 	static UnPackage *LoadPackage(const char *Name, bool silent = false);
+	// Game could be detected by a package tag in a worker thread, but GForceGame is updated only
+	// when this function is called after all loading tasks are finished
+	static void ApplyDetectedGame();
 	// We've protected UnPackage's destructor, however it is possible to use UnloadPackage to destroy package.
 	static void UnloadPackage(UnPackage* package);
 
+	// Print the "Loading package" line with version and table sizes, used for packages loaded silently
+	void PrintSummary() const;
+
 	// Create loader FArchive for package
 	static FArchive* CreateLoader(const char* filename, FArchive* baseLoader = NULL);
 	// Change loader for games with tricky package data
 	void ReplaceLoader();
+	// Let primitive type serializers read data directly from the Loader's inline window,
+	// should be called every time when Loader is changed
+	void UpdateFastReader();
 
 	static const TArray<UnPackage*>& GetPackageMap()
 	{
@@ -401,11 +410,21 @@ public:
 		Loader->Close();
 	}
 
+	// Read name table once again, used for benchmarking of name table parsers
+	void ReloadNameTable(bool allowBulk);
+
 private:
-	void LoadNameTable();
+	void LoadNameTable(bool allowBulk = true);
+	bool LoadNameTableBulk();
 	void LoadImportTable();
 	void LoadExportTable();
 
+	// Hash of export names used by FindExport(), built by LoadExportTable()
+	int						*ExportHashHeads;	// first export index for every hash value, or INDEX_NONE
+	int						*ExportHashNext;	// next export with the same hash value, in ascending order
+	int						ExportHashMask;
+	void BuildExportHash();
+
 	static TArray<UnPackage*> PackageMap;
 };
 
@@ -6,6 +6,201 @@
 
 #include "UnPackageUE3Reader.h"
 
+#include "Parallel.h"
+
+/*-----------------------------------------------------------------------------
+	Decompressed block cache
+-----------------------------------------------------------------------------*/
+
+#if UNREAL3
+
+#define BLOCK_CACHE_SIZE		(64 << 20)		// max amount of memory used by cached blocks
+#define BLOCK_CACHE_HASH_SIZE	4096
+
+static CMutex GBlockCacheLock;
+static FCachedBlock* GBlockHash[BLOCK_CACHE_HASH_SIZE];
+static FCachedBlock* GLruFirst = NULL;			// most recently used block
+static FCachedBlock* GLruLast = NULL;			// least recently used block
+static size_t GBlockCacheMemory = 0;
+static int GNumCachedBlocks = 0;
+static int GBlockCacheHits = 0;
+static int GBlockCacheMisses = 0;
+static int GBlockCacheEvictions = 0;
+
+static THREAD_LOCAL byte* GScratchBuffer = NULL;
+static THREAD_LOCAL int GScratchBufferSize = 0;
+
+inline int GetBlockHash(const char* File, int Layer, int Offset)
+{
+	return (int(size_t(File) >> 4) * 31 + Layer * 7 + (Offset >> 10)) & (BLOCK_CACHE_HASH_SIZE - 1);
+}
+
+static void LinkLru(FCachedBlock* Block)
+{
+	Block->LruPrev = NULL;
+	Block->LruNext = GLruFirst;
+	if (GLruFirst)
+		GLruFirst->LruPrev = Block;
+	else
+		GLruLast = Block;
+	GLruFirst = Block;
+}
+
+static void UnlinkLru(FCachedBlock* Block)
+{
+	if (Block->LruPrev)
+		Block->LruPrev->LruNext = Block->LruNext;
+	else
+		GLruFirst = Block->LruNext;
+	if (Block->LruNext)
+		Block->LruNext->LruPrev = Block->LruPrev;
+	else
+		GLruLast = Block->LruPrev;
+	Block->LruPrev = Block->LruNext = NULL;
+}
+
+static void UnlinkHash(FCachedBlock* Block)
+{
+	for (FCachedBlock** Prev = &GBlockHash[GetBlockHash(Block->File, Block->Layer, Block->Offset)]; *Prev; Prev = &(*Prev)->HashNext)
+	{
+		if (*Prev == Block)
+		{
+			*Prev = Block->HashNext;
+			break;
+		}
+	}
+	Block->HashNext = NULL;
+}
+
+// Remove block from cache, should be called for unlocked blocks only
+static void UnlinkBlock(FCachedBlock* Block)
+{
+	assert(Block->IsLinked && Block->RefCount == 0);
+	UnlinkHash(Block);
+	UnlinkLru(Block);
+	Block->IsLinked = false;
+	GNumCachedBlocks--;
+}
+
+static void FreeBlock(FCachedBlock* Block)
+{
+	GBlockCacheMemory -= Block->Capacity;
+	appFree(Block->Data);
+	delete Block;
+}
+
+FCachedBlock* CBlockCache::Find(const char* File, int Layer, int Offset)
+{
+	CScopedLock Lock(GBlockCacheLock);
+	for (FCachedBlock* Block = GBlockHash[GetBlockHash(File, Layer, Offset)]; Block; Block = Block->HashNext)
+	{
+		if (Block->File == File && Block->Layer == Layer && Block->Offset == Offset)
+		{
+			Block->RefCount++;
+			// move to the head of LRU list
+			UnlinkLru(Block);
+			LinkLru(Block);
+			GBlockCacheHits++;
+			return Block;
+		}
+	}
+	GBlockCacheMisses++;
+	return NULL;
+}
+
+FCachedBlock* CBlockCache::Allocate(const char* File, int Layer, int Offset, int Size)
+{
+	guard(CBlockCache::Allocate);
+
+	CScopedLock Lock(GBlockCacheLock);
+
+	// Evict least recently used unlocked blocks, reuse the memory of one of them
+	FCachedBlock* Block = NULL;
+	FCachedBlock* Candidate = GLruLast;
+	while (Candidate && GBlockCacheMemory + Size > BLOCK_CACHE_SIZE)
+	{
+		FCachedBlock* Prev = Candidate->LruPrev;
+		if (Candidate->RefCount == 0)
+		{
+			UnlinkBlock(Candidate);
+			GBlockCacheEvictions++;
+			if (!Block && Candidate->Capacity >= Size)
+			{
+				Block = Candidate;
+				GBlockCacheMemory -= Block->Capacity;	// re-added below
+			}
+			else
+			{
+				FreeBlock(Candidate);
+			}
+		}
+		Candidate = Prev;
+	}
+
+	if (!Block)
+	{
+		Block = new FCachedBlock;
+		Block->Capacity = Size;
+		Block->Data = (byte*)appMalloc(Size);
+	}
+	GBlockCacheMemory += Block->Capacity;
+
+	Block->Size = Size;
+	Block->File = File;
+	Block->Layer = Layer;
+	Block->Offset = Offset;
+	Block->RefCount = 1;
+	Block->IsLinked = false;
+	Block->HashNext = Block->LruPrev = Block->LruNext = NULL;
+	return Block;
+
+	unguard;
+}
+
+void CBlockCache::Commit(FCachedBlock* Block)
+{
+	CScopedLock Lock(GBlockCacheLock);
+	assert(!Block->IsLinked && Block->RefCount > 0);
+	FCachedBlock*& Head = GBlockHash[GetBlockHash(Block->File, Block->Layer, Block->Offset)];
+	Block->HashNext = Head;
+	Head = Block;
+	LinkLru(Block);
+	Block->IsLinked = true;
+	GNumCachedBlocks++;
+}
+
+void CBlockCache::Release(FCachedBlock* Block)
+{
+	CScopedLock Lock(GBlockCacheLock);
+	assert(Block->RefCount > 0);
+	if (--Block->RefCount == 0 && !Block->IsLinked)
+	{
+		// This block was never committed (decompression error)
+		FreeBlock(Block);
+	}
+}
+
+byte* CBlockCache::GetScratchBuffer(int Size)
+{
+	if (Size > GScratchBufferSize)
+	{
+		if (GScratchBuffer) appFree(GScratchBuffer);
+		GScratchBufferSize = Align(Size, 65536);
+		GScratchBuffer = (byte*)appMalloc(GScratchBufferSize);
+	}
+	return GScratchBuffer;
+}
+
+void CBlockCache::PrintStats()
+{
+	CScopedLock Lock(GBlockCacheLock);
+	if (!GBlockCacheHits && !GBlockCacheMisses) return;
+	appPrintf("Block cache: %d hits, %d misses, %d evictions, %d blocks (%d Kb) cached\n",
+		GBlockCacheHits, GBlockCacheMisses, GBlockCacheEvictions, GNumCachedBlocks, (int)(GBlockCacheMemory >> 10));
+}
+
+#endif // UNREAL3
+
 /*-----------------------------------------------------------------------------
 	Lineage2 file reader
 -----------------------------------------------------------------------------*/
@@ -435,7 +630,7 @@ public:
 		byte CompMethod = GForceCompMethod;
 		if (!CompMethod)
 			CompMethod = (Loader->Platform == PLATFORM_XBOX360) ? COMPRESS_LZX : COMPRESS_FIND;
-		FUE3ArchiveReader* UE3Loader = new FUE3ArchiveReader(Loader, CompMethod, Chunks);
+		FUE3ArchiveReader* UE3Loader = new FUE3ArchiveReader(Loader, CompMethod, Chunks, appSkipRootDir(filename));
 		UE3Loader->IsFullyCompressed = true;
 		Loader = UE3Loader;
 		unguard;
@@ -447,6 +642,17 @@ public:
 	unguardf("%s", filename);
 }
 
+void UnPackage::UpdateFastReader()
+{
+	// Plain FReaderWrapper only adds an offset to the position, which doesn't affect the inline
+	// window. Derived wrappers are decrypting data in Serialize(), so they're used as is, and
+	// because they have no window, every read will go through Serialize().
+	FArchive* Ar = Loader;
+	if (!strcmp(Ar->GetName(), FReaderWrapper::StaticGetName()))
+		Ar = static_cast<FReaderWrapper*>(Ar)->Reader;
+	FastAr = Ar->FastAr;
+}
+
 void UnPackage::ReplaceLoader()
 {
 	guard(UnPackage::ReplaceLoader);
@@ -473,8 +679,9 @@ void UnPackage::ReplaceLoader()
 			UncompOffset             += 32768;
 		}
 		// Replace Loader for reading compressed Bioshock archives.
-		Loader = new FUE3ArchiveReader(Loader, COMPRESS_ZLIB, Chunks);
+		Loader = new FUE3ArchiveReader(Loader, COMPRESS_ZLIB, Chunks, Filename);
 		Loader->SetupFrom(*this);
+		UpdateFastReader();
 	}
 #endif // BIOSHOCK
 
@@ -486,7 +693,11 @@ void UnPackage::ReplaceLoader()
 		{
 			int IsEncrypted;
 			*this << IsEncrypted;
-			if (IsEncrypted) Loader = new FFileReaderAA2(Loader);
+			if (IsEncrypted)
+			{
+				Loader = new FFileReaderAA2(Loader);
+				UpdateFastReader();
+			}
 		}
 	}
 #endif // AA2
@@ -524,8 +735,9 @@ void UnPackage::ReplaceLoader()
 		TArray<FCompressedChunk> Chunks;
 		*RocketReader << Chunks;
 
-		Loader = new FUE3ArchiveReader(RocketReader, COMPRESS_ZLIB, Chunks);
+		Loader = new FUE3ArchiveReader(RocketReader, COMPRESS_ZLIB, Chunks, Filename);
 		Loader->SetupFrom(*this);
+		UpdateFastReader();
 
 		// The decompressed chunks will overwrite past CompressedChunkInfoOffset, so don't decrypt past that anymore
 		RocketReader->EncryptionEnd = RocketReader->EncryptionStart + CompressedChunkInfoOffset;
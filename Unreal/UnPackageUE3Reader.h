@@ -7,6 +7,44 @@
 
 #if UNREAL3
 
+// Decompressed block, stored in CBlockCache
+struct FCachedBlock
+{
+	byte*					Data;
+	int						Size;
+	// internal data
+	int						Capacity;
+	const char				*File;
+	int						Layer;
+	int						Offset;
+	int						RefCount;
+	bool					IsLinked;		// block data is valid and could be found with CBlockCache::Find()
+	FCachedBlock			*HashNext;
+	FCachedBlock			*LruPrev;		// towards most recently used
+	FCachedBlock			*LruNext;		// towards least recently used
+};
+
+// Process-wide memory-bounded LRU cache of decompressed blocks of compressed packages.
+// Blocks are identified with file name (pooled string), compression layer (fully compressed
+// packages could have compressed chunks inside) and position of compressed data in that layer,
+// so all readers of the same file share blocks. Blocks returned by Find() and Allocate() are
+// locked, and will not be evicted until released with Release().
+class CBlockCache
+{
+public:
+	// Returns NULL when block is not cached
+	static FCachedBlock* Find(const char* File, int Layer, int Offset);
+	// Allocate a new block, it will be visible for Find() after Commit()
+	static FCachedBlock* Allocate(const char* File, int Layer, int Offset, int Size);
+	static void Commit(FCachedBlock* Block);
+	static void Release(FCachedBlock* Block);
+
+	// Reusable buffer for reading compressed data, one per thread
+	static byte* GetScratchBuffer(int Size);
+
+	static void PrintStats();
+};
+
 class FUE3ArchiveReader : public FArchive
 {
 	DECLARE_ARCHIVE(FUE3ArchiveReader, FArchive);
@@ -22,11 +60,15 @@ public:
 	// used for compressed data)
 	int						Stopper;
 	int						Position;
-	// decompression buffer
-	byte					*Buffer;
-	int						BufferSize;
+	// decompression buffer, points to CachedBlock or HeaderBuffer
+	const byte				*Buffer;
 	int						BufferStart;
 	int						BufferEnd;
+	FCachedBlock			*CachedBlock;
+	byte					*HeaderBuffer;
+	// block cache key
+	const char				*FileKey;		// file name allocated with appStrdupPool()
+	int						Layer;			// number of FUE3ArchiveReader's below this one
 	// chunk
 	const FCompressedChunk	*CurrentChunk;
 	FCompressedChunkHeader	ChunkHeader;
@@ -34,19 +76,26 @@ public:
 
 	int						PositionOffset;
 
-	FUE3ArchiveReader(FArchive *File, int Flags, const TArray<FCompressedChunk> &Chunks)
+	FUE3ArchiveReader(FArchive *File, int Flags, const TArray<FCompressedChunk> &Chunks, const char* InFileKey)
 	:	Reader(File)
 	,	IsFullyCompressed(false)
 	,	CompressionFlags(Flags)
+	,	Stopper(0)
+	,	Position(0)
 	,	Buffer(NULL)
-	,	BufferSize(0)
 	,	BufferStart(0)
 	,	BufferEnd(0)
+	,	CachedBlock(NULL)
+	,	HeaderBuffer(NULL)
 	,	CurrentChunk(NULL)
 	,	PositionOffset(0)
 	{
 		guard(FUE3ArchiveReader::FUE3ArchiveReader);
 		CopyArray(CompressedChunks, Chunks);
+		FileKey = appStrdupPool(InFileKey);
+		Layer = 0;
+		if (FUE3ArchiveReader* Inner = File->CastTo<FUE3ArchiveReader>())
+			Layer = Inner->Layer + 1;
 		SetupFrom(*File);
 		assert(CompressionFlags);
 		assert(CompressedChunks.Num());
@@ -55,7 +104,7 @@ public:
 
 	virtual ~FUE3ArchiveReader()
 	{
-		if (Buffer) delete[] Buffer;
+		ReleaseBuffer();
 		if (Reader) delete Reader;
 	}
 
@@ -68,6 +117,7 @@ public:
 	{
 		guard(FUE3ArchiveReader::Serialize);
 
+		Position += ConsumeFastWindow();
 		if (Stopper > 0 && Position + size > Stopper)
 			appError("Serializing behind stopper (%X+%X > %X)", Position, size, Stopper);
 
@@ -83,12 +133,13 @@ public:
 				Position += ToCopy;
 				size     -= ToCopy;
 				data     = OffsetPointer(data, ToCopy);
-				if (!size) return;										// copied enough
+				if (!size) break;										// copied enough
 			}
 			// here: data/size points outside of loaded Buffer
 			PrepareBuffer(Position);
 			assert(Position >= BufferStart && Position < BufferEnd);	// validate PrepareBuffer()
 		}
+		UpdateFastWindow();
 
 		unguard;
 	}
@@ -109,14 +160,14 @@ public:
 		// DC Universe has uncompressed package headers but compressed remaining package part
 		if (Pos < Chunk->UncompressedOffset)
 		{
-			if (Buffer) delete[] Buffer;
+			ReleaseBuffer();
 			int Size = Chunk->CompressedOffset;
-			Buffer      = new byte[Size];
-			BufferSize  = Size;
+			HeaderBuffer = new byte[Size];
+			Reader->Seek(0);
+			Reader->Serialize(HeaderBuffer, Size);
+			Buffer      = HeaderBuffer;
 			BufferStart = 0;
 			BufferEnd   = Size;
-			Reader->Seek(0);
-			Reader->Serialize(Buffer, Size);
 			return;
 		}
 
@@ -171,41 +222,51 @@ public:
 			ChunkData     += Block->CompressedSize;
 		}
 		assert(Block);
-		// read compressed data
-		//?? optimize? can share compressed buffer and decompressed buffer between packages
-		byte *CompressedBlock = new byte[Block->CompressedSize];
-		Reader->Seek(ChunkData);
-		Reader->Serialize(CompressedBlock, Block->CompressedSize);
-		// prepare buffer for decompression
-		if (Block->UncompressedSize > BufferSize)
+		ReleaseBuffer();
+		// the block could be already decompressed by this or another reader
+		FCachedBlock* Cached = CBlockCache::Find(FileKey, Layer, ChunkData);
+		if (!Cached)
 		{
-			if (Buffer) delete[] Buffer;
-			Buffer = new byte[Block->UncompressedSize];
-			BufferSize = Block->UncompressedSize;
-		}
-		// decompress data
-		guard(DecompressBlock);
-		if (ChunkHeader.BlockSize != -1)	// my own mark
-		{
-			// Decompress block
+			Cached = CBlockCache::Allocate(FileKey, Layer, ChunkData, Block->UncompressedSize);
+			CachedBlock = Cached;		// will be released by ReleaseBuffer() in a case of error
 			int UsedCompressionFlags = CompressionFlags;
 #if BATMAN
 			if (Game == GAME_Batman4 && CompressionFlags == 8) UsedCompressionFlags = COMPRESS_LZ4;
 #endif
-			appDecompress(CompressedBlock, Block->CompressedSize, Buffer, Block->UncompressedSize, UsedCompressionFlags);
-		}
-		else
-		{
-			// No compression
-			assert(Block->CompressedSize == Block->UncompressedSize);
-			memcpy(Buffer, CompressedBlock, Block->CompressedSize);
+			// read compressed data, or use it directly when file is memory-mapped and data is not
+			// decrypted in place (mapping is read-only)
+			byte *CompressedBlock = NULL;
+			FFileReader* FileReader = Reader->CastTo<FFileReader>();
+			if (FileReader && (ChunkHeader.BlockSize == -1 || !appDecompressModifiesInput(UsedCompressionFlags)))
+				CompressedBlock = const_cast<byte*>(FileReader->GetMappedData(ChunkData, Block->CompressedSize));
+			if (!CompressedBlock)
+			{
+				CompressedBlock = CBlockCache::GetScratchBuffer(Block->CompressedSize);
+				Reader->Seek(ChunkData);
+				Reader->Serialize(CompressedBlock, Block->CompressedSize);
+			}
+			// decompress data
+			guard(DecompressBlock);
+			if (ChunkHeader.BlockSize != -1)	// my own mark
+			{
+				// Decompress block
+				appDecompress(CompressedBlock, Block->CompressedSize, Cached->Data, Block->UncompressedSize, UsedCompressionFlags);
+			}
+			else
+			{
+				// No compression
+				assert(Block->CompressedSize == Block->UncompressedSize);
+				memcpy(Cached->Data, CompressedBlock, Block->CompressedSize);
+			}
+			unguardf("block=%X+%X", ChunkData, Block->CompressedSize);
+			CBlockCache::Commit(Cached);
 		}
-		unguardf("block=%X+%X", ChunkData, Block->CompressedSize);
-		// setup BufferStart/BufferEnd
+		assert(Cached->Size == Block->UncompressedSize);
+		CachedBlock = Cached;
+		// setup Buffer/BufferStart/BufferEnd
+		Buffer      = Cached->Data;
 		BufferStart = ChunkPosition;
 		BufferEnd   = ChunkPosition + Block->UncompressedSize;
-		// cleanup
-		delete[] CompressedBlock;
 		unguard;
 	}
 
@@ -213,10 +274,11 @@ public:
 	virtual void Seek(int Pos)
 	{
 		Position = Pos - PositionOffset;
+		UpdateFastWindow();
 	}
 	virtual int Tell() const
 	{
-		return Position + PositionOffset;
+		return Position + PositionOffset + GetFastWindowConsumed();
 	}
 	virtual int GetFileSize() const
 	{
@@ -240,7 +302,9 @@ public:
 	}
 	virtual void SetStopper(int Pos)
 	{
+		Position += ConsumeFastWindow();
 		Stopper = Pos;
+		UpdateFastWindow();
 	}
 	virtual int GetStopper() const
 	{
@@ -259,21 +323,50 @@ public:
 	{
 		guard(FUE3ArchiveReader::Close);
 		Reader->Close();
-		if (Buffer)
-		{
-			delete[] Buffer;
-			Buffer = NULL;
-			BufferStart = BufferEnd = BufferSize = 0;
-		}
+		// Keep decompressed blocks in cache, they're still valid after reopening the file
+		ReleaseBuffer();
 		CurrentChunk = NULL;
 		unguard;
 	}
 
-	void ReplaceLoaderWithOffset(FArchive* file, int offset)
+	void ReplaceLoaderWithOffset(FArchive* file, int offset, const char* NewFileKey)
 	{
 		if (Reader) delete Reader;
 		Reader = file;
 		PositionOffset = offset;
+		// Cached data belongs to the old file
+		ReleaseBuffer();
+		FileKey = appStrdupPool(NewFileKey);
+	}
+
+protected:
+	// Expose the rest of decompressed block as inline read window
+	void UpdateFastWindow()
+	{
+		int End = BufferEnd;
+		if (Stopper > 0 && Stopper < End) End = Stopper;
+		if (Buffer && Position >= BufferStart && Position < End)
+			SetFastWindow(Buffer + Position - BufferStart, End - Position);
+		else
+			ResetFastWindow();
+	}
+
+	void ReleaseBuffer()
+	{
+		Position += ConsumeFastWindow();
+		ResetFastWindow();
+		if (CachedBlock)
+		{
+			CBlockCache::Release(CachedBlock);
+			CachedBlock = NULL;
+		}
+		if (HeaderBuffer)
+		{
+			delete[] HeaderBuffer;
+			HeaderBuffer = NULL;
+		}
+		Buffer = NULL;
+		BufferStart = BufferEnd = 0;
 	}
 };
 
@@ -18,6 +18,8 @@
 
 #include <detex.h>
 
+#include "Parallel.h"
+
 #if 0
 #	define PROFILE_DDS(cmd)		cmd
 #else
@@ -30,21 +32,6 @@
 	Texture decompression
 -----------------------------------------------------------------------------*/
 
-// replaces random 'alpha=0' color with black
-static void PostProcessAlpha(byte *pic, int width, int height)
-{
-	guard(PostProcessAlpha);
-
-	for (int pixelCount = width * height; pixelCount > 0; pixelCount--, pic += 4)
-	{
-		if (pic[3] != 0)	// not completely transparent
-			continue;
-		pic[0] = pic[1] = pic[2] = 0;
-	}
-
-	unguard;
-}
-
 // Some references:
 // https://msdn.microsoft.com/en-us/library/windows/desktop/hh308955.aspx
 // https://msdn.microsoft.com/en-us/library/bb694531.aspx
@@ -103,7 +90,344 @@ bool CTextureData::IsDXT() const
 }
 
 
-byte *CTextureData::Decompress(int MipLevel)
+// Minimal image size which is worth decoding with multiple threads
+#define MIN_PARALLEL_DECODE_PIXELS		(128*128)
+
+// Split the image into horizontal stripes of BlockSizeY-aligned rows, and decode them in parallel.
+// DecodeStripe(Y0, Height) receives a range of pixel rows.
+template<typename F>
+static void DecodeStripes(int USize, int VSize, int BlockSizeY, const F& DecodeStripe)
+{
+	int NumBlockRows = (VSize + BlockSizeY - 1) / BlockSizeY;
+	int NumStripes = 1;
+	if (USize * VSize >= MIN_PARALLEL_DECODE_PIXELS)
+		NumStripes = min(NumBlockRows, appGetNumThreads() * 4);	// several stripes per thread for better balancing
+	if (NumStripes <= 1)
+	{
+		DecodeStripe(0, VSize);
+		return;
+	}
+	int RowsPerStripe = (NumBlockRows + NumStripes - 1) / NumStripes;
+	NumStripes = (NumBlockRows + RowsPerStripe - 1) / RowsPerStripe;
+	ParallelFor(NumStripes, [&](int Stripe)
+		{
+			int Y0 = Stripe * RowsPerStripe * BlockSizeY;
+			int Height = min(RowsPerStripe * BlockSizeY, VSize - Y0);
+			DecodeStripe(Y0, Height);
+		});
+}
+
+// Decode 4x4 block format with detex
+static void DecodeDetex(uint32 DetexFormat, const byte* Data, int USize, int VSize, int BytesPerBlock, byte* Dst, uint32 PixelFormat, int PixelSize)
+{
+	DecodeStripes(USize, VSize, 4, [&](int Y0, int Height)
+		{
+			detexTexture tex;
+			tex.format = DetexFormat;
+			tex.data = const_cast<byte*>(Data + (Y0 / 4) * (USize / 4) * BytesPerBlock);	// will be used as 'const' anyway
+			tex.width = USize;
+			tex.height = Height;
+			tex.width_in_blocks = USize / 4;
+			tex.height_in_blocks = Height / 4;
+			detexDecompressTextureLinear(&tex, Dst + Y0 * USize * PixelSize, PixelFormat);
+		});
+}
+
+/*-----------------------------------------------------------------------------
+	BC1-BC5 (DXT) decompression
+-----------------------------------------------------------------------------*/
+
+// This decoder produces exactly the same output as nvtt's DirectDrawSurface
+// did (including its normalmap reconstruction), but writes pixels directly
+// into the destination RGBA buffer. Transparent BC1 pixels are already black,
+// so the old PostProcessAlpha() pass is not needed anymore. Use CompareDXTDecoders()
+// (the -texverify command) to check it against nvtt.
+
+#ifndef USE_SSE
+#define USE_SSE						1
+#endif
+
+#if USE_SSE
+#include <emmintrin.h>
+#endif
+
+// Build 4-color palette for BC1 color block. Palette entries are RGBA.
+static FORCEINLINE void DecodeColorPalette(const byte* Src, byte Palette[4][4])
+{
+	unsigned c0 = Src[0] | (Src[1] << 8);
+	unsigned c1 = Src[2] | (Src[3] << 8);
+	// expand 5:6:5 to 8:8:8
+	int r0 = (c0 >> 11) & 0x1F, g0 = (c0 >> 5) & 0x3F, b0 = c0 & 0x1F;
+	int r1 = (c1 >> 11) & 0x1F, g1 = (c1 >> 5) & 0x3F, b1 = c1 & 0x1F;
+	r0 = (r0 << 3) | (r0 >> 2); g0 = (g0 << 2) | (g0 >> 4); b0 = (b0 << 3) | (b0 >> 2);
+	r1 = (r1 << 3) | (r1 >> 2); g1 = (g1 << 2) | (g1 >> 4); b1 = (b1 << 3) | (b1 >> 2);
+#if USE_SSE
+	__m128i p01 = _mm_setr_epi16(r0, g0, b0, 255, r1, g1, b1, 255);
+	__m128i p10 = _mm_shuffle_epi32(p01, _MM_SHUFFLE(1, 0, 3, 2));
+	__m128i p23;
+	if (c0 > c1)
+	{
+		// c2 = (2*c0+c1)/3, c3 = (c0+2*c1)/3; (x*21846)>>16 == x/3 for x < 32768
+		p23 = _mm_add_epi16(_mm_add_epi16(p01, p01), p10);
+		p23 = _mm_mulhi_epu16(p23, _mm_set1_epi16(21846));
+	}
+	else
+	{
+		// c2 = (c0+c1)/2, c3 = transparent black
+		p23 = _mm_srli_epi16(_mm_add_epi16(p01, p10), 1);
+		p23 = _mm_and_si128(p23, _mm_setr_epi16(-1, -1, -1, -1, 0, 0, 0, 0));
+	}
+	_mm_storeu_si128((__m128i*)Palette, _mm_packus_epi16(p01, p23));
+#else
+	Palette[0][0] = r0; Palette[0][1] = g0; Palette[0][2] = b0; Palette[0][3] = 255;
+	Palette[1][0] = r1; Palette[1][1] = g1; Palette[1][2] = b1; Palette[1][3] = 255;
+	if (c0 > c1)
+	{
+		Palette[2][0] = (2 * r0 + r1) / 3; Palette[2][1] = (2 * g0 + g1) / 3; Palette[2][2] = (2 * b0 + b1) / 3; Palette[2][3] = 255;
+		Palette[3][0] = (r0 + 2 * r1) / 3; Palette[3][1] = (g0 + 2 * g1) / 3; Palette[3][2] = (b0 + 2 * b1) / 3; Palette[3][3] = 255;
+	}
+	else
+	{
+		Palette[2][0] = (r0 + r1) / 2; Palette[2][1] = (g0 + g1) / 2; Palette[2][2] = (b0 + b1) / 2; Palette[2][3] = 255;
+		Palette[3][0] = Palette[3][1] = Palette[3][2] = Palette[3][3] = 0;
+	}
+#endif // USE_SSE
+}
+
+// Decode BC1 color block into 16 RGBA pixels
+static FORCEINLINE void DecodeColorBlock(const byte* Src, byte Pixels[16][4])
+{
+	byte Palette[4][4];
+	DecodeColorPalette(Src, Palette);
+	unsigned Indices = Src[4] | (Src[5] << 8) | (Src[6] << 16) | (Src[7] << 24);
+	for (int i = 0; i < 16; i++, Indices >>= 2)
+		memcpy(Pixels[i], Palette[Indices & 3], 4);
+}
+
+// Decode BC4 (DXT5 alpha) block into 16 values
+static FORCEINLINE void DecodeAlphaBlock(const byte* Src, byte Values[16])
+{
+	int a0 = Src[0], a1 = Src[1];
+	byte Palette[8];
+#if USE_SSE
+	// Compute all 8 interpolated values at once: (w0*a0 + w1*a1) / N, division is done
+	// with multiplication: (x*9363)>>16 == x/7 and (x*13108)>>16 == x/5 for x < 13107
+	__m128i w0, w1, m;
+	if (a0 > a1)
+	{
+		w0 = _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1);
+		w1 = _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6);
+		m  = _mm_set1_epi16(9363);
+	}
+	else
+	{
+		w0 = _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0);
+		w1 = _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0);
+		m  = _mm_set1_epi16(13108);
+	}
+	__m128i v = _mm_add_epi16(_mm_mullo_epi16(_mm_set1_epi16(a0), w0), _mm_mullo_epi16(_mm_set1_epi16(a1), w1));
+	v = _mm_mulhi_epu16(v, m);
+	_mm_storel_epi64((__m128i*)Palette, _mm_packus_epi16(v, v));
+	if (a0 <= a1)
+	{
+		Palette[6] = 0;
+		Palette[7] = 255;
+	}
+#else
+	Palette[0] = a0;
+	Palette[1] = a1;
+	if (a0 > a1)
+	{
+		for (int i = 1; i < 7; i++)
+			Palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+	}
+	else
+	{
+		for (int i = 1; i < 5; i++)
+			Palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		Palette[6] = 0;
+		Palette[7] = 255;
+	}
+#endif // USE_SSE
+	// 16 3-bit indices
+	uint64 Indices = Src[2] | (Src[3] << 8) | (Src[4] << 16) | ((uint64)Src[5] << 24) | ((uint64)Src[6] << 32) | ((uint64)Src[7] << 40);
+	for (int i = 0; i < 16; i++, Indices >>= 3)
+		Values[i] = Palette[Indices & 7];
+}
+
+// Restore Z component of normal from X (red) and Y (green) channels, the same way as nvtt does
+static FORCEINLINE void RestoreNormalBlock(byte Pixels[16][4])
+{
+#if USE_SSE
+	const __m128 One = _mm_set1_ps(1.0f);
+	const __m128 Two = _mm_set1_ps(2.0f);
+	const __m128 Scale = _mm_set1_ps(255.0f);
+	const __m128i ByteMask = _mm_set1_epi32(0xFF);
+	for (int i = 0; i < 16; i += 4)
+	{
+		__m128i p = _mm_loadu_si128((__m128i*)Pixels[i]);
+		__m128 x = _mm_cvtepi32_ps(_mm_and_si128(p, ByteMask));
+		__m128 y = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), ByteMask));
+		// Keep the order of float operations identical to scalar code to get the same rounding
+		__m128 nx = _mm_sub_ps(_mm_mul_ps(Two, _mm_div_ps(x, Scale)), One);
+		__m128 ny = _mm_sub_ps(_mm_mul_ps(Two, _mm_div_ps(y, Scale)), One);
+		__m128 t = _mm_sub_ps(_mm_sub_ps(One, _mm_mul_ps(nx, nx)), _mm_mul_ps(ny, ny));
+		__m128 nz = _mm_and_ps(_mm_sqrt_ps(t), _mm_cmpgt_ps(t, _mm_setzero_ps()));
+		// z is in 127..255 range, so clamping is not needed
+		__m128i z = _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(Scale, _mm_add_ps(nz, One)), Two));
+		p = _mm_or_si128(_mm_and_si128(p, _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(z, 16));
+		p = _mm_or_si128(p, _mm_set1_epi32(0xFF000000));
+		_mm_storeu_si128((__m128i*)Pixels[i], p);
+	}
+#else
+	for (int i = 0; i < 16; i++)
+	{
+		byte* p = Pixels[i];
+		float nx = 2 * (p[0] / 255.0f) - 1;
+		float ny = 2 * (p[1] / 255.0f) - 1;
+		float nz = 0.0f;
+		if (1 - nx*nx - ny*ny > 0) nz = sqrtf(1 - nx*nx - ny*ny);
+		p[2] = bound(int(255.0f * (nz + 1) / 2.0f), 0, 255);
+		p[3] = 255;
+	}
+#endif // USE_SSE
+}
+
+// Decode BC1-BC5 image. Data points to the first block of the image, Height is not required
+// to be multiple of 4 (partial blocks are clipped).
+static void DecodeDXT(ETexturePixelFormat Format, const byte* Data, int USize, int Height, byte* Dst)
+{
+	int bytesPerBlock = PixelFormatInfo[Format].BytesPerBlock;
+	int blocksPerRow = (USize + 3) / 4;
+	int blockRows = (Height + 3) / 4;
+	byte Pixels[16][4];
+	byte Values[16];
+
+	for (int by = 0; by < blockRows; by++)
+	{
+		int h = min(Height - by * 4, 4);
+		for (int bx = 0; bx < blocksPerRow; bx++, Data += bytesPerBlock)
+		{
+			switch (Format)
+			{
+			case TPF_DXT1:
+				DecodeColorBlock(Data, Pixels);
+				break;
+			case TPF_DXT3:
+				{
+					DecodeColorBlock(Data + 8, Pixels);
+					// 4-bit alpha values
+					for (int i = 0; i < 16; i++)
+					{
+						int a = (Data[i >> 1] >> ((i & 1) * 4)) & 0xF;
+						Pixels[i][3] = (a << 4) | a;
+					}
+				}
+				break;
+			case TPF_DXT5:
+			case TPF_DXT5N:
+				DecodeColorBlock(Data + 8, Pixels);
+				DecodeAlphaBlock(Data, Values);
+				if (Format == TPF_DXT5)
+				{
+					for (int i = 0; i < 16; i++)
+						Pixels[i][3] = Values[i];
+				}
+				else
+				{
+					// Normal's X is stored in alpha
+					for (int i = 0; i < 16; i++)
+						Pixels[i][0] = Values[i];
+					RestoreNormalBlock(Pixels);
+				}
+				break;
+			case TPF_BC4:
+				DecodeAlphaBlock(Data, Values);
+				for (int i = 0; i < 16; i++)
+				{
+					Pixels[i][0] = Pixels[i][1] = Pixels[i][2] = Values[i];
+					Pixels[i][3] = 255;
+				}
+				break;
+			case TPF_BC5:
+				DecodeAlphaBlock(Data, Values);
+				for (int i = 0; i < 16; i++)
+					Pixels[i][0] = Values[i];
+				DecodeAlphaBlock(Data + 8, Values);
+				for (int i = 0; i < 16; i++)
+					Pixels[i][1] = Values[i];
+				// BC5 is always a normal map
+				RestoreNormalBlock(Pixels);
+				break;
+			default:
+				appError("DecodeDXT: unsupported format %s", PixelFormatInfo[Format].Name);
+			}
+
+			// Copy the block to the image, clip it with image bounds
+			int x0 = bx * 4;
+			int w = min(USize - x0, 4);
+			byte* d = Dst + ((by * 4) * USize + x0) * 4;
+			for (int j = 0; j < h; j++, d += USize * 4)
+				memcpy(d, Pixels[j * 4], w * 4);
+		}
+	}
+}
+
+int CompareDXTDecoders(ETexturePixelFormat Format, const byte* Data, int USize, int VSize)
+{
+	guard(CompareDXTDecoders);
+
+	switch (Format)
+	{
+	case TPF_DXT1:
+	case TPF_DXT3:
+	case TPF_DXT5:
+	case TPF_DXT5N:
+	case TPF_BC4:
+	case TPF_BC5:
+		break;
+	default:
+		return -1;
+	}
+
+	TArray<byte> Decoded;
+	Decoded.AddUninitialized(USize * VSize * 4);
+	DecodeDXT(Format, Data, USize, VSize, Decoded.GetData());
+
+	unsigned fourCC = PixelFormatInfo[Format].FourCC;
+	nv::DDSHeader header;
+	nv::Image image;
+	header.setFourCC(fourCC & 0xFF, (fourCC >> 8) & 0xFF, (fourCC >> 16) & 0xFF, (fourCC >> 24) & 0xFF);
+	header.setWidth(USize);
+	header.setHeight(VSize);
+	header.setNormalFlag(Format == TPF_DXT5N || Format == TPF_BC5);
+	DecodeDDS(Data, USize, VSize, header, image);
+
+	int NumMismatches = 0;
+	const byte* s = (byte*)image.pixels();
+	const byte* d = Decoded.GetData();
+	for (int i = 0; i < USize * VSize; i++, s += 4, d += 4)
+	{
+		// nvtt returns BGRA
+		if (d[0] != s[2] || d[1] != s[1] || d[2] != s[0] || d[3] != s[3])
+			NumMismatches++;
+	}
+	return NumMismatches;
+
+	unguardf("fmt=%s %dx%d", PixelFormatInfo[Format].Name, USize, VSize);
+}
+
+
+int CTextureData::GetDecompressedSize(int MipLevel) const
+{
+	if (!Mips.IsValidIndex(MipLevel))
+		return 0;
+	const CMipMap& Mip = Mips[MipLevel];
+	int pixelSize = PixelFormatInfo[Format].Float ? 16 : 4;
+	return Mip.USize * Mip.VSize * pixelSize;
+}
+
+byte *CTextureData::Decompress(int MipLevel, byte* DstBuffer)
 {
 	guard(CTextureData::Decompress);
 
@@ -117,9 +441,8 @@ byte *CTextureData::Decompress(int MipLevel)
 	int VSize = Mip.VSize;
 	const byte *Data = Mip.CompressedData;
 
-	int pixelSize = PixelFormatInfo[Format].Float ? 16 : 4;
-	int size = USize * VSize * pixelSize;
-	byte *dst = new byte [size];
+	int size = GetDecompressedSize(MipLevel);
+	byte *dst = DstBuffer ? DstBuffer : new byte [size];
 
 #if 0
 	{
@@ -142,7 +465,8 @@ byte *CTextureData::Decompress(int MipLevel)
 #endif
 
 	// Process non-dxt formats here. If texture format has FourCC, then it will be
-	// processed by code below this switch.
+	// processed by code below this switch. Most formats are decoded by horizontal stripes
+	// in parallel, see DecodeStripes().
 	switch (Format)
 	{
 	case TPF_P8:
@@ -153,31 +477,36 @@ byte *CTextureData::Decompress(int MipLevel)
 				memset(dst, 0xFF, size);
 				return dst;
 			}
-			byte *d = dst;
-			for (int i = 0; i < USize * VSize; i++)
-			{
-				const FColor &c = Palette->Colors[Data[i]];
-				*d++ = c.R;
-				*d++ = c.G;
-				*d++ = c.B;
-				*d++ = c.A;
-			}
+			DecodeStripes(USize, VSize, 1, [&](int Y0, int Height)
+				{
+					const byte *s = Data + Y0 * USize;
+					byte *d = dst + Y0 * USize * 4;
+					for (int i = 0; i < USize * Height; i++)
+					{
+						const FColor &c = Palette->Colors[s[i]];
+						*d++ = c.R;
+						*d++ = c.G;
+						*d++ = c.B;
+						*d++ = c.A;
+					}
+				});
 		}
 		return dst;
 	case TPF_RGB8:
-		{
-			const byte *s = Data;
-			byte *d = dst;
-			for (int i = 0; i < USize * VSize; i++)
+		DecodeStripes(USize, VSize, 1, [&](int Y0, int Height)
 			{
-				// BGRA -> RGBA
-				*d++ = s[2];
-				*d++ = s[1];
-				*d++ = s[0];
-				*d++ = 255;
-				s += 3;
-			}
-		}
+				const byte *s = Data + Y0 * USize * 3;
+				byte *d = dst + Y0 * USize * 4;
+				for (int i = 0; i < USize * Height; i++)
+				{
+					// BGRA -> RGBA
+					*d++ = s[2];
+					*d++ = s[1];
+					*d++ = s[0];
+					*d++ = 255;
+					s += 3;
+				}
+			});
 		return dst;
 	case TPF_RGBA8:
 		{
@@ -185,86 +514,93 @@ byte *CTextureData::Decompress(int MipLevel)
 		}
 		return dst;
 	case TPF_FLOAT_RGBA:
-		{
-			const uint16 *s = (uint16*)Data;
-			float *d = (float*)dst;
-			for (int i = 0; i < USize * VSize; i++)
+		DecodeStripes(USize, VSize, 1, [&](int Y0, int Height)
 			{
-				*d++ = half2float(*s++);
-				*d++ = half2float(*s++);
-				*d++ = half2float(*s++);
-				*d++ = half2float(*s++);
-			}
-		}
+				const uint16 *s = (uint16*)Data + Y0 * USize * 4;
+				float *d = (float*)dst + Y0 * USize * 4;
+				for (int i = 0; i < USize * Height; i++)
+				{
+					*d++ = half2float(*s++);
+					*d++ = half2float(*s++);
+					*d++ = half2float(*s++);
+					*d++ = half2float(*s++);
+				}
+			});
 		return dst;
 	case TPF_BGRA8:
-		{
-			const byte *s = Data;
-			byte *d = dst;
-			for (int i = 0; i < USize * VSize; i++)
+		DecodeStripes(USize, VSize, 1, [&](int Y0, int Height)
 			{
-				// BGRA -> RGBA
-				*d++ = s[2];
-				*d++ = s[1];
-				*d++ = s[0];
-				*d++ = s[3];
-				s += 4;
-			}
-		}
+				const byte *s = Data + Y0 * USize * 4;
+				byte *d = dst + Y0 * USize * 4;
+				for (int i = 0; i < USize * Height; i++)
+				{
+					// BGRA -> RGBA
+					*d++ = s[2];
+					*d++ = s[1];
+					*d++ = s[0];
+					*d++ = s[3];
+					s += 4;
+				}
+			});
 		return dst;
 	case TPF_RGBA4:
-		{
-			const byte *s = Data;
-			byte *d = dst;
-			for (int i = 0; i < USize * VSize; i++)
+		DecodeStripes(USize, VSize, 1, [&](int Y0, int Height)
 			{
-				byte b1 = s[0];
-				byte b2 = s[1];
-				// BGRA -> RGBA
-				*d++ = b2 & 0xF0;
-				*d++ = (b2 & 0xF) << 4;
-				*d++ = b1 & 0xF0;
-				*d++ = (b1 & 0xF) << 4;
-				s += 2;
-			}
-		}
+				const byte *s = Data + Y0 * USize * 2;
+				byte *d = dst + Y0 * USize * 4;
+				for (int i = 0; i < USize * Height; i++)
+				{
+					byte b1 = s[0];
+					byte b2 = s[1];
+					// BGRA -> RGBA
+					*d++ = b2 & 0xF0;
+					*d++ = (b2 & 0xF) << 4;
+					*d++ = b1 & 0xF0;
+					*d++ = (b1 & 0xF) << 4;
+					s += 2;
+				}
+			});
 		return dst;
 	case TPF_G8:
-		{
-			const byte *s = Data;
-			byte *d = dst;
-			for (int i = 0; i < USize * VSize; i++)
+		DecodeStripes(USize, VSize, 1, [&](int Y0, int Height)
 			{
-				byte b = *s++;
-				*d++ = b;
-				*d++ = b;
-				*d++ = b;
-				*d++ = 255;
-			}
-		}
+				const byte *s = Data + Y0 * USize;
+				byte *d = dst + Y0 * USize * 4;
+				for (int i = 0; i < USize * Height; i++)
+				{
+					byte b = *s++;
+					*d++ = b;
+					*d++ = b;
+					*d++ = b;
+					*d++ = 255;
+				}
+			});
 		return dst;
 	case TPF_V8U8:
 	case TPF_V8U8_2:
 		{
-			const byte *s = Data;
-			byte *d = dst;
 			byte offset = (Format == TPF_V8U8) ? 128 : 0;
-			for (int i = 0; i < USize * VSize; i++)
-			{
-				byte u = *s++ + offset;		// byte + byte -> byte, overflow is normal here
-				byte v = *s++ + offset;
-				d[0] = u;
-				d[1] = v;
-				float uf = (u - offset) / 255.0f * 2 - 1;
-				float vf = (v - offset) / 255.0f * 2 - 1;
-				float t  = 1.0f - uf * uf - vf * vf;
-				if (t >= 0)
-					d[2] = 255 - 255 * appFloor(sqrt(t));	//!! TODO: check for correct function here - should be (t+1.0)*127.5, at least for 'offset==0'
-				else
-					d[2] = 255;
-				d[3] = 255;
-				d += 4;
-			}
+			DecodeStripes(USize, VSize, 1, [&](int Y0, int Height)
+				{
+					const byte *s = Data + Y0 * USize * 2;
+					byte *d = dst + Y0 * USize * 4;
+					for (int i = 0; i < USize * Height; i++)
+					{
+						byte u = *s++ + offset;		// byte + byte -> byte, overflow is normal here
+						byte v = *s++ + offset;
+						d[0] = u;
+						d[1] = v;
+						float uf = (u - offset) / 255.0f * 2 - 1;
+						float vf = (v - offset) / 255.0f * 2 - 1;
+						float t  = 1.0f - uf * uf - vf * vf;
+						if (t >= 0)
+							d[2] = 255 - 255 * appFloor(sqrt(t));	//!! TODO: check for correct function here - should be (t+1.0)*127.5, at least for 'offset==0'
+						else
+							d[2] = 255;
+						d[3] = 255;
+						d += 4;
+					}
+				});
 		}
 		return dst;
 	case TPF_A1:
@@ -274,6 +610,7 @@ byte *CTextureData::Decompress(int MipLevel)
 #if SUPPORT_IPHONE
 	case TPF_PVRTC2:
 	case TPF_PVRTC4:
+		// PVRTC blocks are interpolated with neighbours, so the image can't be split into stripes
 		PROFILE_DDS(appResetProfiler());
 		PVRTDecompressPVRTC(Data, Format == TPF_PVRTC2, USize, VSize, dst);
 		PROFILE_DDS(appPrintProfiler());
@@ -284,51 +621,27 @@ byte *CTextureData::Decompress(int MipLevel)
 	case TPF_ETC1:
 #if 1
 		PROFILE_DDS(appResetProfiler());
-		PVRTDecompressETC(Data, USize, VSize, dst, 0);
+		DecodeStripes(USize, VSize, 4, [&](int Y0, int Height)
+			{
+				PVRTDecompressETC(Data + (Y0 / 4) * ((USize + 3) / 4) * 8, USize, Height, dst + Y0 * USize * 4, 0);
+			});
 		PROFILE_DDS(appPrintProfiler());
 #else
-		{
-			// NOTE: this code works well too
-			detexTexture tex;
-			tex.format = DETEX_TEXTURE_FORMAT_ETC1;
-			tex.data = const_cast<byte*>(Data);	// will be used as 'const' anyway
-			tex.width = USize;
-			tex.height = VSize;
-			tex.width_in_blocks = USize / 4;
-			tex.height_in_blocks = VSize / 4;
-			PROFILE_DDS(appResetProfiler());
-			detexDecompressTextureLinear(&tex, dst, DETEX_PIXEL_FORMAT_RGBA8);
-			PROFILE_DDS(appPrintProfiler());
-		}
+		// NOTE: this code works well too
+		PROFILE_DDS(appResetProfiler());
+		DecodeDetex(DETEX_TEXTURE_FORMAT_ETC1, Data, USize, VSize, 8, dst, DETEX_PIXEL_FORMAT_RGBA8, 4);
+		PROFILE_DDS(appPrintProfiler());
 #endif
 		return dst;
 	case TPF_ETC2_RGB:
-		{
-			detexTexture tex;
-			tex.format = DETEX_TEXTURE_FORMAT_ETC2;
-			tex.data = const_cast<byte*>(Data);	// will be used as 'const' anyway
-			tex.width = USize;
-			tex.height = VSize;
-			tex.width_in_blocks = USize / 4;
-			tex.height_in_blocks = VSize / 4;
-			PROFILE_DDS(appResetProfiler());
-			detexDecompressTextureLinear(&tex, dst, DETEX_PIXEL_FORMAT_RGBA8);
-			PROFILE_DDS(appPrintProfiler());
-		}
+		PROFILE_DDS(appResetProfiler());
+		DecodeDetex(DETEX_TEXTURE_FORMAT_ETC2, Data, USize, VSize, 8, dst, DETEX_PIXEL_FORMAT_RGBA8, 4);
+		PROFILE_DDS(appPrintProfiler());
 		return dst;
 	case TPF_ETC2_RGBA:
-		{
-			detexTexture tex;
-			tex.format = DETEX_TEXTURE_FORMAT_ETC2_EAC;
-			tex.data = const_cast<byte*>(Data);	// will be used as 'const' anyway
-			tex.width = USize;
-			tex.height = VSize;
-			tex.width_in_blocks = USize / 4;
-			tex.height_in_blocks = VSize / 4;
-			PROFILE_DDS(appResetProfiler());
-			detexDecompressTextureLinear(&tex, dst, DETEX_PIXEL_FORMAT_RGBA8);
-			PROFILE_DDS(appPrintProfiler());
-		}
+		PROFILE_DDS(appResetProfiler());
+		DecodeDetex(DETEX_TEXTURE_FORMAT_ETC2_EAC, Data, USize, VSize, 16, dst, DETEX_PIXEL_FORMAT_RGBA8, 4);
+		PROFILE_DDS(appPrintProfiler());
 		return dst;
 	case TPF_ASTC_4x4:
 	case TPF_ASTC_6x6:
@@ -345,49 +658,60 @@ byte *CTextureData::Decompress(int MipLevel)
 			int blockDim = PixelFormatInfo[Format].BlockSizeX;
 			assert(PixelFormatInfo[Format].BlockSizeY == blockDim);
 			int xBlocks = (USize + blockDim - 1) / blockDim;
-			int yBlocks = (VSize + blockDim - 1) / blockDim;
 			const int xdim = blockDim, ydim = blockDim, zdim = 1, z = 0;
 			const astc_decode_mode decode_mode = DECODE_LDR;
 			static const swizzlepattern swz_decode = { 0, 1, 2, 3 };
-			imageblock pb;
+
+			// astc builds some tables for each block size on demand, this is not thread-safe, so do that here
+			get_partition_table(xdim, ydim, zdim, 1);
 
 			astc_codec_image* img = allocate_image(8 /*bitness*/, USize, VSize, 1 /*zsize*/, 0);
 			initialize_image(img);
 
-			for (int y = 0; y < yBlocks; y++)
-			{
-				for (int x = 0; x < xBlocks; x++)
+			// Blocks write to separate image regions, so block rows could be decoded in parallel
+			DecodeStripes(USize, VSize, blockDim, [&](int Y0, int Height)
 				{
-					int offset = ((y * xBlocks) + x) * 16;
-					const byte* bp = Data + offset;
-					physical_compressed_block pcb = *(physical_compressed_block *) bp;
-					symbolic_compressed_block scb;
-					physical_to_symbolic(xdim, ydim, zdim, pcb, &scb);
-					decompress_symbolic_block(decode_mode, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, &scb, &pb);
-					write_imageblock(img, &pb, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, swz_decode);
-				}
-			}
+					imageblock pb;
+					int yBlock0 = Y0 / blockDim;
+					int yBlock1 = (Y0 + Height + blockDim - 1) / blockDim;
+					for (int y = yBlock0; y < yBlock1; y++)
+					{
+						for (int x = 0; x < xBlocks; x++)
+						{
+							int offset = ((y * xBlocks) + x) * 16;
+							const byte* bp = Data + offset;
+							physical_compressed_block pcb = *(physical_compressed_block *) bp;
+							symbolic_compressed_block scb;
+							physical_to_symbolic(xdim, ydim, zdim, pcb, &scb);
+							decompress_symbolic_block(decode_mode, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, &scb, &pb);
+							write_imageblock(img, &pb, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, swz_decode);
+						}
+					}
+				});
 
 			memcpy(dst, img->imagedata8[0][0], size);
 
 			if (isNormalmap)
 			{
 				// UE4 drops blue channel for normal maps before encoding, restore it
-				byte *d = dst;
-				for (int i = 0; i < USize * VSize; i++)
-				{
-					byte u = d[0];
-					byte v = d[1];
-					assert(d[2] == 0);
-					float uf = u / 255.0f * 2 - 1;
-					float vf = v / 255.0f * 2 - 1;
-					float t  = 1.0f - uf * uf - vf * vf;
-					if (t >= 0)
-						d[2] = appFloor((t + 1.0f) * 127.5f);
-					else
-						d[2] = 255;
-					d += 4;
-				}
+				DecodeStripes(USize, VSize, 1, [&](int Y0, int Height)
+					{
+						byte *d = dst + Y0 * USize * 4;
+						for (int i = 0; i < USize * Height; i++)
+						{
+							byte u = d[0];
+							byte v = d[1];
+							assert(d[2] == 0);
+							float uf = u / 255.0f * 2 - 1;
+							float vf = v / 255.0f * 2 - 1;
+							float t  = 1.0f - uf * uf - vf * vf;
+							if (t >= 0)
+								d[2] = appFloor((t + 1.0f) * 127.5f);
+							else
+								d[2] = 255;
+							d += 4;
+						}
+					});
 			}
 
 			destroy_image(img);
@@ -395,33 +719,15 @@ byte *CTextureData::Decompress(int MipLevel)
 		return dst;
 #endif // SUPPORT_ANDROID
 	case TPF_BC6H:
-		{
-			// decompress HDR image as float[w*h*4]
-			detexTexture tex;
-			tex.format = DETEX_TEXTURE_FORMAT_BPTC_FLOAT;
-			tex.data = const_cast<byte*>(Data);
-			tex.width = USize;
-			tex.height = VSize;
-			tex.width_in_blocks = USize / 4;
-			tex.height_in_blocks = VSize / 4;
-			PROFILE_DDS(appResetProfiler());
-			detexDecompressTextureLinear(&tex, dst, DETEX_PIXEL_FORMAT_FLOAT_RGBX32);
-			PROFILE_DDS(appPrintProfiler());
-		}
+		// decompress HDR image as float[w*h*4]
+		PROFILE_DDS(appResetProfiler());
+		DecodeDetex(DETEX_TEXTURE_FORMAT_BPTC_FLOAT, Data, USize, VSize, 16, dst, DETEX_PIXEL_FORMAT_FLOAT_RGBX32, 16);
+		PROFILE_DDS(appPrintProfiler());
 		return dst;
 	case TPF_BC7:
-		{
-			detexTexture tex;
-			tex.format = DETEX_TEXTURE_FORMAT_BPTC;
-			tex.data = const_cast<byte*>(Data);	// will be used as 'const' anyway
-			tex.width = USize;
-			tex.height = VSize;
-			tex.width_in_blocks = USize / 4;
-			tex.height_in_blocks = VSize / 4;
-			PROFILE_DDS(appResetProfiler());
-			detexDecompressTextureLinear(&tex, dst, DETEX_PIXEL_FORMAT_RGBA8);
-			PROFILE_DDS(appPrintProfiler());
-		}
+		PROFILE_DDS(appResetProfiler());
+		DecodeDetex(DETEX_TEXTURE_FORMAT_BPTC, Data, USize, VSize, 16, dst, DETEX_PIXEL_FORMAT_RGBA8, 4);
+		PROFILE_DDS(appPrintProfiler());
 		return dst;
 	case TPF_PNG_BGRA:
 	case TPF_PNG_RGBA:
@@ -443,31 +749,16 @@ byte *CTextureData::Decompress(int MipLevel)
 
 	PROFILE_DDS(appResetProfiler());
 
-	nv::DDSHeader header;
-	nv::Image image;
-	header.setFourCC(fourCC & 0xFF, (fourCC >> 8) & 0xFF, (fourCC >> 16) & 0xFF, (fourCC >> 24) & 0xFF);
-	header.setWidth(USize);
-	header.setHeight(VSize);
-	header.setNormalFlag(Format == TPF_DXT5N || Format == TPF_BC5);	// flag to restore normalmap from 2 colors
-	DecodeDDS(Data, USize, VSize, header, image);
-
-	byte *s = (byte*)image.pixels();
-	byte *d = dst;
-
-	for (int i = 0; i < USize * VSize; i++, s += 4, d += 4)
-	{
-		// BGRA -> RGBA
-		d[0] = s[2];
-		d[1] = s[1];
-		d[2] = s[0];
-		d[3] = s[3];
-	}
+	// DXT blocks are independent, decode them by stripes
+	int bytesPerBlock = PixelFormatInfo[Format].BytesPerBlock;
+	int blocksPerRow = (USize + 3) / 4;
+	DecodeStripes(USize, VSize, 4, [&](int Y0, int Height)
+		{
+			DecodeDXT(Format, Data + (Y0 / 4) * blocksPerRow * bytesPerBlock, USize, Height, dst + Y0 * USize * 4);
+		});
 
 	PROFILE_DDS(appPrintProfiler());
 
-	if (Format == TPF_DXT1)
-		PostProcessAlpha(dst, USize, VSize);	//??
-
 	return dst;
 	unguardf("fmt=%s(%d)", OriginalFormatName, OriginalFormatEnum);
 }
@@ -1,7 +1,9 @@
 #include <png.h>
+#include <zlib.h>
 
 #include "Core.h"
 #include "UnCore.h"
+#include "Parallel.h"
 
 struct PngReadCtx
 {
@@ -10,15 +12,6 @@ struct PngReadCtx
 	int ReadOffset;
 };
 
-struct PngWriteCtx
-{
-	TArray<byte>& CompressedData;
-
-	PngWriteCtx(TArray<byte>& pDst)
-	: CompressedData(pDst)
-	{}
-};
-
 static void user_read_compressed(png_structp png_ptr, png_bytep data, png_size_t length)
 {
 	PngReadCtx* ctx = (PngReadCtx*)png_get_io_ptr(png_ptr);
@@ -30,17 +23,6 @@ static void user_read_compressed(png_structp png_ptr, png_bytep data, png_size_t
 	ctx->ReadOffset += length;
 }
 
-static void user_write_compressed(png_structp png_ptr, png_bytep data, png_size_t length)
-{
-	PngWriteCtx* ctx = (PngWriteCtx*) png_get_io_ptr(png_ptr);
-	int Offset = ctx->CompressedData.AddUninitialized(length);
-	memcpy(ctx->CompressedData.GetData() + Offset, data, length);
-}
-
-static void user_flush_data(png_structp png_ptr)
-{
-}
-
 static void user_error_fn(png_structp png_ptr, png_const_charp error_msg)
 {
 	appError("Error in PNG data: %s", error_msg);
@@ -189,75 +171,282 @@ bool UncompressPNG(const unsigned char* CompressedData, int CompressedSize, int
 	unguard;
 }
 
-void CompressPNG(const unsigned char* pic, int Width, int Height, TArray<byte>& CompressedData)
-{
-	guard(CompressPNG);
+/*-----------------------------------------------------------------------------
+	PNG compression
+-----------------------------------------------------------------------------*/
 
-	int PixelChannels = /*(RawFormat == ERGBFormat::Gray) ? 1 :*/ 3;
+// The image is split into horizontal stripes which are filtered and deflated in parallel
+// as independent raw deflate streams (the same way as pigz does). Every stripe except the
+// last one is terminated with Z_SYNC_FLUSH, so the streams could be simply concatenated
+// into a single zlib stream. Each stripe is primed with the last 32Kb of the previous
+// stripe's data, so compression ratio is almost the same as for a single stream.
 
-	// Verify alpha channels of texture, see the possibility to drop one
-	const unsigned char* p = pic + 3;
-	for (int i = Width * Height; i > 0; i--, p += 4)
+#define PNG_STRIPE_SIZE			(256*1024)		// amount of uncompressed data in a single stripe
+#define PNG_WINDOW_SIZE			32768			// deflate dictionary size
+
+struct CPngStripe
+{
+	TArray<byte>	Filtered;		// filtered rows, preceded by dictionary rows
+	TArray<byte>	Compressed;
+	uint32			Adler;			// adler32 of stripe's data (excluding dictionary)
+	int				DataSize;		// size of stripe's filtered data
+};
+
+struct CPngEncoder
+{
+	const byte*		Pic;			// RGBA image
+	int				Width;
+	int				Height;
+	int				Channels;		// 3 or 4
+	int				RowSize;		// size of filtered row, including filter type byte
+	int				StripeRows;
+	int				NumStripes;
+	int				Level;
+	CPngStripe*		Stripes;
+	int				FirstStripe;	// index of the stripe in Stripes[0]
+
+	// Get pixel row in PNG format (RGB or RGBA). Temp is used when row should be converted.
+	const byte* GetRow(int y, byte* Temp) const
 	{
-		if (*p != 255)
+		const byte* s = Pic + y * Width * 4;
+		if (Channels == 4) return s;
+		byte* d = Temp;
+		for (int i = 0; i < Width; i++, s += 4, d += 3)
 		{
-			PixelChannels = 4;
-			break;
+			d[0] = s[0];
+			d[1] = s[1];
+			d[2] = s[2];
 		}
+		return Temp;
 	}
 
-	unsigned char* newPic = NULL;
-	if (PixelChannels == 3)
+	void FilterRows(int Y0, int NumRows, byte* Dst) const;
+	void CompressStripe(int Index);
+};
+
+static FORCEINLINE int PaethPredictor(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = abs(p - a);
+	int pb = abs(p - b);
+	int pc = abs(p - c);
+	if (pa <= pb && pa <= pc) return a;
+	if (pb <= pc) return b;
+	return c;
+}
+
+// Filter rows [Y0, Y0+NumRows). Filter is selected with the same "minimal sum of absolute
+// differences" heuristic as libpng uses.
+void CPngEncoder::FilterRows(int Y0, int NumRows, byte* Dst) const
+{
+	int Bpp = Channels;
+	int RowBytes = RowSize - 1;
+	TArray<byte> Temp;
+	Temp.AddZeroed(RowBytes * 7);
+	byte* CurTemp  = &Temp[0];
+	byte* PrevTemp = CurTemp + RowBytes;
+	byte* Zero     = PrevTemp + RowBytes;	// previous row for the first image row
+	byte* Filtered = Zero + RowBytes;		// Sub, Up, Average, Paeth
+
+	const byte* Prev = (Y0 > 0) ? GetRow(Y0 - 1, PrevTemp) : Zero;
+	for (int y = Y0; y < Y0 + NumRows; y++, Dst += RowSize)
 	{
-		// Squeeze pixel information if newly allocated memory block
-		newPic = new unsigned char[Width * Height * 3];
-		const unsigned char* s = pic;
-		unsigned char* d = newPic;
-		for (int i = Width * Height; i > 0; i--)
+		const byte* Cur = GetRow(y, CurTemp);
+		if (Level == 0)
 		{
-			*d++ = *s++;
-			*d++ = *s++;
-			*d++ = *s++;
-			s++;
+			// Uncompressed data, don't waste time on filtering
+			Dst[0] = 0;
+			memcpy(Dst + 1, Cur, RowBytes);
 		}
-		pic = newPic;
+		else
+		{
+			unsigned Sum[5] = { 0 };
+			byte* fSub = Filtered;
+			byte* fUp  = fSub + RowBytes;
+			byte* fAvg = fUp + RowBytes;
+			byte* fPae = fAvg + RowBytes;
+#define ADD_SUM(n, v)	{ byte r = v; Sum[n] += abs((signed char)r); }
+#define FILTER_BYTE(i, a, b, c)					\
+			{									\
+				int x = Cur[i];					\
+				ADD_SUM(0, x);					\
+				ADD_SUM(1, fSub[i] = x - a);	\
+				ADD_SUM(2, fUp[i]  = x - b);	\
+				ADD_SUM(3, fAvg[i] = x - ((a + b) >> 1)); \
+				ADD_SUM(4, fPae[i] = x - PaethPredictor(a, b, c)); \
+			}
+			int i;
+			// first pixel has no left neighbour
+			for (i = 0; i < Bpp; i++)
+				FILTER_BYTE(i, 0, Prev[i], 0);
+			for ( ; i < RowBytes; i++)
+				FILTER_BYTE(i, Cur[i - Bpp], Prev[i], Prev[i - Bpp]);
+#undef FILTER_BYTE
+#undef ADD_SUM
+			int Best = 0;
+			for (int f = 1; f < 5; f++)
+			{
+				if (Sum[f] < Sum[Best]) Best = f;
+			}
+			Dst[0] = Best;
+			memcpy(Dst + 1, (Best == 0) ? Cur : Filtered + (Best - 1) * RowBytes, RowBytes);
+		}
+		// Current row becomes previous one; swap temporary buffers if they were used
+		Prev = Cur;
+		Exchange(CurTemp, PrevTemp);
 	}
+}
 
-	PngWriteCtx ctx(CompressedData);
-	ctx.CompressedData.Empty(Width * Height * PixelChannels); // preallocate
+void CPngEncoder::CompressStripe(int Index)
+{
+	guard(CPngEncoder::CompressStripe);
 
-	png_structp png_ptr	= png_create_write_struct(PNG_LIBPNG_VER_STRING, &ctx, user_error_fn, user_warning_fn);
-	assert(png_ptr);
+	int StripeIndex = FirstStripe + Index;
+	CPngStripe& S = Stripes[Index];
 
-	png_infop info_ptr = png_create_info_struct(png_ptr);
-	assert(info_ptr);
+	int Y0 = StripeIndex * StripeRows;
+	int NumRows = min(StripeRows, Height - Y0);
+	// Previous rows used as a dictionary, filter them again instead of waiting for another stripe
+	int DictRows = min(Y0, (PNG_WINDOW_SIZE + RowSize - 1) / RowSize);
 
-	png_bytep* row_pointers = (png_bytep*) png_malloc( png_ptr, Height*sizeof(png_bytep) );
+	S.Filtered.Reset((DictRows + NumRows) * RowSize);
+	S.Filtered.AddUninitialized((DictRows + NumRows) * RowSize);
+	FilterRows(Y0 - DictRows, DictRows + NumRows, S.Filtered.GetData());
 
-	const int RawBitDepth = 8;
-	png_set_compression_level(png_ptr, 1); // zlib compression level: 0 (uncompressed), 1 (fast) - 9 (slow)
-	png_set_IHDR(png_ptr, info_ptr, Width, Height, RawBitDepth, (PixelChannels == 4) ? PNG_COLOR_TYPE_RGBA : PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
-	png_set_write_fn(png_ptr, &ctx, user_write_compressed, user_flush_data);
+	const byte* Data = S.Filtered.GetData() + DictRows * RowSize;
+	S.DataSize = NumRows * RowSize;
+	S.Adler = adler32(adler32(0, NULL, 0), Data, S.DataSize);
 
-	const int BytesPerPixel = (RawBitDepth * PixelChannels) / 8;
-	const int BytesPerRow = BytesPerPixel * Width;
+	z_stream z;
+	memset(&z, 0, sizeof(z));
+	if (deflateInit2(&z, Level, Z_DEFLATED, -MAX_WBITS, 8, (Level > 0) ? Z_FILTERED : Z_DEFAULT_STRATEGY) != Z_OK)
+		appError("deflateInit2 failed");
+	if (DictRows)
+	{
+		int DictSize = min(DictRows * RowSize, PNG_WINDOW_SIZE);
+		deflateSetDictionary(&z, Data - DictSize, DictSize);
+	}
 
-	for (int i = 0; i < Height; i++)
+	// Reserve space for zlib header and sync flush marker
+	int MaxSize = deflateBound(&z, S.DataSize) + 16;
+	S.Compressed.Reset(MaxSize);
+	S.Compressed.AddUninitialized(MaxSize);
+	byte* Dst = S.Compressed.GetData();
+	if (StripeIndex == 0)
 	{
-		row_pointers[i]= (png_bytep)&pic[i * BytesPerRow];
+		// zlib stream header: deflate with 32K window, compression level hint
+		int CMF = 0x78;
+		int FLG = ((Level < 2) ? 0 : (Level < 6) ? 1 : (Level == 6) ? 2 : 3) << 6;
+		FLG += 31 - (CMF * 256 + FLG) % 31;
+		*Dst++ = CMF;
+		*Dst++ = FLG;
 	}
-	png_set_rows(png_ptr, info_ptr, row_pointers);
 
-	int Transform = PNG_TRANSFORM_IDENTITY;
-	png_write_png(png_ptr, info_ptr, Transform, NULL);
+	bool bLast = (StripeIndex == NumStripes - 1);
+	z.next_in = const_cast<byte*>(Data);
+	z.avail_in = S.DataSize;
+	z.next_out = Dst;
+	z.avail_out = MaxSize - (Dst - S.Compressed.GetData());
+	int Result = deflate(&z, bLast ? Z_FINISH : Z_SYNC_FLUSH);
+	if (Result != (bLast ? Z_STREAM_END : Z_OK) || z.avail_in != 0)
+		appError("deflate failed (%d)", Result);
+	S.Compressed.RemoveAt(z.next_out - S.Compressed.GetData(), z.avail_out);
+	deflateEnd(&z);
 
-	png_free(png_ptr, row_pointers);
-	png_destroy_write_struct(&png_ptr, &info_ptr);
+	unguard;
+}
+
+static void WritePngChunk(FArchive& Ar, const char* Type, const byte* Data, int Size)
+{
+	byte Header[8];
+	Header[0] = Size >> 24;
+	Header[1] = (Size >> 16) & 0xFF;
+	Header[2] = (Size >> 8) & 0xFF;
+	Header[3] = Size & 0xFF;
+	memcpy(Header + 4, Type, 4);
+	uint32 Crc = crc32(0, Header + 4, 4);
+	if (Size) Crc = crc32(Crc, Data, Size);
+	byte Footer[4];
+	Footer[0] = Crc >> 24;
+	Footer[1] = (Crc >> 16) & 0xFF;
+	Footer[2] = (Crc >> 8) & 0xFF;
+	Footer[3] = Crc & 0xFF;
+
+	Ar.Serialize(Header, 8);
+	if (Size) Ar.Serialize(const_cast<byte*>(Data), Size);
+	Ar.Serialize(Footer, 4);
+}
+
+void CompressPNG(const unsigned char* pic, int Width, int Height, FArchive& Ar, int Level)
+{
+	guard(CompressPNG);
+
+	int PixelChannels = 3;
+
+	// Verify alpha channels of texture, see the possibility to drop one
+	const unsigned char* p = pic + 3;
+	for (int i = Width * Height; i > 0; i--, p += 4)
+	{
+		if (*p != 255)
+		{
+			PixelChannels = 4;
+			break;
+		}
+	}
 
-	if (newPic)
+	CPngEncoder Enc;
+	Enc.Pic = pic;
+	Enc.Width = Width;
+	Enc.Height = Height;
+	Enc.Channels = PixelChannels;
+	Enc.RowSize = Width * PixelChannels + 1;
+	Enc.StripeRows = max(PNG_STRIPE_SIZE / Enc.RowSize, 1);
+	Enc.NumStripes = (Height + Enc.StripeRows - 1) / Enc.StripeRows;
+	Enc.Level = bound(Level, 0, 9);
+
+	// Signature and header
+	static const byte Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	Ar.Serialize(const_cast<byte*>(Signature), 8);
+
+	byte IHDR[13];
+	IHDR[0] = Width >> 24;  IHDR[1] = (Width >> 16) & 0xFF;  IHDR[2] = (Width >> 8) & 0xFF;  IHDR[3] = Width & 0xFF;
+	IHDR[4] = Height >> 24; IHDR[5] = (Height >> 16) & 0xFF; IHDR[6] = (Height >> 8) & 0xFF; IHDR[7] = Height & 0xFF;
+	IHDR[8] = 8;											// bit depth
+	IHDR[9] = (PixelChannels == 4) ? 6 : 2;					// color type: RGBA or RGB
+	IHDR[10] = IHDR[11] = IHDR[12] = 0;						// compression, filter, interlace
+	WritePngChunk(Ar, "IHDR", IHDR, sizeof(IHDR));
+
+	// Compress stripes by groups, write every group to the archive as soon as it is ready,
+	// so the whole compressed image is never held in memory.
+	int GroupSize = min(appGetNumThreads() * 2, Enc.NumStripes);
+	TArray<CPngStripe> Stripes;
+	Stripes.AddDefaulted(GroupSize);
+	Enc.Stripes = Stripes.GetData();
+
+	uint32 Adler = adler32(0, NULL, 0);
+	for (Enc.FirstStripe = 0; Enc.FirstStripe < Enc.NumStripes; Enc.FirstStripe += GroupSize)
 	{
-		delete[] newPic;
+		int Count = min(GroupSize, Enc.NumStripes - Enc.FirstStripe);
+		ParallelFor(Count, [&Enc](int Index)
+			{
+				Enc.CompressStripe(Index);
+			});
+		for (int i = 0; i < Count; i++)
+		{
+			const CPngStripe& S = Stripes[i];
+			Adler = adler32_combine(Adler, S.Adler, S.DataSize);
+			WritePngChunk(Ar, "IDAT", S.Compressed.GetData(), S.Compressed.Num());
+		}
 	}
 
+	// zlib stream trailer
+	byte Trailer[4];
+	Trailer[0] = Adler >> 24;
+	Trailer[1] = (Adler >> 16) & 0xFF;
+	Trailer[2] = (Adler >> 8) & 0xFF;
+	Trailer[3] = Adler & 0xFF;
+	WritePngChunk(Ar, "IDAT", Trailer, 4);
+	WritePngChunk(Ar, "IEND", NULL, 0);
+
 	unguard;
 }
@@ -2,6 +2,8 @@
 #define __UNTEXTUREPNG_H__
 
 bool UncompressPNG(const unsigned char* CompressedData, int CompressedSize, int Width, int Height, unsigned char* pic, bool bgra);
-void CompressPNG(const unsigned char* pic, int Width, int Height, TArray<byte>& CompressedData);
+// Compress RGBA image and write PNG file to the archive. Level is zlib compression level: 0 (uncompressed),
+// 1 (fast) - 9 (slow). Image is compressed with multiple threads.
+void CompressPNG(const unsigned char* pic, int Width, int Height, FArchive& Ar, int Level = 1);
 
 #endif // __UNTEXTUREPNG_H__
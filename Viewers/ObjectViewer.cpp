@@ -6,6 +6,7 @@
 #include "ObjectViewer.h"
 #include "UnPackage.h"			// for CObjectViewer::Draw2D()
 #include "PackageUtils.h"
+#include "SkeletalMesh.h"		// for DumpAnimSet()
 
 #include "Exporters/Exporters.h"
 
@@ -19,6 +20,43 @@ CObjectViewer::CObjectViewer(UObject* Obj, CApplication *Win)
 }
 
 
+// Decode all sequences of the AnimSet and display decoding statistics
+static void DumpAnimSet(const CAnimSet* Anim)
+{
+	int NumLazySequences = 0;
+	for (int i = 0; i < Anim->Sequences.Num(); i++)
+	{
+		if (Anim->Sequences[i]->DecodeFunc)
+			NumLazySequences++;
+	}
+
+	// sequences which are already in the cache are not decoded again
+	int NumDecodedBefore = Anim->NumDecodedSequences;
+	unsigned StartTime = appMilliseconds();
+	int NumKeys = 0;
+	{
+		CScopedAnimSetTracks Tracks(Anim);
+		for (int i = 0; i < Anim->Sequences.Num(); i++)
+		{
+			const CAnimSequence& Seq = Tracks.Get(i);
+			for (int j = 0; j < Seq.Tracks.Num(); j++)
+			{
+				const CAnimTrack* T = Seq.Tracks[j];
+				NumKeys += T->KeyQuat.Num() + T->KeyPos.Num();
+			}
+		}
+	}
+	int DecodeTime = appMilliseconds() - StartTime;
+
+	appPrintf("\nAnimSet info:\n=============\n");
+	appPrintf("Sequences: %d Tracks: %d Keys: %d\n", Anim->Sequences.Num(), Anim->TrackBoneNames.Num(), NumKeys);
+	if (NumLazySequences)
+	{
+		appPrintf("Decoded %d sequences in %d ms using %d threads\n",
+			Anim->NumDecodedSequences - NumDecodedBefore, DecodeTime, appGetNumThreads());
+	}
+}
+
 void CObjectViewer::Dump()
 {
 	if (Object)
@@ -26,6 +64,9 @@ void CObjectViewer::Dump()
 		appPrintf("\nObject info:\n============\n");
 		appPrintf("ClassName: %s ObjectName: %s\n", Object->GetClassName(), Object->Name);
 		Object->GetTypeinfo()->DumpProps(Object);
+
+		if (const CAnimSet* Anim = GetAnimSet(Object))
+			DumpAnimSet(Anim);
 	}
 }
 
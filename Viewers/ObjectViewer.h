@@ -149,6 +149,9 @@ public:
 
 extern UObject *GForceAnimSet;
 
+// Returns converted animation of UMeshAnimation, UAnimSet or USkeleton object, NULL for other classes
+CAnimSet *GetAnimSet(const UObject *Obj);
+
 class CSkelMeshViewer : public CMeshViewer
 {
 public:
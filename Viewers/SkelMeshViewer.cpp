@@ -39,7 +39,7 @@ TArray<CSkelMeshInstance*> CSkelMeshViewer::TaggedMeshes;
 UObject *GForceAnimSet = NULL;
 
 
-static CAnimSet *GetAnimSet(const UObject *Obj)
+CAnimSet *GetAnimSet(const UObject *Obj)
 {
 	if (Obj->IsA("MeshAnimation"))		// UE1,UE2
 		return static_cast<const UMeshAnimation*>(Obj)->ConvertedAnim;
@@ -926,7 +926,7 @@ void CSkelMeshViewer::FindUE4Animations()
 	progress.SetDescription("Scanning package");
 
 	// Perform full scan to be able to locate AnimSequence objects
-	if (!ScanContent(PackageInfos, &progress))
+	if (!ScanContent(PackageInfos, &progress, /*LoadPackages=*/ true))
 	{
 		appPrintf("Interrupted by user\n");
 		return;